@@ -0,0 +1,146 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "animclock.h"
+
+struct AnimClockEntry {
+    GtkWidget *widget;
+    guint period;           /* In ticks */
+    AnimClockFunc func;     /* NULL when removed during a tick */
+    gpointer data;
+    gulong map_tag;
+};
+
+static GList *anim_clock_entries = NULL;
+static guint anim_clock_tag = 0;
+static guint anim_clock_ticks = 0;
+static gboolean anim_clock_in_tick = FALSE;
+
+static gboolean anim_clock_tick(gpointer handle);
+
+static void anim_clock_free_entry(AnimClockEntry *entry)
+{
+    if (entry->map_tag)
+        g_signal_handler_disconnect(entry->widget, entry->map_tag);
+    g_free(entry);
+}
+
+inline static gboolean anim_clock_entry_is_active(AnimClockEntry *entry)
+{
+    return entry->func && gtk_widget_get_mapped(entry->widget);
+}
+
+static void anim_clock_start(void)
+{
+    if (!anim_clock_tag)
+    {
+        anim_clock_tag = g_timeout_add(ANIM_CLOCK_QUANTUM_MS,
+                anim_clock_tick, NULL);
+    }
+}
+
+static gboolean anim_clock_tick(gpointer handle)
+{
+    GList *link;
+    gboolean active = FALSE;
+
+    (void) handle;
+    ++anim_clock_ticks;
+    anim_clock_in_tick = TRUE;
+    for (link = anim_clock_entries; link; link = link->next)
+    {
+        AnimClockEntry *entry = link->data;
+
+        if (!anim_clock_entry_is_active(entry))
+            continue;
+        if (anim_clock_ticks % entry->period == 0 &&
+                !entry->func(entry->data))
+        {
+            entry->func = NULL;
+        }
+        active = active || anim_clock_entry_is_active(entry);
+    }
+    anim_clock_in_tick = FALSE;
+    /* Entries removed during the tick were only marked */
+    for (link = anim_clock_entries; link; )
+    {
+        GList *next = link->next;
+        AnimClockEntry *entry = link->data;
+
+        if (!entry->func)
+        {
+            anim_clock_free_entry(entry);
+            anim_clock_entries = g_list_delete_link(anim_clock_entries, link);
+        }
+        link = next;
+    }
+    if (!active)
+    {
+        /* Restarted by a new entry or an existing entry's widget being
+         * mapped */
+        anim_clock_tag = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void anim_clock_widget_mapped(GtkWidget *widget, gpointer handle)
+{
+    (void) widget;
+    (void) handle;
+    anim_clock_start();
+}
+
+AnimClockEntry *anim_clock_add(GtkWidget *widget, guint period_ms,
+        AnimClockFunc func, gpointer data)
+{
+    AnimClockEntry *entry = g_new0(AnimClockEntry, 1);
+
+    entry->widget = widget;
+    entry->period = MAX((period_ms + ANIM_CLOCK_QUANTUM_MS - 1) /
+            ANIM_CLOCK_QUANTUM_MS, 1);
+    entry->func = func;
+    entry->data = data;
+    entry->map_tag = g_signal_connect(widget, "map",
+            G_CALLBACK(anim_clock_widget_mapped), NULL);
+    anim_clock_entries = g_list_prepend(anim_clock_entries, entry);
+    if (gtk_widget_get_mapped(widget))
+        anim_clock_start();
+    return entry;
+}
+
+void anim_clock_remove(AnimClockEntry *entry)
+{
+    if (anim_clock_in_tick)
+    {
+        entry->func = NULL;
+        return;
+    }
+    anim_clock_entries = g_list_remove(anim_clock_entries, entry);
+    anim_clock_free_entry(entry);
+    if (!anim_clock_entries && anim_clock_tag)
+    {
+        g_source_remove(anim_clock_tag);
+        anim_clock_tag = 0;
+    }
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,49 @@
+#ifndef ANIMCLOCK_H
+#define ANIMCLOCK_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Drives all the UI's flashing from one timer, so any number of tab labels
+ * and indicators flashing at once only wake the process up once per step and
+ * change together in the same frame. Animations with the same period stay in
+ * phase. The timer only runs while at least one animation's widget is mapped.
+ */
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+/* Periods are rounded up to a multiple of this */
+#define ANIM_CLOCK_QUANTUM_MS 100
+
+typedef struct AnimClockEntry AnimClockEntry;
+
+/* Return FALSE to stop the animation, after which the entry is invalid */
+typedef gboolean (*AnimClockFunc)(gpointer data);
+
+/* func is called every period_ms while widget is mapped */
+AnimClockEntry *anim_clock_add(GtkWidget *widget, guint period_ms,
+        AnimClockFunc func, gpointer data);
+
+/* Safe to call from any AnimClockFunc, including entry's own */
+void anim_clock_remove(AnimClockEntry *entry);
+
+#endif /* ANIMCLOCK_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
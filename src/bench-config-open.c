@@ -0,0 +1,95 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "defns.h"
+
+/* Benchmark for opening the profile editor from roxterm-config.ui, comparing
+ * building every notebook page up front with building only the first page,
+ * which is what profilegui_open does now. It loads the UI with the same
+ * functions as profilegui_open, but without the options. Needs a display.
+ *
+ * Usage: bench-config-open [N_OPENS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "profilegui-ui.h"
+#include "resources.h"
+
+/* Returns the time in microseconds until the dialog has been shown */
+static gint64 bench_open(gboolean all_pages)
+{
+    gint64 t0 = g_get_monotonic_time();
+    gint64 t;
+    GtkBuilder *builder = profilegui_ui_new();
+    GtkWidget *dialog;
+    guint n;
+
+    for (n = 0; n < (all_pages ? PROFILEGUI_UI_N_PAGES : 1); ++n)
+        profilegui_ui_build_page(builder, n);
+    dialog = GTK_WIDGET(gtk_builder_get_object(builder, "Profile_Editor"));
+    gtk_widget_show(dialog);
+    while (gtk_events_pending())
+        gtk_main_iteration();
+    t = g_get_monotonic_time() - t0;
+
+    gtk_widget_destroy(dialog);
+    gtk_widget_destroy(GTK_WIDGET(gtk_builder_get_object(builder,
+            "ssh_dialog")));
+    g_object_unref(builder);
+    while (gtk_events_pending())
+        gtk_main_iteration();
+    return t;
+}
+
+static void bench_report(const char *label, gboolean all_pages, int n_opens)
+{
+    gint64 first = bench_open(all_pages);
+    gint64 total = 0;
+    int n;
+
+    for (n = 1; n < n_opens; ++n)
+        total += bench_open(all_pages);
+    printf("%-12s first %8.2f ms, mean of rest %8.2f ms\n", label,
+            (double) first / 1000.0,
+            n_opens > 1 ? (double) total / 1000.0 / (n_opens - 1) : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    int n_opens;
+
+    if (!gtk_init_check(&argc, &argv))
+    {
+        fprintf(stderr, "bench-config-open needs a display\n");
+        return 77;
+    }
+    n_opens = argc > 1 ? atoi(argv[1]) : 20;
+    if (n_opens < 1)
+        n_opens = 1;
+    resources_access_icon();
+
+    /* The lazy case goes first so that its first open is the cold one */
+    bench_report("first page:", FALSE, n_opens);
+    bench_report("all pages:", TRUE, n_opens);
+    return 0;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,516 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "defns.h"
+
+/* Microbenchmarks for code which doesn't need a display: options lookup,
+ * colour scheme parsing, title templates, geometry strings and the OSC 52
+ * scanner. Options come from in-memory keyfiles and the scanner is fed
+ * synthetic output. Each area's results are checked against known values
+ * first, so an optimisation can't change behaviour without this failing.
+ *
+ * Usage: bench-core [--check] [N_ITERATIONS [MEGABYTES]]
+ *
+ * --check only runs the checks. The exit status is 1 if any check fails.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "colourscheme.h"
+#include "dynopts.h"
+#include "multitab-parse.h"
+#include "options.h"
+#include "osc52scan.h"
+
+static int bench_failures = 0;
+
+static void bench_fail(const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    fputs("FAIL: ", stderr);
+    vfprintf(stderr, format, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    ++bench_failures;
+}
+
+static void bench_report(const char *what, gint64 usec, guint n_ops)
+{
+    printf("%-24s %10.2f ns/op\n", what, (double) usec * 1000.0 / n_ops);
+}
+
+/**********************************************/
+/* Options */
+
+static const char *bench_profile_data =
+    "[roxterm profile]\n"
+    "font=Monospace 11\n"
+    "width=100\n"
+    "height=30\n"
+    "saturation=0.5\n"
+    "colour_scheme=Tango\n"
+    "word_chars=-,./?%&#:_=+@~\n"
+    "title_string=%t. %s\n"
+    "empty=\n";
+
+static Options *bench_options_from_data(const char *family,
+        const char *name, const char *group, const char *data)
+{
+    Options *opts = dynamic_options_lookup_and_ref(dynamic_options_get(family),
+            name, group);
+    GError *error = NULL;
+
+    if (!g_key_file_load_from_data(opts->kf, data, -1, G_KEY_FILE_NONE,
+            &error))
+    {
+        g_error("Unable to load keyfile data: %s", error->message);
+    }
+    return opts;
+}
+
+static void bench_check_string(Options *opts, const char *key,
+        const char *dflt, const char *expected)
+{
+    char *value = options_lookup_string_with_default(opts, key, dflt);
+
+    if (g_strcmp0(value, expected))
+    {
+        bench_fail("option %s is '%s', expected '%s'", key,
+                STR_EMPTY(value), STR_EMPTY(expected));
+    }
+    g_free(value);
+}
+
+static void bench_check_options(Options *opts)
+{
+    bench_check_string(opts, "font", NULL, "Monospace 11");
+    bench_check_string(opts, "word_chars", NULL, "-,./?%&#:_=+@~");
+    bench_check_string(opts, "missing", "dflt", "dflt");
+    bench_check_string(opts, "empty", "dflt", "dflt");
+    /* Falls back to the legacy key */
+    bench_check_string(opts, "colour_scheme_light", NULL, "Tango");
+    if (options_lookup_int(opts, "width") != 100)
+        bench_fail("option width isn't 100");
+    if (options_lookup_int(opts, "missing") != -1)
+        bench_fail("missing int option isn't -1");
+    if (options_lookup_int_with_default(opts, "missing", 42) != 42)
+        bench_fail("missing int option doesn't use default");
+    if (options_lookup_double(opts, "saturation") != 0.5)
+        bench_fail("option saturation isn't 0.5");
+}
+
+static void bench_options(Options *opts, guint n_iter)
+{
+    gint64 t0 = g_get_monotonic_time();
+    guint n;
+    int total = 0;
+
+    for (n = 0; n < n_iter; ++n)
+    {
+        char *s = options_lookup_string(opts, "font");
+
+        total += options_lookup_int(opts, "width");
+        total += options_lookup_int_with_default(opts, "missing", 1);
+        total += s[0];
+        g_free(s);
+    }
+    bench_report("options lookup (x3)", g_get_monotonic_time() - t0, n_iter);
+    if (total != (int) n_iter * (100 + 1 + 'M'))
+        bench_fail("options lookup loop gave wrong total");
+}
+
+/**********************************************/
+/* Colour schemes */
+
+static const char *bench_scheme_data =
+    "[roxterm colour scheme]\n"
+    "palette_size=16\n"
+    "foreground=#c0c0c0\n"
+    "background=#101010\n"
+    "0=#000000\n1=#cd0000\n2=#00cd00\n3=#cdcd00\n"
+    "4=#0000ee\n5=#cd00cd\n6=#00cdcd\n7=#e5e5e5\n"
+    "8=#7f7f7f\n9=#ff0000\n10=#00ff00\n11=#ffff00\n"
+    "12=#5c5cff\n13=rgb(255,0,255)\n14=cyan\n";
+
+static gboolean bench_rgba_is(const GdkRGBA *c, int r, int g, int b)
+{
+    return c && (int) (c->red * 255 + 0.5) == r &&
+        (int) (c->green * 255 + 0.5) == g &&
+        (int) (c->blue * 255 + 0.5) == b && c->alpha == 1.0;
+}
+
+static void bench_check_scheme(Options *scheme)
+{
+    GdkRGBA *palette;
+
+    colour_scheme_reset_cached_data(scheme);
+    palette = colour_scheme_get_palette(scheme);
+    if (colour_scheme_get_palette_size(scheme) != 16)
+        bench_fail("palette size isn't 16");
+    if (!bench_rgba_is(&palette[1], 0xcd, 0, 0))
+        bench_fail("palette entry 1 is wrong");
+    if (!bench_rgba_is(&palette[12], 0x5c, 0x5c, 0xff))
+        bench_fail("palette entry 12 is wrong");
+    if (!bench_rgba_is(&palette[13], 0xff, 0, 0xff))
+        bench_fail("palette entry 13 (rgb()) is wrong");
+    if (!bench_rgba_is(&palette[14], 0, 0xff, 0xff))
+        bench_fail("palette entry 14 (named) is wrong");
+    /* Missing, so uses the default */
+    if (!bench_rgba_is(&palette[15], 0xff, 0xff, 0xff))
+        bench_fail("palette entry 15 doesn't use default");
+    if (!bench_rgba_is(colour_scheme_get_foreground_colour(scheme, TRUE),
+            0xc0, 0xc0, 0xc0))
+    {
+        bench_fail("foreground colour is wrong");
+    }
+    if (colour_scheme_get_cursor_colour(scheme, TRUE))
+        bench_fail("missing cursor colour isn't NULL");
+    if (!bench_rgba_is(colour_scheme_get_cursor_colour(scheme, FALSE),
+            0xcc, 0xcc, 0xcc))
+    {
+        bench_fail("default cursor colour is wrong");
+    }
+}
+
+static void bench_scheme(Options *scheme, guint n_iter)
+{
+    gint64 t0 = g_get_monotonic_time();
+    guint n;
+
+    for (n = 0; n < n_iter; ++n)
+    {
+        colour_scheme_reset_cached_data(scheme);
+        colour_scheme_get_palette(scheme);
+    }
+    bench_report("palette parse", g_get_monotonic_time() - t0, n_iter);
+}
+
+/**********************************************/
+/* Titles */
+
+typedef struct {
+    const char *template;
+    const char *title;
+    const char *process;
+    int tab_num;
+    int tab_count;
+    const char *expected;
+} BenchTitle;
+
+static const BenchTitle bench_titles[] = {
+    { "%s", "Title", NULL, 1, 2, "Title" },
+    { "%t. %s", "vim", NULL, 3, 5, "3. vim" },
+    { "%n tabs %p", NULL, "bash", 1, 4, "4 tabs bash" },
+    { "%s - %p", NULL, NULL, 1, 1, " - " },
+    { "100%%", NULL, NULL, 1, 1, "100%" },
+    { "trailing %", NULL, NULL, 1, 1, "trailing %" },
+    { "%x%", "t", NULL, 1, 1, "%x%" },
+    { "", "t", NULL, 1, 1, "" },
+    { NULL, "t", NULL, 1, 1, "" },
+};
+
+static void bench_check_titles(void)
+{
+    guint n;
+
+    for (n = 0; n < G_N_ELEMENTS(bench_titles); ++n)
+    {
+        const BenchTitle *t = &bench_titles[n];
+        char *title = multi_win_make_title(t->template, t->title, t->process,
+                t->tab_num, t->tab_count);
+
+        if (strcmp(title, t->expected))
+        {
+            bench_fail("title template '%s' gave '%s', expected '%s'",
+                    STR_EMPTY(t->template), title, t->expected);
+        }
+        g_free(title);
+    }
+}
+
+static void bench_titles_render(guint n_iter)
+{
+    gint64 t0 = g_get_monotonic_time();
+    guint n;
+
+    for (n = 0; n < n_iter; ++n)
+    {
+        g_free(multi_win_make_title("%t. %s [%p] (%n)", "user@host: ~/src",
+                "bash", n % 10, 10));
+    }
+    bench_report("title render", g_get_monotonic_time() - t0, n_iter);
+}
+
+/**********************************************/
+/* Geometry */
+
+typedef struct {
+    const char *geom;
+    gboolean ok;
+    int width, height;
+    gboolean xy;
+    int x, y, sign_x, sign_y;
+} BenchGeometry;
+
+static const BenchGeometry bench_geometries[] = {
+    { "80x24", TRUE, 80, 24, FALSE, 0, 0, 0, 0 },
+    { "132X43", TRUE, 132, 43, FALSE, 0, 0, 0, 0 },
+    { "100x40+10+20", TRUE, 100, 40, TRUE, 10, 20, 1, 1 },
+    { "100x40-10-20", TRUE, 100, 40, TRUE, -10, -20, -1, -1 },
+    { "100x40+0-5", TRUE, 100, 40, TRUE, 0, -5, 1, -1 },
+    { "100x40+10", TRUE, 100, 40, FALSE, 10, 0, 1, 0 },
+    { "x24", FALSE, 0, 0, FALSE, 0, 0, 0, 0 },
+    { "80x", FALSE, 80, 0, FALSE, 0, 0, 0, 0 },
+    { "80x24junk", FALSE, 80, 24, FALSE, 0, 0, 0, 0 },
+    { "", FALSE, 0, 0, FALSE, 0, 0, 0, 0 },
+    { "99999999999x1", FALSE, 0, 0, FALSE, 0, 0, 0, 0 },
+};
+
+static void bench_check_geometry(void)
+{
+    guint n;
+
+    for (n = 0; n < G_N_ELEMENTS(bench_geometries); ++n)
+    {
+        const BenchGeometry *g = &bench_geometries[n];
+        int width = 0, height = 0, x = 0, y = 0, sign_x = 0, sign_y = 0;
+        gboolean xy = FALSE;
+        gboolean ok = multi_win_parse_geometry(g->geom, &width, &height,
+                &x, &y, &sign_x, &sign_y, &xy);
+
+        if (ok != g->ok || width != g->width || height != g->height ||
+                xy != g->xy || x != g->x || y != g->y ||
+                sign_x != g->sign_x || sign_y != g->sign_y)
+        {
+            bench_fail("geometry '%s' gave %d %dx%d xy %d %+d%+d (%d %d)",
+                    g->geom, ok, width, height, xy, x, y, sign_x, sign_y);
+        }
+    }
+}
+
+static void bench_geometry(guint n_iter)
+{
+    static const char *geoms[] = {
+        "80x24", "100x40+10+20", "132x43-0+0", "200x60"
+    };
+    gint64 t0 = g_get_monotonic_time();
+    guint n;
+    int width, height, x, y, sign_x, sign_y;
+    gboolean xy;
+    guint n_ok = 0;
+
+    for (n = 0; n < n_iter; ++n)
+    {
+        n_ok += multi_win_parse_geometry(geoms[n % G_N_ELEMENTS(geoms)],
+                &width, &height, &x, &y, &sign_x, &sign_y, &xy);
+    }
+    bench_report("geometry parse", g_get_monotonic_time() - t0, n_iter);
+    if (n_ok != n_iter)
+        bench_fail("geometry parse loop failed");
+}
+
+/**********************************************/
+/* OSC 52 */
+
+typedef struct {
+    const char *name;
+    const char *input;
+    size_t max_buflen;
+    const char *expected[3];
+} BenchOsc52;
+
+static const BenchOsc52 bench_osc52s[] = {
+    { "BEL", "hello \033]52;c;aGVsbG8=\007 world", 100,
+        { "c;aGVsbG8=" } },
+    { "ST", "\033]52;p;Zm9v\033\\", 100, { "p;Zm9v" } },
+    { "8-bit", "\x9d" "52;c;YQ==\x9c", 100, { "c;YQ==" } },
+    { "two", "\033]52;c;YQ==\007text\033]52;s;Yg==\033\\", 100,
+        { "c;YQ==", "s;Yg==" } },
+    { "other OSC", "\033]0;title\007\033]52;c;Yg==\007", 100,
+        { "c;Yg==" } },
+    { "query", "\033]52;c;?\007", 100, { NULL } },
+    { "OSC 5", "\033]5;x\007", 100, { NULL } },
+    { "OSC 520", "\033]520;c;YQ==\007", 100, { NULL } },
+    { "too long", "\033]52;c;AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\007"
+        "\033]52;c;Yw==\007", 16, { "c;Yw==" } },
+    { "interrupted", "\033]52;c;ab\033[0m\007\033]52;c;ZA==\007", 100,
+        { "c;ZA==" } },
+};
+
+static void bench_osc52_collect(guint8 *data, size_t data_len,
+        gpointer handle)
+{
+    GPtrArray *payloads = handle;
+
+    if (strlen((char *) data) != data_len)
+        bench_fail("OSC 52 payload length %zu is wrong", data_len);
+    g_ptr_array_add(payloads, data);
+}
+
+static void bench_check_osc52_case(const BenchOsc52 *c, size_t chunk)
+{
+    GPtrArray *payloads = g_ptr_array_new_with_free_func(g_free);
+    Osc52Scanner scan;
+    size_t len = strlen(c->input);
+    size_t n;
+    guint m;
+
+    osc52scan_init(&scan, c->max_buflen, bench_osc52_collect, payloads);
+    for (n = 0; n < len; n += chunk)
+        osc52scan_feed(&scan, c->input + n, MIN(chunk, len - n));
+    for (m = 0; m < G_N_ELEMENTS(c->expected); ++m)
+    {
+        const char *got = m < payloads->len ?
+            g_ptr_array_index(payloads, m) : NULL;
+
+        if (g_strcmp0(got, c->expected[m]))
+        {
+            bench_fail("OSC 52 '%s' in chunks of %zu: payload %u is '%s', "
+                    "expected '%s'", c->name, chunk, m,
+                    STR_EMPTY(got), STR_EMPTY(c->expected[m]));
+        }
+    }
+    if (payloads->len > G_N_ELEMENTS(c->expected))
+        bench_fail("OSC 52 '%s' gave too many payloads", c->name);
+    osc52scan_reset(&scan);
+    g_ptr_array_free(payloads, TRUE);
+}
+
+static void bench_check_osc52(void)
+{
+    static const size_t chunks[] = { 4096, 1, 2, 3, 7 };
+    guint n, m;
+
+    for (n = 0; n < G_N_ELEMENTS(bench_osc52s); ++n)
+    {
+        for (m = 0; m < G_N_ELEMENTS(chunks); ++m)
+            bench_check_osc52_case(&bench_osc52s[n], chunks[m]);
+    }
+}
+
+static void bench_osc52_count(guint8 *data, size_t data_len, gpointer handle)
+{
+    (void) data_len;
+    ++*(guint *) handle;
+    g_free(data);
+}
+
+/* Mostly coloured text, with a title change every few KB and a copy in each
+ * block */
+static GString *bench_make_output(void)
+{
+    GString *out = g_string_new(NULL);
+    guint n;
+
+    for (n = 0; out->len < 1024 * 1024; ++n)
+    {
+        g_string_append_printf(out, "\033[3%um%06u The quick brown fox "
+                "jumps over the lazy dog \033[0m\r\n", n % 8, n);
+        if (n % 64 == 0)
+            g_string_append_printf(out, "\033]0;title %u\007", n);
+    }
+    g_string_append(out, "\033]52;c;aGVsbG8gd29ybGQ=\033\\");
+    return out;
+}
+
+static void bench_osc52(guint megabytes)
+{
+    GString *out = bench_make_output();
+    Osc52Scanner scan;
+    guint n_copies = 0;
+    gsize total = 0;
+    gsize target = (gsize) megabytes * 1024 * 1024;
+    gint64 t0, t;
+    guint n_blocks = 0;
+
+    osc52scan_init(&scan, 100 * 1024, bench_osc52_count, &n_copies);
+    t0 = g_get_monotonic_time();
+    while (total < target)
+    {
+        gsize n;
+
+        /* Same size as vte's reads */
+        for (n = 0; n < out->len; n += 4096)
+            osc52scan_feed(&scan, out->str + n, MIN(4096, out->len - n));
+        total += out->len;
+        ++n_blocks;
+    }
+    t = g_get_monotonic_time() - t0;
+    printf("%-24s %10.2f MB/s\n", "OSC 52 scan",
+            (double) total / (1024.0 * 1024.0) / ((double) t / 1.0e6));
+    if (n_copies != n_blocks)
+        bench_fail("OSC 52 scan found %u copies in %u blocks",
+                n_copies, n_blocks);
+    osc52scan_reset(&scan);
+    g_string_free(out, TRUE);
+}
+
+/**********************************************/
+
+int main(int argc, char **argv)
+{
+    gboolean check_only = argc > 1 && !strcmp(argv[1], "--check");
+    int arg = check_only ? 2 : 1;
+    guint n_iter = argc > arg ? (guint) atoi(argv[arg]) : 1000000;
+    guint megabytes = argc > arg + 1 ? (guint) atoi(argv[arg + 1]) : 256;
+    Options *profile;
+    Options *scheme;
+
+    /* Make sure no real config files are found */
+    g_setenv("XDG_CONFIG_HOME", "/nonexistent/roxterm-bench-core", TRUE);
+    g_setenv("XDG_CONFIG_DIRS", "/nonexistent/roxterm-bench-core", TRUE);
+    if (!n_iter)
+        n_iter = 1;
+
+    profile = bench_options_from_data("Profiles", "bench-core-profile",
+            "roxterm profile", bench_profile_data);
+    scheme = colour_scheme_lookup_and_ref("bench-core-scheme");
+    if (!g_key_file_load_from_data(scheme->kf, bench_scheme_data, -1,
+            G_KEY_FILE_NONE, NULL))
+    {
+        g_error("Unable to load colour scheme data");
+    }
+
+    bench_check_options(profile);
+    bench_check_scheme(scheme);
+    bench_check_titles();
+    bench_check_geometry();
+    bench_check_osc52();
+    if (bench_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", bench_failures);
+        return 1;
+    }
+    if (check_only)
+        return 0;
+
+    bench_options(profile, n_iter);
+    bench_scheme(scheme, MAX(n_iter / 10, 1));
+    bench_titles_render(n_iter);
+    bench_geometry(n_iter);
+    bench_osc52(megabytes);
+    return bench_failures ? 1 : 0;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,145 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+/* Microbenchmark for checking key presses against a shortcuts scheme,
+ * comparing ShortcutMap with the linear scan it replaced.
+ *
+ * Usage: bench-shortcuts [N_SHORTCUTS [N_LOOKUPS]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "shortcutmap.h"
+
+/* Values of GDK_SHIFT_MASK etc, so that this doesn't need GDK */
+#define BENCH_SHIFT 1
+#define BENCH_CONTROL 4
+#define BENCH_ALT 8
+
+typedef struct {
+    guint key;
+    guint modifiers;
+} BenchKey;
+
+static gboolean bench_linear_contains(GArray *items, guint key,
+        guint modifiers)
+{
+    guint n;
+
+    for (n = 0; n < items->len; ++n)
+    {
+        BenchKey *item = &g_array_index(items, BenchKey, n);
+
+        if (item->key == key && item->modifiers == modifiers)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Roughly what the default scheme looks like: letters and function keys with
+ * Ctrl+Shift, Alt etc */
+static BenchKey bench_make_key(guint n)
+{
+    static const guint mods[] = {
+        BENCH_CONTROL | BENCH_SHIFT, BENCH_ALT, BENCH_CONTROL,
+        BENCH_SHIFT, BENCH_CONTROL | BENCH_ALT
+    };
+    BenchKey k;
+
+    k.key = (n % 2) ? 'a' + n % 26 : 0xffbe + n % 12;
+    k.modifiers = mods[(n / 26) % G_N_ELEMENTS(mods)];
+    return k;
+}
+
+int main(int argc, char **argv)
+{
+    guint n_shortcuts = argc > 1 ? (guint) atoi(argv[1]) : 90;
+    guint n_lookups = argc > 2 ? (guint) atoi(argv[2]) : 10000000;
+    GArray *items = g_array_new(FALSE, FALSE, sizeof(BenchKey));
+    ShortcutMap *map = shortcut_map_new();
+    GArray *presses = g_array_new(FALSE, FALSE, sizeof(BenchKey));
+    guint n;
+    guint hits_linear = 0, hits_map = 0;
+    gint64 t0, t_linear, t_map;
+
+    for (n = 0; n < n_shortcuts; ++n)
+    {
+        BenchKey k = bench_make_key(n);
+
+        g_array_append_val(items, k);
+        shortcut_map_add(map, k.key, k.modifiers);
+    }
+    /* Mostly ordinary typing, which is the common case and a miss */
+    for (n = 0; n < 1024; ++n)
+    {
+        BenchKey k;
+
+        if (n % 16)
+        {
+            k.key = ' ' + n % 95;
+            k.modifiers = (n % 3) ? 0 : BENCH_SHIFT;
+        }
+        else
+        {
+            k = bench_make_key(n * 7 % (n_shortcuts ? n_shortcuts : 1));
+        }
+        g_array_append_val(presses, k);
+    }
+
+    t0 = g_get_monotonic_time();
+    for (n = 0; n < n_lookups; ++n)
+    {
+        BenchKey *k = &g_array_index(presses, BenchKey, n % presses->len);
+
+        hits_linear += bench_linear_contains(items, k->key, k->modifiers);
+    }
+    t_linear = g_get_monotonic_time() - t0;
+
+    t0 = g_get_monotonic_time();
+    for (n = 0; n < n_lookups; ++n)
+    {
+        BenchKey *k = &g_array_index(presses, BenchKey, n % presses->len);
+
+        hits_map += shortcut_map_contains(map, k->key, k->modifiers);
+    }
+    t_map = g_get_monotonic_time() - t0;
+
+    printf("%u shortcuts (%u distinct), %u lookups, %u hits\n",
+            n_shortcuts, shortcut_map_size(map), n_lookups, hits_map);
+    printf("linear scan: %8.2f ns/lookup\n",
+            (double) t_linear * 1000.0 / n_lookups);
+    printf("hash table:  %8.2f ns/lookup\n",
+            (double) t_map * 1000.0 / n_lookups);
+
+    shortcut_map_free(map);
+    g_array_free(presses, TRUE);
+    g_array_free(items, TRUE);
+    if (hits_linear != hits_map)
+    {
+        fprintf(stderr, "Results differ: linear %u, hash table %u\n",
+                hits_linear, hits_map);
+        return 1;
+    }
+    return 0;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -24,33 +24,84 @@
 
 #define COLOURSCHEME_GROUP "roxterm colour scheme"
 
+/* How much brighter than the foreground the bold colour is made when the
+ * scheme doesn't have a palette or bold colour */
+#define COLOUR_SCHEME_BOLD_FACTOR 1.2
+
+/* Every terminal using a scheme shares this, so the scheme's strings are only
+ * parsed once, when it's first used. After that it only changes when the
+ * scheme is edited via the setters below. */
 typedef struct {
-    GdkRGBA *foreground, *background, *cursor, *cursorfg, *bold, *dim;
+    GdkRGBA *foreground, *background, *cursor, *cursorfg, *bold;
     GdkRGBA *palette;
     int palette_size;
+    gboolean parsed;
+    /* Cached colours derived from the above, cleared by edits */
+    gboolean have_extrapolated_bold;
+    GdkRGBA extrapolated_bold;
+    double translucent_alpha;
+    GdkRGBA translucent_background;
 } ColourScheme;
 
+typedef struct {
+    const char *key;
+    const char *default_colour;
+    size_t member_offset;
+} ColourSchemeNamedColour;
+
+typedef enum {
+    COLOUR_SCHEME_CURSOR,
+    COLOUR_SCHEME_CURSORFG,
+    COLOUR_SCHEME_FOREGROUND,
+    COLOUR_SCHEME_BACKGROUND,
+    COLOUR_SCHEME_BOLD,
+    COLOUR_SCHEME_N_NAMED
+} ColourSchemeNamedIndex;
+
+static const ColourSchemeNamedColour colour_scheme_named[] = {
+    { "cursor", "#ccc", offsetof(ColourScheme, cursor) },
+    { "cursorfg", "#000", offsetof(ColourScheme, cursorfg) },
+    { "foreground", "#ccc", offsetof(ColourScheme, foreground) },
+    { "background", "#000", offsetof(ColourScheme, background) },
+    { "bold", "#fff", offsetof(ColourScheme, bold) }
+};
+
 static DynamicOptions *colour_scheme_dynopts = NULL;
 
+#define COLOUR_SCHEME_MEMBER(scheme, n) ((GdkRGBA **) \
+        (((char *) (scheme)) + colour_scheme_named[n].member_offset))
+
+static ColourScheme *new_scheme(void)
+{
+    ColourScheme *scheme = g_new0(ColourScheme, 1);
+
+    scheme->translucent_alpha = -1;
+    return scheme;
+}
+
 static void delete_scheme(ColourScheme *scheme)
 {
-    g_free(scheme->foreground);
-    g_free(scheme->background);
-    g_free(scheme->cursor);
-    g_free(scheme->bold);
-    g_free(scheme->dim);
+    int n;
+
+    for (n = 0; n < COLOUR_SCHEME_N_NAMED; ++n)
+        g_free(*COLOUR_SCHEME_MEMBER(scheme, n));
     g_free(scheme->palette);
     g_free(scheme);
 }
 
+static void colour_scheme_invalidate_derived(ColourScheme *scheme)
+{
+    scheme->have_extrapolated_bold = FALSE;
+    scheme->translucent_alpha = -1;
+}
+
 void colour_scheme_reset_cached_data(Options *opts)
 {
     ColourScheme *scheme = options_get_data(opts);
 
     if (scheme)
         delete_scheme(scheme);
-    scheme = g_new0(ColourScheme, 1);
-    options_associate_data(opts, scheme);
+    options_associate_data(opts, new_scheme());
 }
 
 Options *colour_scheme_lookup_and_ref(const char *scheme_name)
@@ -61,7 +112,9 @@ Options *colour_scheme_lookup_and_ref(const char *scheme_name)
         colour_scheme_dynopts = dynamic_options_get("Colours");
     opts = dynamic_options_lookup_and_ref(colour_scheme_dynopts,
             scheme_name, COLOURSCHEME_GROUP);
-    colour_scheme_reset_cached_data(opts);
+    /* An existing scheme keeps its parsed colours; edits keep them current */
+    if (!options_get_data(opts))
+        options_associate_data(opts, new_scheme());
     return opts;
 }
 
@@ -178,112 +231,214 @@ static void colour_scheme_parse_palette(Options * opts, ColourScheme * scheme)
     colour_scheme_parse_palette_range(opts, scheme, 0, scheme->palette_size);
 }
 
-GdkRGBA *colour_scheme_get_palette(Options * opts)
+/* Named colours that aren't in the scheme are left NULL */
+static void colour_scheme_parse_named_colours(Options *opts,
+        ColourScheme *scheme)
+{
+    int n;
+
+    for (n = 0; n < COLOUR_SCHEME_N_NAMED; ++n)
+    {
+        GdkRGBA **member = COLOUR_SCHEME_MEMBER(scheme, n);
+        GdkRGBA colour;
+
+        g_free(*member);
+        if (colour_scheme_lookup_and_parse(opts, scheme, &colour,
+                    colour_scheme_named[n].key, NULL, TRUE))
+        {
+            *member = g_new(GdkRGBA, 1);
+            **member = colour;
+        }
+        else
+        {
+            *member = NULL;
+        }
+    }
+}
+
+static ColourScheme *colour_scheme_get_parsed(Options *opts)
 {
     ColourScheme *scheme;
 
     g_return_val_if_fail(opts, NULL);
     scheme = options_get_data(opts);
     g_return_val_if_fail(scheme, NULL);
+    if (!scheme->parsed)
+    {
+        colour_scheme_parse_palette(opts, scheme);
+        colour_scheme_parse_named_colours(opts, scheme);
+        colour_scheme_invalidate_derived(scheme);
+        scheme->parsed = TRUE;
+    }
+    return scheme;
+}
 
-    colour_scheme_parse_palette(opts, scheme);
-    return scheme->palette;
+GdkRGBA *colour_scheme_get_palette(Options * opts)
+{
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
+
+    return scheme ? scheme->palette : NULL;
 }
 
 int colour_scheme_get_palette_size(Options * opts)
 {
-    ColourScheme *scheme;
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
 
-    g_return_val_if_fail(opts, 0);
-    scheme = options_get_data(opts);
-    g_return_val_if_fail(scheme, 0);
-
-    colour_scheme_parse_palette(opts, scheme);
-    return scheme->palette_size;
+    return scheme ? scheme->palette_size : 0;
 }
 
-static GdkRGBA *colour_scheme_get_named_colour(Options *opts,
-        const char *name, const char *dflt,
-        size_t member_offset, gboolean allow_null)
+/* Shared by all schemes, so callers mustn't modify the result */
+static GdkRGBA *colour_scheme_get_default_colour(ColourSchemeNamedIndex n)
 {
-    ColourScheme *scheme;
-    GdkRGBA **member;
+    static GdkRGBA defaults[COLOUR_SCHEME_N_NAMED];
+    static gboolean parsed = FALSE;
 
-    g_return_val_if_fail(opts, NULL);
-    scheme = options_get_data(opts);
-    g_return_val_if_fail(scheme, NULL);
-
-    member = (GdkRGBA **) (((char *) scheme) + member_offset);
-    if (!*member)
+    if (!parsed)
     {
-        *member = g_new0(GdkRGBA, 1);
-        if (!colour_scheme_lookup_and_parse(opts, scheme, *member,
-                    name, allow_null ? NULL : dflt, TRUE))
+        int m;
+
+        for (m = 0; m < COLOUR_SCHEME_N_NAMED; ++m)
         {
-            g_free(*member);
-            *member = NULL;
+            gdk_rgba_parse(&defaults[m],
+                    colour_scheme_named[m].default_colour);
         }
+        parsed = TRUE;
     }
-    return *member;
+    return &defaults[n];
+}
+
+static GdkRGBA *colour_scheme_get_named_colour(Options *opts,
+        ColourSchemeNamedIndex n, gboolean allow_null)
+{
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
+    GdkRGBA *colour;
+
+    if (!scheme)
+        return NULL;
+    colour = *COLOUR_SCHEME_MEMBER(scheme, n);
+    if (!colour && !allow_null)
+        colour = colour_scheme_get_default_colour(n);
+    return colour;
 }
 
 GdkRGBA *colour_scheme_get_cursor_colour(Options *opts,
         gboolean allow_null)
 {
-    return colour_scheme_get_named_colour(opts, "cursor", "#ccc",
-            offsetof(ColourScheme, cursor), allow_null);
+    return colour_scheme_get_named_colour(opts, COLOUR_SCHEME_CURSOR,
+            allow_null);
 }
 
 GdkRGBA *colour_scheme_get_cursorfg_colour(Options * opts,
         gboolean allow_null)
 {
-    return colour_scheme_get_named_colour(opts, "cursorfg", "#000",
-            offsetof(ColourScheme, cursorfg), allow_null);
+    return colour_scheme_get_named_colour(opts, COLOUR_SCHEME_CURSORFG,
+            allow_null);
 }
 
 GdkRGBA *colour_scheme_get_foreground_colour(Options * opts,
             gboolean allow_null)
 {
-    return colour_scheme_get_named_colour(opts, "foreground", "#ccc",
-            offsetof(ColourScheme, foreground), allow_null);
+    return colour_scheme_get_named_colour(opts, COLOUR_SCHEME_FOREGROUND,
+            allow_null);
 }
 
 GdkRGBA *colour_scheme_get_background_colour(Options * opts,
         gboolean allow_null)
 {
-    return colour_scheme_get_named_colour(opts, "background", "#000",
-            offsetof(ColourScheme, background), allow_null);
+    return colour_scheme_get_named_colour(opts, COLOUR_SCHEME_BACKGROUND,
+            allow_null);
 }
 
 GdkRGBA *colour_scheme_get_bold_colour(Options * opts,
         gboolean allow_null)
 {
-    return colour_scheme_get_named_colour(opts, "bold", "#fff",
-            offsetof(ColourScheme, bold), allow_null);
+    return colour_scheme_get_named_colour(opts, COLOUR_SCHEME_BOLD,
+            allow_null);
+}
+
+static double extrapolate_chroma(double bg, double fg, double factor)
+{
+    double ext = bg + (fg - bg) * factor;
+
+    return CLAMP(ext, 0, 1);
+}
+
+const GdkRGBA *colour_scheme_get_extrapolated_bold_colour(Options *opts)
+{
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
+
+    if (!scheme || !scheme->foreground)
+        return NULL;
+    if (!scheme->have_extrapolated_bold)
+    {
+        GdkRGBA *fg = scheme->foreground;
+        GdkRGBA *bg = colour_scheme_get_named_colour(opts,
+                COLOUR_SCHEME_BACKGROUND, FALSE);
+        GdkRGBA *ext = &scheme->extrapolated_bold;
+
+#define EXTRAPOLATE(c) ext->c = \
+        extrapolate_chroma(bg->c, fg->c, COLOUR_SCHEME_BOLD_FACTOR)
+        EXTRAPOLATE(red);
+        EXTRAPOLATE(green);
+        EXTRAPOLATE(blue);
+#undef EXTRAPOLATE
+        ext->alpha = 1;
+        scheme->have_extrapolated_bold = TRUE;
+    }
+    return &scheme->extrapolated_bold;
+}
+
+const GdkRGBA *colour_scheme_get_background_colour_with_alpha(Options *opts,
+        double alpha)
+{
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
+
+    if (!scheme)
+        return NULL;
+    if (alpha >= 1)
+        return scheme->background;
+    if (scheme->translucent_alpha != alpha)
+    {
+        scheme->translucent_background = *colour_scheme_get_named_colour(opts,
+                COLOUR_SCHEME_BACKGROUND, FALSE);
+        scheme->translucent_background.alpha = alpha;
+        scheme->translucent_alpha = alpha;
+    }
+    return &scheme->translucent_background;
 }
 
 void colour_scheme_set_palette_size(Options * opts, int size)
 {
-    ColourScheme *scheme;
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
 
-    g_return_if_fail(opts);
-    scheme = options_get_data(opts);
     g_return_if_fail(scheme);
     scheme->palette_size = size;
+    options_set_int(opts, "palette_size", size);
+    colour_scheme_invalidate_derived(scheme);
 }
 
 static void colour_scheme_set_colour(Options *opts, ColourScheme *scheme,
         GdkRGBA **colour, const char *key, const char *colour_name)
 {
-    if (!*colour)
-        *colour = g_new(GdkRGBA, 1);
-    if (!colour_name || colour_scheme_parse(scheme, *colour, colour_name))
-        options_set_string(opts, key, colour_name);
+    GdkRGBA parsed;
+
     if (!colour_name)
     {
         g_free(*colour);
         *colour = NULL;
     }
+    else if (colour_scheme_parse(scheme, &parsed, colour_name))
+    {
+        if (!*colour)
+            *colour = g_new(GdkRGBA, 1);
+        **colour = parsed;
+    }
+    else
+    {
+        return;
+    }
+    options_set_string(opts, key, colour_name);
+    colour_scheme_invalidate_derived(scheme);
 }
 
 void colour_scheme_set_palette_entry(Options * opts, int index,
@@ -293,10 +448,9 @@ void colour_scheme_set_palette_entry(Options * opts, int index,
     char key[8];
     GdkRGBA *colour;
 
-    g_return_if_fail(opts);
     g_return_if_fail(colour_name);
     g_return_if_fail(index >= 0 && index < 16);
-    scheme = options_get_data(opts);
+    scheme = colour_scheme_get_parsed(opts);
     g_return_if_fail(scheme);
     colour = &scheme->palette[index];
 	snprintf(key, sizeof(key) - 1, "%d", index);
@@ -304,51 +458,43 @@ void colour_scheme_set_palette_entry(Options * opts, int index,
 }
 
 static void colour_scheme_set_named_colour(Options *opts,
-        const char *field_name,
-        const char *colour_name, size_t member_offset)
+        ColourSchemeNamedIndex n, const char *colour_name)
 {
-    ColourScheme *scheme;
-    GdkRGBA **member;
+    ColourScheme *scheme = colour_scheme_get_parsed(opts);
 
-    g_return_if_fail(opts);
-    scheme = options_get_data(opts);
     g_return_if_fail(scheme);
-    member = (GdkRGBA **) (((char *) scheme) + member_offset);
-    colour_scheme_set_colour(opts, scheme, member,
-            field_name, colour_name);
+    colour_scheme_set_colour(opts, scheme, COLOUR_SCHEME_MEMBER(scheme, n),
+            colour_scheme_named[n].key, colour_name);
 }
 
 void colour_scheme_set_cursor_colour(Options * opts, const char *colour_name)
 {
-    colour_scheme_set_named_colour(opts, "cursor", colour_name,
-            offsetof(ColourScheme, cursor));
+    colour_scheme_set_named_colour(opts, COLOUR_SCHEME_CURSOR, colour_name);
 }
 
 void colour_scheme_set_cursorfg_colour(Options * opts, const char *colour_name)
 {
-    colour_scheme_set_named_colour(opts, "cursorfg", colour_name,
-            offsetof(ColourScheme, cursorfg));
+    colour_scheme_set_named_colour(opts, COLOUR_SCHEME_CURSORFG, colour_name);
 }
 
 void colour_scheme_set_foreground_colour(Options * opts,
         const char *colour_name)
 {
-    colour_scheme_set_named_colour(opts, "foreground", colour_name,
-            offsetof(ColourScheme, foreground));
+    colour_scheme_set_named_colour(opts, COLOUR_SCHEME_FOREGROUND,
+            colour_name);
 }
 
 void colour_scheme_set_background_colour(Options * opts,
         const char *colour_name)
 {
-    colour_scheme_set_named_colour(opts, "background", colour_name,
-            offsetof(ColourScheme, background));
+    colour_scheme_set_named_colour(opts, COLOUR_SCHEME_BACKGROUND,
+            colour_name);
 }
 
 void colour_scheme_set_bold_colour(Options * opts,
         const char *colour_name)
 {
-    colour_scheme_set_named_colour(opts, "bold", colour_name,
-            offsetof(ColourScheme, bold));
+    colour_scheme_set_named_colour(opts, COLOUR_SCHEME_BOLD, colour_name);
 }
 
 /* vi:set sw=4 ts=4 et cindent cino= */
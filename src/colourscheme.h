@@ -50,6 +50,15 @@ GdkRGBA *colour_scheme_get_foreground_colour(Options * opts,
 GdkRGBA *colour_scheme_get_background_colour(Options * opts,
         gboolean allow_null);
 
+/* Bold colour for schemes without a palette, a brighter version of the
+ * foreground. NULL if the scheme has no foreground. */
+const GdkRGBA *colour_scheme_get_extrapolated_bold_colour(Options *opts);
+
+/* The background colour with the given alpha. If alpha is 1 the result is the
+ * same as colour_scheme_get_background_colour(opts, TRUE). */
+const GdkRGBA *colour_scheme_get_background_colour_with_alpha(Options *opts,
+        double alpha);
+
 void colour_scheme_set_palette_size(Options * opts, int size);
 
 void colour_scheme_set_palette_entry(Options * opts, int index,
@@ -68,6 +77,7 @@ void colour_scheme_set_foreground_colour(Options * opts,
 void colour_scheme_set_background_colour(Options * opts,
 		const char *colour_name);
 
+/* Discards the parsed colours after the options have been replaced */
 void colour_scheme_reset_cached_data(Options *opts);
 
 #endif /* COLOURSCHEME_H */
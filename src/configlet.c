@@ -960,7 +960,8 @@ gboolean configlet_open()
     }
     else
     {
-        static char const *build_objs[] = { "Configlet", NULL };
+        static char const *build_objs[] = { "Configlet",
+                "scrollback_budget_adjustment", NULL };
         ConfigletData *cg = configlet_data = g_new0(ConfigletData, 1);
         GError *error = NULL;
 
@@ -1003,6 +1004,7 @@ gboolean configlet_open()
 
         capplet_set_radio(&cg->capp, "warn_close", 3);
         capplet_set_boolean_toggle(&cg->capp, "only_warn_running", FALSE);
+        capplet_set_spin_button(&cg->capp, "scrollback_budget", 0);
 
         const char *hide_widget = NULL;
         if (!global_options_has_gtk_dark_theme_setting())
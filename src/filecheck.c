@@ -0,0 +1,250 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+
+#include "filecheck.h"
+
+/* How long a result is trusted */
+#define FILE_CHECK_TTL (5 * G_USEC_PER_SEC)
+
+/* Expired results are pruned when there are more than this many */
+#define FILE_CHECK_MAX_ENTRIES 256
+
+#define FILE_CHECK_THREADS 4
+
+/* How long a handler waits for a check before it's given up */
+#define FILE_CHECK_WAIT (3 * G_USEC_PER_SEC)
+
+typedef struct {
+    FileCheckHandler handler;
+    gpointer data;
+    gint64 deadline;
+} FileCheckWaiter;
+
+typedef struct {
+    FileCheckResult result;
+    gint64 checked;         /* Monotonic time of result */
+    GArray *waiters;        /* FileCheckWaiter, NULL unless in progress */
+} FileCheckEntry;
+
+typedef struct {
+    char *path;
+    gboolean exists;
+} FileCheckJob;
+
+static GHashTable *file_check_cache = NULL;    /* path -> FileCheckEntry */
+static GThreadPool *file_check_pool = NULL;
+static guint file_check_expire_tag = 0;
+
+static void file_check_entry_free(FileCheckEntry *entry)
+{
+    if (entry->waiters)
+        g_array_free(entry->waiters, TRUE);
+    g_free(entry);
+}
+
+static gboolean file_check_deliver(gpointer handle)
+{
+    FileCheckJob *job = handle;
+    FileCheckEntry *entry = g_hash_table_lookup(file_check_cache, job->path);
+    GArray *waiters;
+    guint n;
+
+    if (entry)
+    {
+        entry->result = job->exists ? FILE_CHECK_EXISTS : FILE_CHECK_MISSING;
+        entry->checked = g_get_monotonic_time();
+        waiters = entry->waiters;
+        entry->waiters = NULL;
+        for (n = 0; waiters && n < waiters->len; ++n)
+        {
+            FileCheckWaiter *w = &g_array_index(waiters, FileCheckWaiter, n);
+
+            w->handler(job->path, entry->result, w->data);
+        }
+        if (waiters)
+            g_array_free(waiters, TRUE);
+    }
+    g_free(job->path);
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+static void file_check_worker(gpointer data, gpointer user_data)
+{
+    FileCheckJob *job = data;
+    GStatBuf info;
+
+    (void) user_data;
+    job->exists = g_stat(job->path, &info) == 0;
+    g_idle_add(file_check_deliver, job);
+}
+
+/* Handlers that have waited too long are called with FILE_CHECK_UNKNOWN.
+ * They're collected first, because a handler might start another check,
+ * which could prune the cache.
+ */
+static gboolean file_check_expire(gpointer handle)
+{
+    gint64 now = g_get_monotonic_time();
+    GArray *expired = g_array_new(FALSE, FALSE, sizeof(FileCheckWaiter));
+    GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+    gboolean waiting = FALSE;
+    GHashTableIter iter;
+    gpointer key, value;
+    guint n;
+
+    (void) handle;
+    g_hash_table_iter_init(&iter, file_check_cache);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        FileCheckEntry *entry = value;
+
+        for (n = 0; entry->waiters && n < entry->waiters->len; )
+        {
+            FileCheckWaiter *w = &g_array_index(entry->waiters,
+                    FileCheckWaiter, n);
+
+            if (now >= w->deadline)
+            {
+                g_array_append_val(expired, *w);
+                g_ptr_array_add(paths, g_strdup(key));
+                g_array_remove_index(entry->waiters, n);
+            }
+            else
+            {
+                waiting = TRUE;
+                ++n;
+            }
+        }
+    }
+    if (!waiting)
+        file_check_expire_tag = 0;
+    for (n = 0; n < expired->len; ++n)
+    {
+        FileCheckWaiter *w = &g_array_index(expired, FileCheckWaiter, n);
+
+        w->handler(g_ptr_array_index(paths, n), FILE_CHECK_UNKNOWN, w->data);
+    }
+    g_array_free(expired, TRUE);
+    g_ptr_array_free(paths, TRUE);
+    return waiting ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static void file_check_prune(gint64 now)
+{
+    GHashTableIter iter;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, file_check_cache);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        FileCheckEntry *entry = value;
+
+        if (!entry->waiters && now - entry->checked > FILE_CHECK_TTL)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
+FileCheckResult file_check(const char *path, const char *dir,
+        FileCheckHandler handler, gpointer data)
+{
+    char *cwd = NULL;
+    char *abs_path;
+    gint64 now = g_get_monotonic_time();
+    FileCheckEntry *entry;
+    FileCheckJob *job;
+
+    if (g_path_is_absolute(path))
+    {
+        abs_path = g_strdup(path);
+    }
+    else
+    {
+        if (!dir)
+            dir = cwd = g_get_current_dir();
+        abs_path = g_build_filename(dir, path, NULL);
+        g_free(cwd);
+    }
+    if (!file_check_cache)
+    {
+        file_check_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+                g_free, (GDestroyNotify) file_check_entry_free);
+        file_check_pool = g_thread_pool_new(file_check_worker, NULL,
+                FILE_CHECK_THREADS, FALSE, NULL);
+    }
+    entry = g_hash_table_lookup(file_check_cache, abs_path);
+    if (entry && !entry->waiters && now - entry->checked <= FILE_CHECK_TTL)
+    {
+        g_free(abs_path);
+        return entry->result;
+    }
+    if (!entry)
+    {
+        if (g_hash_table_size(file_check_cache) >= FILE_CHECK_MAX_ENTRIES)
+            file_check_prune(now);
+        entry = g_new0(FileCheckEntry, 1);
+        g_hash_table_insert(file_check_cache, g_strdup(abs_path), entry);
+    }
+    if (!entry->waiters)
+    {
+        entry->result = FILE_CHECK_UNKNOWN;
+        entry->waiters = g_array_new(FALSE, FALSE, sizeof(FileCheckWaiter));
+        job = g_new(FileCheckJob, 1);
+        job->path = g_strdup(abs_path);
+        job->exists = FALSE;
+        g_thread_pool_push(file_check_pool, job, NULL);
+    }
+    if (handler)
+    {
+        FileCheckWaiter w = { handler, data, now + FILE_CHECK_WAIT };
+        FileCheckWaiter old = { NULL, NULL, 0 };
+        guint n;
+
+        /* A repeated request supersedes the one already waiting */
+        for (n = 0; n < entry->waiters->len; ++n)
+        {
+            FileCheckWaiter *ew = &g_array_index(entry->waiters,
+                    FileCheckWaiter, n);
+
+            if (ew->handler == handler)
+            {
+                old = *ew;
+                *ew = w;
+                break;
+            }
+        }
+        if (!old.handler)
+            g_array_append_val(entry->waiters, w);
+        if (!file_check_expire_tag)
+        {
+            file_check_expire_tag = g_timeout_add_seconds(1,
+                    file_check_expire, NULL);
+        }
+        if (old.handler)
+            old.handler(abs_path, FILE_CHECK_UNKNOWN, old.data);
+    }
+    g_free(abs_path);
+    return FILE_CHECK_UNKNOWN;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,52 @@
+#ifndef FILECHECK_H
+#define FILECHECK_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Checks whether files exist in a thread pool so that a slow or hung
+ * network filesystem can't block the UI. Results are cached for a few
+ * seconds. Everything except the stat itself happens in the main thread.
+ */
+
+#include <glib.h>
+
+typedef enum {
+    FILE_CHECK_UNKNOWN,     /* A check is in progress */
+    FILE_CHECK_EXISTS,
+    FILE_CHECK_MISSING
+} FileCheckResult;
+
+/* path is the absolute path that was checked */
+typedef void (*FileCheckHandler)(const char *path, FileCheckResult result,
+        gpointer data);
+
+/* path may be relative to dir, which may be NULL to use roxterm's own cwd.
+ * If the result is cached it's returned and handler isn't called. Otherwise
+ * a check is started, if one isn't already in progress, and the result is
+ * FILE_CHECK_UNKNOWN; handler, if not NULL, is called when it completes.
+ * The handler is always called exactly once, with FILE_CHECK_UNKNOWN if the
+ * check takes more than a few seconds or if the same handler is passed
+ * again for the same path before it completes.
+ */
+FileCheckResult file_check(const char *path, const char *dir,
+        FileCheckHandler handler, gpointer data);
+
+#endif /* FILECHECK_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
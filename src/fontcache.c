@@ -0,0 +1,156 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "fontcache.h"
+
+struct FontCacheEntry {
+    char *key;
+    char *spec;
+    double zoom;
+    PangoFontDescription *desc;
+    guint refs;
+    int cell_width, cell_height;    /* 0 until measured */
+    double width_scale, height_scale;
+    int scale_factor;
+};
+
+static GHashTable *font_cache = NULL;   /* key -> FontCacheEntry */
+
+/* Zoom factors are keyed to the nearest thousandth so that values which
+ * have been through arithmetic or a session file still match */
+static char *font_cache_make_key(const char *spec, double zoom)
+{
+    return g_strdup_printf("%ld:%s", (long) (zoom * 1000.0 + 0.5), spec);
+}
+
+static void font_cache_resize_for_zoom(PangoFontDescription *desc,
+        double zoom)
+{
+    int size;
+    gboolean abs = FALSE;
+
+    if (zoom == 1.0)
+        return;
+    size = pango_font_description_get_size(desc);
+    if (!size)
+        size = 10 * PANGO_SCALE;
+    else
+        abs = pango_font_description_get_size_is_absolute(desc);
+    size = (int) ((double) size * zoom);
+    if (abs)
+        pango_font_description_set_absolute_size(desc, size);
+    else
+        pango_font_description_set_size(desc, size);
+}
+
+FontCacheEntry *font_cache_lookup(const char *spec, double zoom)
+{
+    char *key = font_cache_make_key(spec, zoom);
+    FontCacheEntry *entry;
+    PangoFontDescription *desc;
+
+    if (!font_cache)
+        font_cache = g_hash_table_new(g_str_hash, g_str_equal);
+    entry = g_hash_table_lookup(font_cache, key);
+    if (entry)
+    {
+        g_free(key);
+        return font_cache_entry_ref(entry);
+    }
+    desc = pango_font_description_from_string(spec);
+    if (!desc)
+    {
+        g_warning(_("Couldn't create a font from '%s'"), spec);
+        g_free(key);
+        return NULL;
+    }
+    /* Always scaled from the unzoomed font so repeated zooming can't
+     * accumulate rounding errors */
+    font_cache_resize_for_zoom(desc, zoom);
+    entry = g_new0(FontCacheEntry, 1);
+    entry->key = key;
+    entry->spec = g_strdup(spec);
+    entry->zoom = zoom;
+    entry->desc = desc;
+    entry->refs = 1;
+    g_hash_table_insert(font_cache, key, entry);
+    return entry;
+}
+
+FontCacheEntry *font_cache_entry_ref(FontCacheEntry *entry)
+{
+    ++entry->refs;
+    return entry;
+}
+
+void font_cache_entry_unref(FontCacheEntry *entry)
+{
+    if (--entry->refs)
+        return;
+    g_hash_table_remove(font_cache, entry->key);
+    pango_font_description_free(entry->desc);
+    g_free(entry->spec);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+const char *font_cache_entry_get_spec(FontCacheEntry *entry)
+{
+    return entry->spec;
+}
+
+double font_cache_entry_get_zoom(FontCacheEntry *entry)
+{
+    return entry->zoom;
+}
+
+const PangoFontDescription *font_cache_entry_get_desc(FontCacheEntry *entry)
+{
+    return entry->desc;
+}
+
+gboolean font_cache_entry_get_cell_size(FontCacheEntry *entry,
+        double width_scale, double height_scale, int scale_factor,
+        int *width, int *height)
+{
+    if (!entry->cell_width || entry->width_scale != width_scale ||
+            entry->height_scale != height_scale ||
+            entry->scale_factor != scale_factor)
+    {
+        return FALSE;
+    }
+    *width = entry->cell_width;
+    *height = entry->cell_height;
+    return TRUE;
+}
+
+void font_cache_entry_set_cell_size(FontCacheEntry *entry,
+        double width_scale, double height_scale, int scale_factor,
+        int width, int height)
+{
+    entry->width_scale = width_scale;
+    entry->height_scale = height_scale;
+    entry->scale_factor = scale_factor;
+    entry->cell_width = width;
+    entry->cell_height = height;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
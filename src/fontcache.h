@@ -0,0 +1,63 @@
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Fonts are shared by every terminal using the same font at the same zoom
+ * factor, so zooming many tabs only builds each font description once. Each
+ * entry also remembers the cell size VTE measured for it, so window geometry
+ * can be worked out without asking a terminal to measure its font again.
+ */
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+typedef struct FontCacheEntry FontCacheEntry;
+
+/* Returns a new reference to the entry for spec (a Pango font description
+ * string) scaled by zoom, or NULL if spec isn't a valid font */
+FontCacheEntry *font_cache_lookup(const char *spec, double zoom);
+
+FontCacheEntry *font_cache_entry_ref(FontCacheEntry *entry);
+
+void font_cache_entry_unref(FontCacheEntry *entry);
+
+/* The unzoomed font */
+const char *font_cache_entry_get_spec(FontCacheEntry *entry);
+
+double font_cache_entry_get_zoom(FontCacheEntry *entry);
+
+const PangoFontDescription *font_cache_entry_get_desc(FontCacheEntry *entry);
+
+/* The cell size also depends on VTE's cell scale (spacing) and the display's
+ * scale factor, so it's only returned if those match the values it was
+ * measured with. Returns FALSE if it isn't known.
+ */
+gboolean font_cache_entry_get_cell_size(FontCacheEntry *entry,
+        double width_scale, double height_scale, int scale_factor,
+        int *width, int *height);
+
+void font_cache_entry_set_cell_size(FontCacheEntry *entry,
+        double width_scale, double height_scale, int scale_factor,
+        int width, int height);
+
+#endif /* FONTCACHE_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -22,21 +22,28 @@
 #include <errno.h>
 #include <stdio.h>
 #include <locale.h>
+#include <signal.h>
 #include <unistd.h>
 
 #include <gdk/gdk.h>
+#include <glib-unix.h>
 
 #include "dlg.h"
 #include "globalopts.h"
 #include "multitab.h"
+#include "outputlog.h"
 #include "roxterm.h"
 #include "rtdbus.h"
 #include "session-file.h"
+#include "tracepoint.h"
 
 #define ROXTERM_DBUS_NAME RTDBUS_NAME ".term"
 #define ROXTERM_DBUS_OBJECT_PATH RTDBUS_OBJECT_PATH "/term"
 #define ROXTERM_DBUS_INTERFACE RTDBUS_INTERFACE
 #define ROXTERM_DBUS_METHOD_NAME "NewTerminal"
+#define ROXTERM_DBUS_MEMORY_METHOD "GetMemoryUsage"
+#define ROXTERM_DBUS_SET_TRACING_METHOD "SetTracing"
+#define ROXTERM_DBUS_DUMP_TRACE_METHOD "DumpTrace"
 
 extern char **environ;
 
@@ -122,6 +129,125 @@ static int run_via_dbus(DBusMessage *message)
     return result;
 }
 
+/* Optional arg is a ROXTERM_ID; without it the reply describes the whole
+ * process */
+static DBusHandlerResult get_memory_usage(DBusConnection *connection,
+        DBusMessage *message)
+{
+    DBusError derror;
+    DBusMessage *reply;
+    const char *id_str = NULL;
+    ROXTermData *roxterm = NULL;
+    char *report;
+
+    dbus_error_init(&derror);
+    if (!dbus_message_get_args(message, &derror,
+            DBUS_TYPE_STRING, &id_str, DBUS_TYPE_INVALID))
+    {
+        dbus_error_free(&derror);
+        id_str = NULL;
+    }
+    if (id_str && id_str[0])
+    {
+        void *id = NULL;
+
+        if (sscanf(id_str, "%p", &id) == 1)
+            roxterm = roxterm_from_id(GPOINTER_TO_SIZE(id));
+        if (!roxterm)
+        {
+            reply = dbus_message_new_error(message,
+                    RTDBUS_ERROR ".NoSuchTerminal",
+                    _("No terminal with that ROXTERM_ID"));
+            dbus_connection_send(connection, reply, NULL);
+            dbus_message_unref(reply);
+            return DBUS_HANDLER_RESULT_HANDLED;
+        }
+    }
+    report = roxterm_describe_memory_usage(roxterm);
+    reply = dbus_message_new_method_return(message);
+    dbus_message_append_args(reply, DBUS_TYPE_STRING, &report,
+            DBUS_TYPE_INVALID);
+    dbus_connection_send(connection, reply, NULL);
+    dbus_message_unref(reply);
+    g_free(report);
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static DBusHandlerResult set_tracing(DBusConnection *connection,
+        DBusMessage *message)
+{
+    DBusError derror;
+    DBusMessage *reply;
+    dbus_bool_t enable = FALSE;
+
+    dbus_error_init(&derror);
+    if (!dbus_message_get_args(message, &derror,
+            DBUS_TYPE_BOOLEAN, &enable, DBUS_TYPE_INVALID))
+    {
+        reply = dbus_message_new_error(message, derror.name, derror.message);
+        dbus_error_free(&derror);
+    }
+    else if (!tracepoint_set_enabled(enable))
+    {
+        reply = dbus_message_new_error(message,
+                RTDBUS_ERROR ".NotSupported",
+                _("roxterm was built without tracepoints"));
+    }
+    else
+    {
+        reply = dbus_message_new_method_return(message);
+    }
+    dbus_connection_send(connection, reply, NULL);
+    dbus_message_unref(reply);
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* Takes no args, so that callers can't choose where the file goes; the
+ * reply is the name of the file written */
+static DBusHandlerResult dump_trace(DBusConnection *connection,
+        DBusMessage *message)
+{
+    DBusMessage *reply;
+    GError *error = NULL;
+    char *written = tracepoint_dump(&error);
+
+    if (written)
+    {
+        reply = dbus_message_new_method_return(message);
+        dbus_message_append_args(reply, DBUS_TYPE_STRING, &written,
+                DBUS_TYPE_INVALID);
+        g_free(written);
+    }
+    else
+    {
+        reply = dbus_message_new_error(message, RTDBUS_ERROR ".TraceFailed",
+                error->message);
+        g_error_free(error);
+    }
+    dbus_connection_send(connection, reply, NULL);
+    dbus_message_unref(reply);
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+static gboolean dump_trace_on_signal(gpointer data)
+{
+    GError *error = NULL;
+    char *written = tracepoint_dump(&error);
+
+    (void) data;
+    if (written)
+    {
+        g_message("Trace written to '%s'", written);
+        g_free(written);
+    }
+    else
+    {
+        g_warning("%s", error->message);
+        g_error_free(error);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
 static DBusHandlerResult new_term_listener(DBusConnection *connection,
         DBusMessage *message, void *user_data)
 {
@@ -135,6 +261,21 @@ static DBusHandlerResult new_term_listener(DBusConnection *connection,
 
     dbus_error_init(&derror);
 
+    if (dbus_message_is_method_call(message, ROXTERM_DBUS_INTERFACE,
+                ROXTERM_DBUS_MEMORY_METHOD))
+    {
+        return get_memory_usage(connection, message);
+    }
+    if (dbus_message_is_method_call(message, ROXTERM_DBUS_INTERFACE,
+                ROXTERM_DBUS_SET_TRACING_METHOD))
+    {
+        return set_tracing(connection, message);
+    }
+    if (dbus_message_is_method_call(message, ROXTERM_DBUS_INTERFACE,
+                ROXTERM_DBUS_DUMP_TRACE_METHOD))
+    {
+        return dump_trace(connection, message);
+    }
     if (!dbus_message_is_method_call(message, ROXTERM_DBUS_INTERFACE,
                 ROXTERM_DBUS_METHOD_NAME))
     {
@@ -340,6 +481,8 @@ int main(int argc, char **argv)
 
 
     roxterm_init();
+    tracepoint_init();
+    g_unix_signal_add(SIGUSR2, dump_trace_on_signal, NULL);
 
     session_leafname = global_options_user_session_id ?
             global_options_user_session_id : "Default";
@@ -367,6 +510,8 @@ int main(int argc, char **argv)
     SLOG("Entering main loop with %d windows", g_list_length(multi_win_all));
     gtk_main();
 
+    /* Output logs of the last terminals to close may still be writing */
+    outputlog_wait_for_writers(5000);
     SLOG("Exiting normally");
 
     return 0;
@@ -0,0 +1,167 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "defns.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+
+#include <glib-unix.h>
+
+#include "mempressure.h"
+
+#define MEMPRESSURE_PSI_FILE "/proc/pressure/memory"
+
+/* Notify if tasks are stalled waiting for memory for 150ms within any 2s
+ * window. The kernel only lets unprivileged processes use windows which are
+ * a multiple of 2s. */
+#define MEMPRESSURE_PSI_TRIGGER "some 150000 2000000"
+
+/* Under continuous pressure the kernel notifies at most once per window, but
+ * consecutive notifications this close together are treated as escalation */
+#define MEMPRESSURE_ESCALATE_US (10 * G_USEC_PER_SEC)
+
+static MemPressureHandler mempressure_handler = NULL;
+static gpointer mempressure_data = NULL;
+
+static gboolean mempressure_psi_event(int fd, GIOCondition condition,
+        gpointer data)
+{
+    static gint64 last_event = 0;
+    static MemPressureLevel level = MEMPRESSURE_LOW;
+    gint64 now = g_get_monotonic_time();
+
+    (void) data;
+    if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL))
+    {
+        g_warning("Memory pressure monitor failed, disabling it");
+        close(fd);
+        return G_SOURCE_REMOVE;
+    }
+    if (last_event && now - last_event < MEMPRESSURE_ESCALATE_US)
+    {
+        if (level < MEMPRESSURE_CRITICAL)
+            ++level;
+    }
+    else
+    {
+        level = MEMPRESSURE_MEDIUM;
+    }
+    last_event = now;
+    mempressure_handler(level, mempressure_data);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean mempressure_watch_psi(void)
+{
+    int fd = open(MEMPRESSURE_PSI_FILE, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0)
+        return FALSE;
+    if (write(fd, MEMPRESSURE_PSI_TRIGGER,
+                strlen(MEMPRESSURE_PSI_TRIGGER) + 1) < 0)
+    {
+        g_debug("Unable to set memory pressure trigger: %s",
+                strerror(errno));
+        close(fd);
+        return FALSE;
+    }
+    g_unix_fd_add(fd, G_IO_PRI | G_IO_ERR, mempressure_psi_event, NULL);
+    return TRUE;
+}
+
+#if GLIB_CHECK_VERSION(2, 64, 0)
+static void mempressure_low_memory_warning(GMemoryMonitor *monitor,
+        GMemoryMonitorWarningLevel warning, gpointer data)
+{
+    MemPressureLevel level;
+
+    (void) monitor;
+    (void) data;
+    if (warning >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+        level = MEMPRESSURE_CRITICAL;
+    else if (warning >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+        level = MEMPRESSURE_MEDIUM;
+    else
+        level = MEMPRESSURE_LOW;
+    mempressure_handler(level, mempressure_data);
+}
+#endif
+
+gboolean mempressure_watch(MemPressureHandler handler, gpointer data)
+{
+    g_return_val_if_fail(mempressure_handler == NULL, FALSE);
+    mempressure_handler = handler;
+    mempressure_data = data;
+    if (mempressure_watch_psi())
+        return TRUE;
+#if GLIB_CHECK_VERSION(2, 64, 0)
+    {
+        /* Deliberately never unreffed */
+        GMemoryMonitor *monitor = g_memory_monitor_dup_default();
+
+        if (monitor)
+        {
+            g_signal_connect(monitor, "low-memory-warning",
+                    G_CALLBACK(mempressure_low_memory_warning), NULL);
+            return TRUE;
+        }
+    }
+#endif
+    mempressure_handler = NULL;
+    return FALSE;
+}
+
+void mempressure_get_process_usage(gsize *rss, gsize *heap_used,
+        gsize *heap_free)
+{
+    FILE *fp = fopen("/proc/self/statm", "r");
+    unsigned long size, resident;
+#if defined(HAVE_MALLINFO2)
+    struct mallinfo2 mi = mallinfo2();
+#elif defined(HAVE_MALLINFO)
+    /* The fields are only int so they wrap beyond 2GB */
+    struct mallinfo mi = mallinfo();
+#endif
+
+    *rss = 0;
+    if (fp)
+    {
+        if (fscanf(fp, "%lu %lu", &size, &resident) == 2)
+            *rss = (gsize) resident * (gsize) sysconf(_SC_PAGESIZE);
+        fclose(fp);
+    }
+#if defined(HAVE_MALLINFO2) || defined(HAVE_MALLINFO)
+    *heap_used = (gsize) mi.uordblks + (gsize) mi.hblkhd;
+    *heap_free = (gsize) mi.fordblks;
+#else
+    *heap_used = *heap_free = 0;
+#endif
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,48 @@
+#ifndef MEMPRESSURE_H
+#define MEMPRESSURE_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Notifies when the system is running low on memory */
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+typedef enum {
+    MEMPRESSURE_LOW,
+    MEMPRESSURE_MEDIUM,
+    MEMPRESSURE_CRITICAL
+} MemPressureLevel;
+
+typedef void (*MemPressureHandler)(MemPressureLevel level, gpointer data);
+
+/* Uses a /proc/pressure/memory trigger if the kernel allows it, otherwise
+ * GMemoryMonitor if GLib is new enough. Returns FALSE if neither is
+ * available. Only one handler is supported. */
+gboolean mempressure_watch(MemPressureHandler handler, gpointer data);
+
+/* Resident set size from /proc/self/statm and malloc's in-use and free
+ * heap bytes; any of them are 0 if unavailable */
+void mempressure_get_process_usage(gsize *rss, gsize *heap_used,
+        gsize *heap_free);
+
+#endif /* MEMPRESSURE_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -341,6 +341,7 @@ static void menutree_build(MenuTree *menu_tree, Options *shortcuts,
         "_", MENUTREE_NULL_ID,
         _("Save Buffer _As..."), MENUTREE_FILE_SAVE_BUFFER_AS,
         _("Save _Buffer"), MENUTREE_FILE_SAVE_BUFFER,
+        _("Canc_el Saving Buffer"), MENUTREE_FILE_CANCEL_SAVE_BUFFER,
         "_", MENUTREE_NULL_ID,
         _("_Save Session..."), MENUTREE_FILE_SAVE_SESSION,
         NULL);
@@ -377,6 +378,7 @@ static void menutree_build(MenuTree *menu_tree, Options *shortcuts,
         RESET_MENU_ITEMS,
         "_", MENUTREE_NULL_ID,
         _("Res_tart command"), MENUTREE_EDIT_RESPAWN,
+        _("Pause _Output"), MENUTREE_EDIT_PAUSE_OUTPUT,
         NULL);
     gtk_menu_item_set_submenu(GTK_MENU_ITEM(menu_tree->item_widgets
             [MENUTREE_EDIT]), submenu);
@@ -409,6 +411,7 @@ static void menutree_build(MenuTree *menu_tree, Options *shortcuts,
         _("_Find..."), MENUTREE_SEARCH_FIND,
         _("Find _Next"), MENUTREE_SEARCH_FIND_NEXT,
         _("Find _Previous"), MENUTREE_SEARCH_FIND_PREVIOUS,
+        _("Search _All Terminals..."), MENUTREE_SEARCH_FIND_ALL,
         NULL);
     gtk_menu_item_set_submenu(GTK_MENU_ITEM(menu_tree->item_widgets
             [MENUTREE_SEARCH]), submenu);
@@ -441,6 +444,7 @@ static void menutree_build(MenuTree *menu_tree, Options *shortcuts,
     submenu = gtk_menu_new();
     menutree_build_shell(menu_tree, GTK_MENU_SHELL(submenu),
         _("Show _Manual"), MENUTREE_HELP_SHOW_MANUAL,
+        _("Terminal _Information..."), MENUTREE_HELP_TERMINAL_INFO,
         _("_About ROXTerm"), MENUTREE_HELP_ABOUT, NULL);
     gtk_menu_item_set_submenu(GTK_MENU_ITEM(menu_tree->item_widgets
             [MENUTREE_HELP]), submenu);
@@ -594,6 +598,17 @@ void menutree_remove_tab(MenuTree *tree, GtkWidget *menu_item)
     menutree_apply_tab_shortcuts(tree);
 }
 
+void menutree_remove_tabs(MenuTree *tree, GList *menu_items)
+{
+    GList *link;
+
+    if (!menu_items)
+        return;
+    for (link = menu_items; link; link = g_list_next(link))
+        menutree_remove_tab_without_fixing_accels(tree, link->data);
+    menutree_apply_tab_shortcuts(tree);
+}
+
 static GtkWidget *menutree_tab_menu_item_new(GtkMenuShell *menu,
         const char *title)
 {
@@ -639,7 +654,8 @@ static void menu_item_change_label(GtkMenuItem *item, const char *label)
 
     if (GTK_IS_LABEL(inner_item))
     {
-        gtk_label_set_text_with_mnemonic(GTK_LABEL(inner_item), label);
+        if (g_strcmp0(gtk_label_get_label(GTK_LABEL(inner_item)), label))
+            gtk_label_set_text_with_mnemonic(GTK_LABEL(inner_item), label);
     }
     else if (GTK_IS_CONTAINER(inner_item))
     {
@@ -682,6 +698,12 @@ void menutree_change_move_tab_labels(MenuTree *tree)
             _("Move Tab _Down"));
 }
 
+void menutree_change_pause_output_label(MenuTree *tree, gboolean paused)
+{
+    menutree_change_label(tree, MENUTREE_EDIT_PAUSE_OUTPUT,
+            paused ? _("Resume _Output") : _("Pause _Output"));
+}
+
 static void menutree_set_toggle(MenuTree *tree, MenuTreeID id, gboolean active)
 {
     GtkCheckMenuItem *item = GTK_CHECK_MENU_ITEM
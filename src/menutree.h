@@ -56,6 +56,7 @@ typedef enum {
     MENUTREE_FILE_CLOSE_WINDOW,
     MENUTREE_FILE_SAVE_BUFFER_AS,
     MENUTREE_FILE_SAVE_BUFFER,
+    MENUTREE_FILE_CANCEL_SAVE_BUFFER,
     MENUTREE_FILE_SAVE_SESSION,
 
     MENUTREE_EDIT_SELECT_ALL,
@@ -66,6 +67,7 @@ typedef enum {
     MENUTREE_EDIT_RESET,
     MENUTREE_EDIT_RESET_AND_CLEAR,
     MENUTREE_EDIT_RESPAWN,
+    MENUTREE_EDIT_PAUSE_OUTPUT,
 
     MENUTREE_VIEW_SHOW_MENUBAR,
     MENUTREE_VIEW_SHOW_TAB_BAR,
@@ -86,6 +88,7 @@ typedef enum {
     MENUTREE_SEARCH_FIND,
     MENUTREE_SEARCH_FIND_NEXT,
     MENUTREE_SEARCH_FIND_PREVIOUS,
+    MENUTREE_SEARCH_FIND_ALL,
 
     MENUTREE_PREFERENCES_PROFILES,
     MENUTREE_PREFERENCES_SELECT_PROFILE,
@@ -106,6 +109,7 @@ typedef enum {
     MENUTREE_TABS_MOVE_TAB_RIGHT,
 
     MENUTREE_HELP_SHOW_MANUAL,
+    MENUTREE_HELP_TERMINAL_INFO,
     MENUTREE_HELP_ABOUT,
 
 
@@ -191,6 +195,7 @@ inline static GtkWidget *menutree_add_tab(MenuTree * tree, const char *title)
     return menutree_add_tab_at_position(tree, title, -1);
 }
 
+/* Changes the label in place and returns the same widget */
 GtkWidget *menutree_change_tab_title(MenuTree * tree,
     GtkWidget *widget, const char *title);
 
@@ -254,6 +259,9 @@ void menutree_find_radio_group(GtkWidget *widget, gpointer data);
  * menutree_add_tab */
 void menutree_remove_tab(MenuTree * tree, GtkWidget * menu_item);
 
+/* As above for a list of items, but only fixes up accelerators once */
+void menutree_remove_tabs(MenuTree * tree, GList * menu_items);
+
 inline static void menutree_select_tab(MenuTree * tree, GtkWidget * menu_item)
 {
     (void) tree;
@@ -267,6 +275,9 @@ void menutree_disable_tab_shortcuts(MenuTree *tree, gboolean disable);
 /* Change left/right to up/down */
 void menutree_change_move_tab_labels(MenuTree *tree);
 
+/* Label the Pause/Resume Output item for the current tab's state */
+void menutree_change_pause_output_label(MenuTree *tree, gboolean paused);
+
 #endif /* MENUTREE_H */
 
 /* vi:set sw=4 ts=4 et cindent cino= */
@@ -244,17 +244,17 @@ multitab_label_draw_attention (MultitabLabel *self)
 {
     multitab_label_cancel_attention (self);
     multitab_label_toggle_attention (self);
-    self->timeout_tag = g_timeout_add (500,
+    self->attention_anim = anim_clock_add (GTK_WIDGET (self), 500,
             multitab_label_toggle_attention, self);
 }
 
 void
 multitab_label_cancel_attention (MultitabLabel *self)
 {
-    if (self->timeout_tag)
+    if (self->attention_anim)
     {
-        g_source_remove (self->timeout_tag);
-        self->timeout_tag = 0;
+        anim_clock_remove (self->attention_anim);
+        self->attention_anim = NULL;
     }
     if (self->attention)
     {
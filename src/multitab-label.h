@@ -26,6 +26,8 @@
 
 #include <glib-object.h>
 
+#include "animclock.h"
+
 #define MULTITAB_TYPE_LABEL \
         (multitab_label_get_type ())
 #define MULTITAB_LABEL(obj) \
@@ -51,7 +53,7 @@ struct _MultitabLabel
     GdkRGBA attention_color;
     GtkLabel *label;
     gboolean attention;
-    guint timeout_tag;
+    AnimClockEntry *attention_anim;
     gboolean single;
     gboolean fixed_width;
     GtkWidget *parent;
@@ -0,0 +1,146 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "multitab-parse.h"
+
+char *multi_win_make_title(const char *template, const char *title,
+        const char *process, int tab_num, int tab_count)
+{
+    GString *subbed;
+    size_t n, l;
+    if (!template || !template[0])
+        return g_new0(char, 1);
+    l = strlen(template);
+    subbed = g_string_sized_new(strlen(template));
+    for (n = 0; n < l; ++n)
+    {
+        if (template[n] == '%')
+        {
+            switch (template[++n])
+            {
+                case 's':
+                    if (title)
+                        g_string_append(subbed, title);
+                    break;
+                case 't':
+                    g_string_append_printf(subbed, "%d", tab_num);
+                    break;
+                case 'n':
+                    g_string_append_printf(subbed, "%d", tab_count);
+                    break;
+                case 'p':
+                    if (process)
+                        g_string_append(subbed, process);
+                    break;
+                case 0:
+                    --n;    /* Make sure next iteration sees terminator */
+                    // Fall-through
+                case '%':
+                    g_string_append_c(subbed, '%');
+                    break;
+                default:
+                    g_string_append_c(subbed, '%');
+                    g_string_append_c(subbed, template[n]);
+                    break;
+            }
+        }
+        else
+        {
+            g_string_append_c(subbed, template[n]);
+        }
+    }
+    return g_string_free(subbed, FALSE);
+}
+
+/* Parse a sequence of digits from a geometry string.
+ * Return pointer to first non-digit or NULL if invalid. */
+static const char *parse_digits(const char *geom, int *num)
+{
+    unsigned long ul = 0;
+    size_t len = geom ? strspn(geom, "0123456789") : 0;
+    if (0 < len && 1 == sscanf(geom, "%lu", &ul) && ul <= G_MAXINT)
+    {
+        *num = (int) ul;
+        return geom + len;
+    }
+    return NULL;
+}
+
+/* Parse a signed integer, which might be preceded by a plus or minus.
+ * Return NULL if invalid, or a pointer to where the parsing ended. */
+static const char *parse_signed(const char *geom, int *num, int *sign)
+{
+    char c = *geom;
+    if (c == '+' || c == '-')
+        geom++;
+    geom = parse_digits(geom, num);
+    if (geom && c == '+')
+    {
+        *sign = +1;
+    }
+    if (geom && c == '-')
+    {
+        *num = (0 - *num);
+        *sign = -1;
+    }
+    return geom;
+}
+
+/* Parse a pair of signed integers, each must be preceded by a plus or minus.
+ * Return NULL if invalid, or a pointer to where the parsing ended. */
+static const char *parse_geom_offsets(const char *g, int *x, int *y, int *sign_x, int *sign_y)
+{
+    if (g && ( *g == '+' || *g == '-' ) )
+    {
+        g = parse_signed(g, x, sign_x);
+        if (g && ( *g == '+' || *g == '-' ))
+        {
+            return parse_signed(g, y, sign_y);
+        }
+    }
+    return NULL;
+}
+
+/* Parse a geometry string WxH[+X+Y]. If pxy is non-null, then also
+ * parse a position +X+Y. Return TRUE for WxH and set pxy for +X+Y. */
+gboolean multi_win_parse_geometry(const char *geom,
+        int *width, int *height, int *x, int *y, int *sign_x, int *sign_y, gboolean *pxy)
+{
+    geom = parse_digits(geom, width);
+    if (geom && strchr("xX", *geom))
+    {
+        geom = parse_digits(geom + 1, height);
+        if (geom && (!*geom || strchr("+-", *geom)))
+        {
+            if (pxy)
+            {
+                *pxy = (parse_geom_offsets(geom, x, y, sign_x, sign_y) != NULL);
+            }
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
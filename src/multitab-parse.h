@@ -0,0 +1,42 @@
+#ifndef MULTITAB_PARSE_H
+#define MULTITAB_PARSE_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Parsing of window title templates and geometry strings. These don't need
+ * GTK or a display, so they're kept out of multitab.c.
+ */
+
+#include <glib.h>
+
+/* Substitutes %s (title), %p (process), %t (tab number) and %n (number of
+ * tabs) in template. Returns a newly allocated string. */
+char *multi_win_make_title(const char *template, const char *title,
+        const char *process, int tab_num, int tab_count);
+
+/* Parses a geometry string and returns TRUE if successful. If sizes
+ * aren't given their respective outputs are set to 0. xy is updated to indicate
+ * whether x and y were present.
+ */
+gboolean multi_win_parse_geometry(const char *geom,
+        int *width, int *height, int *x, int *y, int *sign_x, int *sign_y, gboolean *xy);
+
+#endif /* MULTITAB_PARSE_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -24,17 +24,23 @@
 
 #include <errno.h>
 
+#include "animclock.h"
 #include "dlg.h"
 #include "globalopts.h"
 #include "menutree.h"
 #include "multitab.h"
 #include "multitab-close-button.h"
 #include "multitab-label.h"
+#include "multitab-parse.h"
 #include "session-file.h"
 #include "shortcuts.h"
 
 #define HORIZ_TAB_WIDTH_CHARS 16
 
+/* Title changes are coalesced and applied at most this often, about once per
+ * frame, because some programs change the title many times a second */
+#define MULTI_WIN_TITLE_UPDATE_MS 16
+
 struct MultiTab {
     MultiWin *parent;
     GtkWidget *widget;            /* Top-level widget in notebook */
@@ -56,6 +62,8 @@ struct MultiTab {
     int middle_click_action;
     gboolean restore_pending;
     int restore_rows, restore_columns;
+    gboolean title_dirty;
+    char *process_name;
 };
 
 struct MultiWin {
@@ -102,8 +110,15 @@ struct MultiWin {
     gboolean has_geometry;
     gboolean show_clipboard_indicator;
     int clipboard_flash_frame;
-    gulong clipboard_flash_tag;
+    AnimClockEntry *clipboard_flash_anim;
     GtkWidget *clipboard_indicator_button;
+    guint title_update_tag;
+    int geometry_depth;         /* Nesting of multi_win_begin_geometry */
+    gboolean geometry_pending;
+    gboolean geometry_restore;  /* Pending change is a size restore */
+    MultiTab *geometry_tab;
+    int geometry_columns, geometry_rows;
+    guint geometry_tick;
 };
 
 static double multi_win_zoom_factors[] = {
@@ -144,9 +159,12 @@ static MultiTabGetShowCloseButton multi_tab_get_show_close_button;
 static MultiTabGetNewTabAdjacent multi_tab_get_new_tab_adjacent;
 static MultiTabConnectMiscSignals multi_tab_connect_misc_signals;
 static MultiWinClipboardButtonHandler multi_win_clipboard_button_handler;
+static MultiTabGetStatusTooltip multi_tab_get_status_tooltip;
 
 static gboolean multi_win_notify_tab_removed(MultiWin *, MultiTab *);
 
+static gboolean multi_win_update_after_tabs_removed(MultiWin *win);
+
 static void multi_win_add_tab(MultiWin *, MultiTab *, int position,
         gboolean notify_only);
 
@@ -165,15 +183,8 @@ static gboolean multi_win_process_geometry(MultiWin *win,
 
 static char *multi_tab_get_full_window_title(MultiTab * tab);
 
-static gboolean multi_tab_do_restore_size(MultiTab *tab)
-{
-    int width, height;
-
-    multi_win_process_geometry(tab->parent, tab,
-            tab->restore_columns, tab->restore_rows, &width, &height);
-    gtk_window_resize(GTK_WINDOW(tab->parent->gtkwin), width, height);
-    return FALSE;
-}
+static void multi_win_queue_geometry(MultiWin *win, MultiTab *tab,
+        int columns, int rows, gboolean restore);
 
 static void multi_tab_size_allocate(GtkWidget *widget, GdkRectangle *alloc,
         MultiTab *tab)
@@ -186,9 +197,10 @@ static void multi_tab_size_allocate(GtkWidget *widget, GdkRectangle *alloc,
         tab->restore_pending = FALSE;
         /* Calling gtk_window_resize from a size-allocate handler doesn't seem
          * to work, which is probably quite a sensible precaution by GTK, but it
-         * means we have to make another deferment.
+         * means we have to make another deferment, to the next frame.
          */
-        g_idle_add((GSourceFunc) multi_tab_do_restore_size, tab);
+        multi_win_queue_geometry(tab->parent, tab,
+                tab->restore_columns, tab->restore_rows, TRUE);
     }
 }
 
@@ -258,7 +270,8 @@ void multi_tab_init(MultiTabFiller filler, MultiTabDestructor destructor,
     MultiTabGetShowCloseButton get_show_close_button,
     MultiTabGetNewTabAdjacent get_new_tab_adjacent,
     MultiTabConnectMiscSignals connect_misc_signals,
-    MultiWinClipboardButtonHandler clipboard_button_handler)
+    MultiWinClipboardButtonHandler clipboard_button_handler,
+    MultiTabGetStatusTooltip get_status_tooltip)
 {
     multi_tab_filler = filler;
     multi_tab_destructor = destructor;
@@ -275,6 +288,7 @@ void multi_tab_init(MultiTabFiller filler, MultiTabDestructor destructor,
     multi_tab_get_new_tab_adjacent = get_new_tab_adjacent;
     multi_tab_connect_misc_signals = connect_misc_signals;
     multi_win_clipboard_button_handler = clipboard_button_handler;
+    multi_tab_get_status_tooltip = get_status_tooltip;
 }
 
 // Doesn't connect client's signal handlers
@@ -346,6 +360,8 @@ static void multi_tab_delete_without_notifying_parent(MultiTab * tab,
     tab->window_title = NULL;
     g_free(tab->window_title_template);
     tab->window_title_template = NULL;
+    g_free(tab->process_name);
+    tab->process_name = NULL;
     if (destroy_widgets && tab->widget)
     {
         gtk_widget_destroy(tab->widget);
@@ -398,57 +414,12 @@ static void multi_win_set_geometry_hints_for_tab(MultiWin * win, MultiTab * tab)
 }
 */
 
-static char *make_title(const char *template, const char *title,
-        int tab_num, int tab_count)
-{
-    GString *subbed;
-    size_t n, l;
-    if (!template || !template[0])
-        return g_new0(char, 1);
-    l = strlen(template);
-    subbed = g_string_sized_new(strlen(template));
-    for (n = 0; n < l; ++n)
-    {
-        if (template[n] == '%')
-        {
-            switch (template[++n])
-            {
-                case 's':
-                    if (title)
-                        g_string_append(subbed, title);
-                    break;
-                case 't':
-                    g_string_append_printf(subbed, "%d", tab_num);
-                    break;
-                case 'n':
-                    g_string_append_printf(subbed, "%d", tab_count);
-                    break;
-                case 0:
-                    --n;    /* Make sure next iteration sees terminator */
-                    // Fall-through
-                case '%':
-                    g_string_append_c(subbed, '%');
-                    break;
-                default:
-                    g_string_append_c(subbed, '%');
-                    g_string_append_c(subbed, template[n]);
-                    break;
-            }
-        }
-        else
-        {
-            g_string_append_c(subbed, template[n]);
-        }
-    }
-    return g_string_free(subbed, FALSE);
-}
-
-
 static void multi_tab_set_full_window_title(MultiTab * tab)
 {
     MultiWin *win = tab->parent;
     char *tab_label;
-    
+
+    tab->title_dirty = FALSE;
     tab_label = multi_tab_get_full_window_title(tab);
     if (tab->label)
     {
@@ -459,30 +430,85 @@ static void multi_tab_set_full_window_title(MultiTab * tab)
         win->ignore_toggles = TRUE;
         if (win->current_tab == tab)
             multi_win_set_title(win, tab->window_title);
+        /* The items' labels are changed in place so their "toggled"
+         * handlers are still connected */
         if (tab->popup_menu_item)
         {
-            tab->popup_menu_item = menutree_change_tab_title
-                (win->popup_menu, tab->popup_menu_item, tab_label);
-            g_signal_connect(tab->popup_menu_item, "toggled",
-                G_CALLBACK(multi_win_select_tab_action), tab);
+            menutree_change_tab_title(win->popup_menu, tab->popup_menu_item,
+                    tab_label);
         }
         if (tab->menu_bar_item)
         {
-            tab->menu_bar_item = menutree_change_tab_title
-                (win->menu_bar, tab->menu_bar_item, tab_label);
-            g_signal_connect(tab->menu_bar_item, "toggled",
-                G_CALLBACK(multi_win_select_tab_action), tab);
+            menutree_change_tab_title(win->menu_bar, tab->menu_bar_item,
+                    tab_label);
         }
         win->ignore_toggles = FALSE;
     }
     g_free(tab_label);
 }
 
+static gboolean multi_win_flush_titles(MultiWin *win)
+{
+    GList *link;
+
+    win->title_update_tag = 0;
+    for (link = win->tabs; link; link = g_list_next(link))
+    {
+        MultiTab *tab = link->data;
+
+        if (tab->title_dirty)
+            multi_tab_set_full_window_title(tab);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void multi_tab_queue_title_update(MultiTab *tab)
+{
+    MultiWin *win = tab->parent;
+
+    if (!win)
+    {
+        multi_tab_set_full_window_title(tab);
+        return;
+    }
+    tab->title_dirty = TRUE;
+    if (!win->title_update_tag)
+    {
+        win->title_update_tag = g_timeout_add(MULTI_WIN_TITLE_UPDATE_MS,
+                (GSourceFunc) multi_win_flush_titles, win);
+    }
+}
+
 void multi_tab_set_window_title(MultiTab * tab, const char *title)
 {
+    if (!g_strcmp0(tab->window_title, title))
+        return;
     g_free(tab->window_title);
     tab->window_title = title ? g_strdup(title) : NULL;
-    multi_tab_set_full_window_title(tab);
+    multi_tab_queue_title_update(tab);
+}
+
+void multi_tab_set_process_name(MultiTab *tab, const char *name)
+{
+    MultiWin *win = tab->parent;
+
+    if (!g_strcmp0(tab->process_name, name))
+        return;
+    g_free(tab->process_name);
+    tab->process_name = name ? g_strdup(name) : NULL;
+    /* Most templates don't use it, so don't bother redrawing everything */
+    if ((tab->window_title_template &&
+            strstr(tab->window_title_template, "%p")) ||
+            (win && win->current_tab == tab && win->title_template &&
+            strstr(win->title_template, "%p")))
+    {
+        multi_tab_queue_title_update(tab);
+    }
+}
+
+const char *multi_tab_get_process_name(MultiTab *tab)
+{
+    return tab->process_name;
 }
 
 void multi_tab_set_window_title_template(MultiTab * tab, const char *template)
@@ -518,7 +544,8 @@ static char *multi_tab_get_full_window_title(MultiTab * tab)
 {
     int num = tab->parent->ntabs;
     int pos = multi_tab_get_page_num(tab) + 1;
-    return make_title(tab->window_title_template, tab->window_title, pos, num);
+    return multi_win_make_title(tab->window_title_template, tab->window_title,
+            tab->process_name, pos, num);
 }
 
 gpointer multi_tab_get_user_data(MultiTab * tab)
@@ -768,7 +795,9 @@ static void multi_win_set_full_title(MultiWin *win)
     {
         int pos = win && win->current_tab ?
                   multi_tab_get_page_num(win->current_tab) + 1 : 1;
-        char *title0 = make_title(win->title_template, win->child_title,
+        char *title0 = multi_win_make_title(win->title_template,
+                win->child_title,
+                win->current_tab ? win->current_tab->process_name : NULL,
                 pos, win->ntabs);
 
         gtk_window_set_title(GTK_WINDOW(win->gtkwin), title0);
@@ -815,6 +844,7 @@ void multi_win_select_tab(MultiWin * win, MultiTab * tab)
     win->ignore_tab_selections = TRUE;
     win->ignore_toggles = TRUE;
     win->current_tab = tab;
+    multi_win_begin_geometry(win);
     if (tab)
     {
         char *title = multi_tab_get_full_window_title(tab);
@@ -836,6 +866,7 @@ void multi_win_select_tab(MultiWin * win, MultiTab * tab)
                 win->tab_selection_handler(tab->user_data, tab);
         }
     }
+    multi_win_commit_geometry(win);
     multi_win_shade_for_next_and_previous_tab(win);
     multi_win_highlight_selected_tab(win);
     /* FIXME: Ideally we should shade scroll up/down menu items if tab doesn't
@@ -1091,6 +1122,23 @@ static gboolean tab_clicked_handler(GtkWidget *widget,
     return FALSE;
 }
 
+static gboolean multi_tab_query_tooltip(GtkWidget *widget, int x, int y,
+        gboolean keyboard_mode, GtkTooltip *tooltip, MultiTab *tab)
+{
+    char *text;
+
+    (void) widget;
+    (void) x;
+    (void) y;
+    (void) keyboard_mode;
+    text = multi_tab_get_status_tooltip(tab->user_data);
+    if (!text)
+        return FALSE;
+    gtk_tooltip_set_text(tooltip, text);
+    g_free(text);
+    return TRUE;
+}
+
 /* Creates the label widget for a tab. tab->label is the GtkLabel containing
  * the text; the return value is the top-level container. */
 static GtkWidget *make_tab_label(MultiTab *tab, GtkPositionType tab_pos)
@@ -1104,6 +1152,9 @@ static GtkWidget *make_tab_label(MultiTab *tab, GtkPositionType tab_pos)
     gtk_box_pack_start(GTK_BOX(tab->label_box), tab->label, TRUE, TRUE, 0);
     g_signal_connect(tab->label, "button-press-event",
             G_CALLBACK(tab_clicked_handler), tab);
+    gtk_widget_set_has_tooltip(tab->label_box, TRUE);
+    g_signal_connect(tab->label_box, "query-tooltip",
+            G_CALLBACK(multi_tab_query_tooltip), tab);
     if (multi_tab_get_show_close_button(tab->user_data))
     {
         multi_tab_add_close_button(tab);
@@ -1287,19 +1338,64 @@ static void multi_win_close_tab_action(MultiWin * win)
     multi_win_close_tab_clicked(NULL, win->current_tab);
 }
 
-static void multi_win_close_other_tabs_action(MultiWin * win)
+/* Deletes several tabs, but only updates the window's numbering, menus and
+ * layout once at the end instead of after each tab */
+static void multi_win_delete_tabs(MultiWin *win, GList *tabs)
 {
     GList *link;
+    GList *popup_items = NULL;
+    GList *bar_items = NULL;
+
+    if (!tabs)
+        return;
+    win->ignore_tabs_moving = TRUE;
+    win->ignore_tab_selections = TRUE;
+    for (link = tabs; link; link = g_list_next(link))
+    {
+        MultiTab *tab = link->data;
 
-    while ((link = win->tabs) != NULL)
+        if (tab->popup_menu_item)
+        {
+            popup_items = g_list_prepend(popup_items, tab->popup_menu_item);
+            tab->popup_menu_item = NULL;
+        }
+        if (tab->menu_bar_item)
+        {
+            bar_items = g_list_prepend(bar_items, tab->menu_bar_item);
+            tab->menu_bar_item = NULL;
+        }
+        if (win->current_tab == tab)
+            win->current_tab = NULL;
+        win->tabs = g_list_remove(win->tabs, tab);
+        --win->ntabs;
+        multi_tab_delete_without_notifying_parent(tab, TRUE);
+    }
+    if (win->popup_menu)
+        menutree_remove_tabs(win->popup_menu, popup_items);
+    if (win->menu_bar)
+        menutree_remove_tabs(win->menu_bar, bar_items);
+    g_list_free(popup_items);
+    g_list_free(bar_items);
+    win->ignore_tab_selections = FALSE;
+    if (win->ntabs && !win->current_tab)
     {
-        if (link->data == win->current_tab)
-            link = g_list_next(link);
-        if (link)
-            multi_tab_delete(link->data);
-        else
-            break;
+        GtkNotebook *notebook = GTK_NOTEBOOK(win->notebook);
+
+        multi_win_select_tab(win, multi_tab_get_from_widget(
+                gtk_notebook_get_nth_page(notebook,
+                        gtk_notebook_get_current_page(notebook))));
     }
+    if (!multi_win_update_after_tabs_removed(win))
+        win->ignore_tabs_moving = FALSE;
+}
+
+static void multi_win_close_other_tabs_action(MultiWin * win)
+{
+    GList *others = g_list_copy(win->tabs);
+
+    others = g_list_remove(others, win->current_tab);
+    multi_win_delete_tabs(win, others);
+    g_list_free(others);
 }
 
 static void multi_win_name_tab_action(MultiWin * win)
@@ -1562,11 +1658,13 @@ static void multi_win_zoom_changed(MultiWin *win)
 
     if (!multi_win_zoom_handler)
         return;
+    multi_win_begin_geometry(win);
     for (link = win->tabs; link; link = g_list_next(link))
     {
         multi_win_zoom_handler(((MultiTab *) link->data)->user_data, zf,
                 win->zoom_index);
     }
+    multi_win_commit_geometry(win);
 }
 
 static void multi_win_zoom_in_action(MultiWin *win)
@@ -2127,10 +2225,23 @@ static void multi_win_destructor(MultiWin *win, gboolean destroy_widgets)
     g_return_if_fail(win);
 
     win->ignore_tab_selections = TRUE;
-    if (win->clipboard_flash_tag != 0)
+    win->ignore_tabs_moving = TRUE;
+    if (win->clipboard_flash_anim)
+    {
+        anim_clock_remove(win->clipboard_flash_anim);
+        win->clipboard_flash_anim = NULL;
+    }
+    if (win->title_update_tag)
+    {
+        g_source_remove(win->title_update_tag);
+        win->title_update_tag = 0;
+    }
+    if (win->geometry_tick)
     {
-        g_source_remove(win->clipboard_flash_tag);
+        gtk_widget_remove_tick_callback(win->gtkwin, win->geometry_tick);
+        win->geometry_tick = 0;
     }
+    win->geometry_pending = FALSE;
     if (win->accel_group)
     {
         UNREF_LOG(g_object_unref(win->accel_group));
@@ -2139,15 +2250,21 @@ static void multi_win_destructor(MultiWin *win, gboolean destroy_widgets)
     if (destroy_widgets && win->gtkwin)
     {
         g_signal_handler_disconnect(win->gtkwin, win->destroy_handler);
+        /* Hiding the window first stops the notebook mapping and allocating
+         * each remaining page in turn as the pages are destroyed */
+        gtk_widget_hide(win->gtkwin);
     }
 
     if (!destroy_widgets)
     {
         win->gtkwin = NULL;
     }
+    /* Tabs' widgets and menu items are destroyed in bulk along with the
+     * window and menus below */
     for (link = win->tabs; link; link = g_list_next(link))
     {
-        multi_tab_delete_without_notifying_parent(link->data, destroy_widgets);
+        multi_tab_delete_without_notifying_parent(link->data,
+                destroy_widgets && !win->gtkwin);
     }
     if (win->menu_bar)
     {
@@ -2205,7 +2322,14 @@ static gboolean multi_win_notify_tab_removed(MultiWin * win, MultiTab * tab)
     /*win->ignore_tab_selections = TRUE;*/
     win->tabs = g_list_delete_link(win->tabs, link);
     /*win->ignore_tab_selections = FALSE;*/
-    if (!--win->ntabs)
+    --win->ntabs;
+    return multi_win_update_after_tabs_removed(win);
+}
+
+/* Returns TRUE if window destroyed */
+static gboolean multi_win_update_after_tabs_removed(MultiWin *win)
+{
+    if (!win->ntabs)
     {
         multi_win_delete(win);
         return TRUE;
@@ -2215,7 +2339,6 @@ static gboolean multi_win_notify_tab_removed(MultiWin * win, MultiTab * tab)
         renumber_tabs(win);
         if (win->ntabs == 1)
         {
-            tab = win->tabs->data;
             if (win->tab_pos == GTK_POS_TOP || win->tab_pos == GTK_POS_BOTTOM)
                 multi_win_pack_for_single_tab(win);
             if (!win->always_show_tabs)
@@ -2270,6 +2393,12 @@ void multi_tab_set_status_icon_name(MultiTab *tab, const char *name)
     }
 }
 
+void multi_tab_update_status_tooltip(MultiTab *tab)
+{
+    if (tab->label_box)
+        gtk_widget_trigger_tooltip_query(tab->label_box);
+}
+
 void multi_tab_set_middle_click_tab_action(MultiTab *tab, int action)
 {
     tab->middle_click_action = action;
@@ -2646,76 +2775,6 @@ guint multi_win_get_num_tabs(MultiWin *win)
     return g_list_length(win->tabs);
 }
 
-/* Parse a sequence of digits from a geometry string.
- * Return pointer to first non-digit or NULL if invalid. */
-static const char *parse_digits(const char *geom, int *num)
-{
-    unsigned long ul = 0;
-    size_t len = geom ? strspn(geom, "0123456789") : 0;
-    if (0 < len && 1 == sscanf(geom, "%lu", &ul) && ul <= G_MAXINT)
-    {
-        *num = (int) ul;
-        return geom + len;
-    }
-    return NULL;
-}
-
-/* Parse a signed integer, which might be preceded by a plus or minus.
- * Return NULL if invalid, or a pointer to where the parsing ended. */
-static const char *parse_signed(const char *geom, int *num, int *sign)
-{
-    char c = *geom;
-    if (c == '+' || c == '-')
-        geom++;
-    geom = parse_digits(geom, num);
-    if (geom && c == '+')
-    {
-        *sign = +1;
-    }
-    if (geom && c == '-')
-    {
-        *num = (0 - *num);
-        *sign = -1;
-    }
-    return geom;
-}
-
-/* Parse a pair of signed integers, each must be preceded by a plus or minus.
- * Return NULL if invalid, or a pointer to where the parsing ended. */
-static const char *parse_geom_offsets(const char *g, int *x, int *y, int *sign_x, int *sign_y)
-{
-    if (g && ( *g == '+' || *g == '-' ) )
-    {
-        g = parse_signed(g, x, sign_x);
-        if (g && ( *g == '+' || *g == '-' ))
-        {
-            return parse_signed(g, y, sign_y);
-        }
-    }
-    return NULL;
-}
-
-/* Parse a geometry string WxH[+X+Y]. If pxy is non-null, then also
- * parse a position +X+Y. Return TRUE for WxH and set pxy for +X+Y. */
-gboolean multi_win_parse_geometry(const char *geom,
-        int *width, int *height, int *x, int *y, int *sign_x, int *sign_y, gboolean *pxy)
-{
-    geom = parse_digits(geom, width);
-    if (geom && strchr("xX", *geom))
-    {
-        geom = parse_digits(geom + 1, height);
-        if (geom && (!*geom || strchr("+-", *geom)))
-        {
-            if (pxy)
-            {
-                *pxy = (parse_geom_offsets(geom, x, y, sign_x, sign_y) != NULL);
-            }
-            return TRUE;
-        }
-    }
-    return FALSE;
-}
-
 /* Returns TRUE if the geometry hints have changed. */
 static gboolean multi_win_process_geometry(MultiWin *win,
         MultiTab *tab, int columns, int rows, int *width, int *height)
@@ -2856,8 +2915,18 @@ void multi_win_set_initial_geometry(MultiWin *win, const char *geom,
     }
 }
 
-void multi_win_apply_new_geometry(MultiWin *win, int columns, int rows,
-        MultiTab *tab)
+/******************** Geometry transactions *********************/
+
+/* Changing a profile or selecting a tab can change a terminal's font,
+ * spacing and size several times in a row, and each change used to resize
+ * the window, so the shell saw a SIGWINCH for each of them. Now each change
+ * only records the latest requested geometry and the window is resized
+ * once, at the start of the next frame, or when the outermost transaction
+ * is committed if that's later.
+ */
+
+static void multi_win_resize_for_geometry(MultiWin *win, MultiTab *tab,
+        int columns, int rows)
 {
     int width, height;
     int old_width, old_height;
@@ -2884,6 +2953,97 @@ void multi_win_apply_new_geometry(MultiWin *win, int columns, int rows,
     }
 }
 
+static void multi_win_flush_geometry(MultiWin *win)
+{
+    MultiTab *tab = win->geometry_tab;
+    int width, height;
+
+    if (win->geometry_tick)
+    {
+        gtk_widget_remove_tick_callback(win->gtkwin, win->geometry_tick);
+        win->geometry_tick = 0;
+    }
+    if (!win->geometry_pending)
+        return;
+    win->geometry_pending = FALSE;
+    win->geometry_tab = NULL;
+    /* The tab may have been closed or moved since the change was queued */
+    if (tab && !g_list_find(win->tabs, tab))
+        return;
+    if (win->geometry_restore)
+    {
+        multi_win_process_geometry(win, tab,
+                win->geometry_columns, win->geometry_rows, &width, &height);
+        gtk_window_resize(GTK_WINDOW(win->gtkwin), width, height);
+    }
+    else
+    {
+        multi_win_resize_for_geometry(win, tab,
+                win->geometry_columns, win->geometry_rows);
+    }
+}
+
+static gboolean multi_win_geometry_tick(GtkWidget *widget,
+        GdkFrameClock *clock, gpointer handle)
+{
+    MultiWin *win = handle;
+
+    (void) widget;
+    (void) clock;
+    win->geometry_tick = 0;
+    multi_win_flush_geometry(win);
+    return G_SOURCE_REMOVE;
+}
+
+/* A window that isn't mapped has no frames, but doesn't need to wait for
+ * one either */
+static void multi_win_schedule_geometry(MultiWin *win)
+{
+    if (win->geometry_depth || win->geometry_tick)
+        return;
+    if (gtk_widget_get_mapped(win->gtkwin))
+    {
+        win->geometry_tick = gtk_widget_add_tick_callback(win->gtkwin,
+                multi_win_geometry_tick, win, NULL);
+    }
+    else
+    {
+        multi_win_flush_geometry(win);
+    }
+}
+
+/* A later change replaces any pending one */
+static void multi_win_queue_geometry(MultiWin *win, MultiTab *tab,
+        int columns, int rows, gboolean restore)
+{
+    win->geometry_pending = TRUE;
+    win->geometry_restore = restore;
+    win->geometry_tab = tab;
+    win->geometry_columns = columns;
+    win->geometry_rows = rows;
+    multi_win_schedule_geometry(win);
+}
+
+void multi_win_begin_geometry(MultiWin *win)
+{
+    ++win->geometry_depth;
+}
+
+void multi_win_commit_geometry(MultiWin *win)
+{
+    g_return_if_fail(win->geometry_depth > 0);
+    if (!--win->geometry_depth && win->geometry_pending)
+        multi_win_schedule_geometry(win);
+}
+
+void multi_win_apply_new_geometry(MultiWin *win, int columns, int rows,
+        MultiTab *tab)
+{
+    multi_win_queue_geometry(win, tab, columns, rows, FALSE);
+}
+
+/****************** End geometry transactions *******************/
+
 /* Shows the indicator on odd frames, hides it on even */
 static gboolean multi_win_toggle_clipboard_indicator(MultiWin *win)
 {
@@ -2898,7 +3058,7 @@ static gboolean multi_win_toggle_clipboard_indicator(MultiWin *win)
         {
             gtk_widget_hide(win->clipboard_indicator_button);
         }
-        win->clipboard_flash_tag = 0;
+        win->clipboard_flash_anim = NULL;
         return FALSE;
     }
     return TRUE;
@@ -2908,21 +3068,21 @@ void multi_win_flash_clipboard_indicator(MultiWin *win, gboolean show)
 {
     gboolean already_showing = win->show_clipboard_indicator;
     win->show_clipboard_indicator = show;
-    if (!win->clipboard_flash_tag)
+    if (!win->clipboard_flash_anim)
     {
         win->clipboard_flash_frame = already_showing ? 5 : 4;
         gtk_widget_show_all(win->clipboard_indicator_button);
-        win->clipboard_flash_tag =
-            g_timeout_add(200,
-                          G_SOURCE_FUNC(multi_win_toggle_clipboard_indicator),
-                          win);
+        win->clipboard_flash_anim =
+            anim_clock_add(win->clipboard_indicator_button, 200,
+                    (AnimClockFunc) multi_win_toggle_clipboard_indicator,
+                    win);
     }
 }
 
 void multi_win_hide_clipboard_indicator(MultiWin *win)
 {
     win->show_clipboard_indicator = FALSE;
-    if (!win->clipboard_flash_tag)
+    if (!win->clipboard_flash_anim)
     {
         gtk_widget_hide(win->clipboard_indicator_button);
     }
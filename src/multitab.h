@@ -22,6 +22,7 @@
 /* Hierarchy of multiple windows, each containing multiple tabs */
 
 #include "menutree.h"
+#include "multitab-parse.h"
 #include "options.h"
 
 typedef struct MultiTab MultiTab;
@@ -115,6 +116,10 @@ typedef void (*MultiTabConnectMiscSignals)(gpointer user_data);
 /* Called when the clipboard button is pressed */
 typedef void (*MultiWinClipboardButtonHandler)(gpointer user_data);
 
+/* Returns a tooltip for a tab's label, freed by the caller, or NULL for none.
+ * It's only called when the tooltip is about to be shown. */
+typedef char *(*MultiTabGetStatusTooltip)(gpointer user_data);
+
 /* Call to set up function hooks. See MultiTabFiller etc above.
  * menu_signal_connector is called each time a new window is created to give
  * the client a chance to connect its signal handlers; each handler will
@@ -127,7 +132,7 @@ multi_tab_init(MultiTabFiller filler, MultiTabDestructor destructor,
     MultiWinZoomHandler, MultiWinGetDisableMenuShortcuts, MultiWinGetTabPos,
     MultiWinDeleteHandler, MultiTabGetShowCloseButton,
     MultiTabGetNewTabAdjacent, MultiTabConnectMiscSignals,
-    MultiWinClipboardButtonHandler);
+    MultiWinClipboardButtonHandler, MultiTabGetStatusTooltip);
 
 /* Register a MultiTabSelectionHandler (see above) */
 void
@@ -156,6 +161,11 @@ void multi_tab_set_title_template_locked(MultiTab *, gboolean);
 /* Not the full title */
 const char *multi_tab_get_window_title(MultiTab *);
 
+/* Name of the tab's foreground process, substituted for %p in templates */
+void multi_tab_set_process_name(MultiTab *, const char *);
+
+const char *multi_tab_get_process_name(MultiTab *);
+
 void multi_tab_popup_menu_at_pointer(MultiTab * tab);
 
 gpointer multi_tab_get_user_data(MultiTab *);
@@ -201,6 +211,9 @@ void multi_tab_add_close_button(MultiTab *tab);
 void multi_tab_remove_close_button(MultiTab *tab);
 void multi_tab_set_status_icon_name(MultiTab *tab, const char *name);
 
+/* Refreshes the tab label's tooltip if it's being shown */
+void multi_tab_update_status_tooltip(MultiTab *tab);
+
 void multi_tab_set_middle_click_tab_action(MultiTab *tab, int action);
 
 /* In following functions a zoom_index of -1 means default */
@@ -399,9 +412,10 @@ void multi_win_set_show_add_tab_button(MultiWin *win, gboolean show);
 /* List of all known windows - treat as read-only */
 extern GList *multi_win_all;
 
-/* Sets a title template string. %s is substituted with the current tab's title.
- * There may only be one %s and no other % characters except %%.
- * NULL is equivalent to "%s".
+/* Sets a title template string. %s is substituted with the current tab's title,
+ * %p with the name of its foreground process, %t with its number and %n with
+ * the number of tabs. There may only be one %s and no other % characters
+ * except %%. NULL is equivalent to "%s".
  */
 void multi_win_set_title_template(MultiWin *win, const char *tt);
 
@@ -422,21 +436,23 @@ const char *multi_win_get_shortcuts_scheme_name(MultiWin *win);
 
 guint multi_win_get_num_tabs(MultiWin *win);
 
-/* Parses a geometry string and returns TRUE if successful. If sizes
- * aren't given their respective outputs are set to 0. xy is updated to indicate
- * whether x and y were present.
- */
-gboolean multi_win_parse_geometry(const char *geom,
-        int *width, int *height, int *x, int *y, int *sign_x, int *sign_y, gboolean *xy);
-
 /* tab may be NULL to use the currently active tab */
 void multi_win_set_initial_geometry(MultiWin *win, const char *geom,
         MultiTab *tab);
 
-/* tab may be NULL to use the currently active tab */
+/* tab may be NULL to use the currently active tab. The window is resized
+ * at the next frame, or when the outermost geometry transaction is committed,
+ * and only for the last change requested before then.
+ */
 void multi_win_apply_new_geometry(MultiWin *win, int columns, int rows,
         MultiTab *tab);
 
+/* Geometry changes between these are accumulated and applied once at
+ * commit; they may be nested */
+void multi_win_begin_geometry(MultiWin *win);
+
+void multi_win_commit_geometry(MultiWin *win);
+
 void multi_win_flash_clipboard_indicator(MultiWin *win, gboolean show);
 
 inline static void multi_win_show_clipboard_indicator(MultiWin *win)
@@ -19,6 +19,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include "outputlog.h"
 #include "roxterm.h"
 
 typedef struct Osc52Filter Osc52Filter;
@@ -29,6 +30,21 @@ void osc52filter_remove(Osc52Filter *oflt);
 
 void osc52filter_set_buffer_size(Osc52Filter *oflt, size_t buflen);
 
+/* A filter may exist only to feed an output log, in which case OSC 52
+ * capture is turned off */
+void osc52filter_set_capture(Osc52Filter *oflt, gboolean capture);
+
+/* Takes ownership of log, closing any previous one; log may be NULL */
+void osc52filter_set_log(Osc52Filter *oflt, OutputLog *log);
+
+OutputLog *osc52filter_get_log(Osc52Filter *oflt);
+
+/* Returns the number of bytes read from the pty since the last call */
+gsize osc52filter_take_bytes_read(Osc52Filter *oflt);
+
+/* Bytes held by the filter itself, not including the log */
+gsize osc52filter_get_memory_usage(Osc52Filter *oflt);
+
 #endif /* OSC52FILTER_H */
 
 /* vi:set sw=4 ts=4 et cindent cino= */
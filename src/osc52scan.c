@@ -0,0 +1,250 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+
+#include "osc52scan.h"
+#include "tracepoint.h"
+
+#define ESC_CODE 0x1b
+#define OSC_CODE 0x9d
+#define OSC_AFTER_ESC ']'
+#define TERM_CODE 0x9c
+#define TERM_AFTER_ESC '\\'
+#define BEL_CODE 7
+
+static void osc52scan_cancel_copy(Osc52Scanner *scan)
+{
+    g_debug("osc52: cancelling");
+    TRACEPOINT(osc52_cancel, scan->data_len, scan->state);
+    g_free(scan->data);
+    scan->data = NULL;
+    scan->data_len = 0;
+    if (scan->state == STATE_CAPTURE_OSC52)
+        scan->state = STATE_OTHER_ESC;
+    else if (scan->state == STATE_CAPTURE_TERM_ESC)
+        scan->state = STATE_OTHER_TERM;
+}
+
+void osc52scan_set_buffer_size(Osc52Scanner *scan, size_t buflen)
+{
+    scan->max_buflen = buflen;
+    if (scan->data_len >= buflen && scan->state == STATE_CAPTURE_OSC52)
+    {
+        g_debug("osc52: existing capture exceeds new size limit");
+        osc52scan_cancel_copy(scan);
+    }
+}
+
+inline static guint8 osc52scan_get_next_byte(Osc52Scanner *scan)
+{
+    --scan->buflen;
+    return *(scan->buf++);
+}
+
+inline static void osc52scan_unpeek(Osc52Scanner *scan)
+{
+    ++scan->buflen;
+    scan->buf--;
+}
+
+static inline void osc52scan_set_state(Osc52Scanner *scan, guint8 byte,
+                                         Osc52State state)
+{
+    (void) byte;
+    TRACEPOINT(osc52_state, scan->state, state);
+    scan->state = state;
+}
+
+static void osc52scan_complete_copy(Osc52Scanner *scan)
+{
+    g_debug("osc52: completing");
+    TRACEPOINT(osc52_complete, scan->data_len, 0);
+    scan->copy_func(scan->data, scan->data_len, scan->handle);
+    scan->data = NULL;
+    scan->data_len = 0;
+}
+
+static void osc52scan_capture_buffer(Osc52Scanner *scan)
+{
+    const guint8 *buf_start = scan->buf;
+    guint8 byte = 0;
+    while (scan->buflen)
+    {
+        byte = osc52scan_get_next_byte(scan);
+        if (byte == ESC_CODE)
+        {
+            osc52scan_set_state(scan, byte, STATE_CAPTURE_TERM_ESC);
+            break;
+        }
+        else if (byte == TERM_CODE || byte == BEL_CODE)
+        {
+            osc52scan_set_state(scan, byte, STATE_DEFAULT);
+            break;
+        }
+        else if (byte == '?')
+        {
+            // Clipboard query is not supported
+            g_debug("osc52: Rejecting query ('?')");
+            TRACEPOINT(osc52_reject_query, scan->data_len, 0);
+            osc52scan_cancel_copy(scan);
+            return;
+        }
+    }
+    size_t caplen = scan->buf - buf_start;
+    if (scan->state != STATE_CAPTURE_OSC52)
+        --caplen;
+    TRACEPOINT(osc52_capture, caplen, scan->data_len + caplen);
+    if (caplen)
+    {
+        size_t new_size = scan->data_len + caplen;
+        if (new_size >= scan->max_buflen)
+        {
+            g_debug("osc52: buffer limit exceeded");
+            TRACEPOINT(osc52_overflow, new_size, scan->max_buflen);
+            osc52scan_cancel_copy(scan);
+            return;
+        }
+        // Make sure the capture is terminated by 0 so GLib's base64 decoder
+        // can handle it
+        scan->data = g_realloc(scan->data, new_size + 1);
+        memcpy(scan->data + scan->data_len, buf_start, caplen);
+        scan->data_len = new_size;
+        scan->data[new_size] = 0;
+    }
+    if (scan->state == STATE_DEFAULT)
+    {
+        osc52scan_complete_copy(scan);
+    }
+}
+
+void osc52scan_init(Osc52Scanner *scan, size_t max_buflen,
+        Osc52ScanCopyFunc copy_func, gpointer handle)
+{
+    memset(scan, 0, sizeof(*scan));
+    scan->max_buflen = max_buflen;
+    scan->copy_func = copy_func;
+    scan->handle = handle;
+}
+
+void osc52scan_reset(Osc52Scanner *scan)
+{
+    g_free(scan->data);
+    scan->data = NULL;
+    scan->data_len = 0;
+    scan->state = STATE_DEFAULT;
+}
+
+void osc52scan_feed(Osc52Scanner *scan, const void *buf, size_t len)
+{
+    scan->buf = buf;
+    scan->buflen = len;
+    while (scan->buflen)
+    {
+        guint8 byte = osc52scan_get_next_byte(scan);
+        switch (scan->state)
+        {
+            case STATE_DEFAULT:
+                if (byte == ESC_CODE)
+                    osc52scan_set_state(scan, byte, STATE_ESC_RECEIVED);
+                else if (byte == OSC_CODE)
+                    osc52scan_set_state(scan, byte, STATE_OSC_RECEIVED);
+                break;
+            case STATE_ESC_RECEIVED:
+                if (byte == OSC_AFTER_ESC)
+                    osc52scan_set_state(scan, byte, STATE_OSC_RECEIVED);
+                else if (byte != ESC_CODE)
+                    osc52scan_set_state(scan, byte, STATE_OTHER_ESC);
+                break;
+            case STATE_OSC_RECEIVED:
+                if (byte == '5')
+                {
+                    osc52scan_set_state(scan, byte, STATE_5_RECEIVED);
+                }
+                else
+                {
+                    osc52scan_unpeek(scan);
+                    osc52scan_set_state(scan, byte, STATE_OTHER_ESC);
+                }
+                break;
+            case STATE_5_RECEIVED:
+                if (byte == '2')
+                {
+                    osc52scan_set_state(scan, byte, STATE_52_RECEIVED);
+                }
+                else
+                {
+                    osc52scan_unpeek(scan);
+                    osc52scan_set_state(scan, byte, STATE_OTHER_ESC);
+                }
+                break;
+            case STATE_52_RECEIVED:
+                if (byte == ';')
+                {
+                    osc52scan_set_state(scan, byte, STATE_CAPTURE_OSC52);
+                    osc52scan_capture_buffer(scan);
+                }
+                else
+                {
+                    osc52scan_set_state(scan, byte, STATE_OTHER_ESC);
+                }
+                break;
+            case STATE_CAPTURE_OSC52:
+                // Continuing a capture from a previous chunk; byte is part
+                // of the payload
+                osc52scan_unpeek(scan);
+                osc52scan_capture_buffer(scan);
+                break;
+            case STATE_CAPTURE_TERM_ESC:
+                if (byte == TERM_AFTER_ESC)
+                {
+                    osc52scan_complete_copy(scan);
+                    osc52scan_set_state(scan, byte, STATE_DEFAULT);
+                }
+                else
+                {
+                    osc52scan_cancel_copy(scan);
+                    osc52scan_unpeek(scan);
+                    osc52scan_set_state(scan, byte, STATE_ESC_RECEIVED);
+                }
+                break;
+            case STATE_OTHER_ESC:
+                if (byte == ESC_CODE)
+                    osc52scan_set_state(scan, byte, STATE_OTHER_TERM);
+                else if (byte == TERM_CODE || byte == BEL_CODE)
+                    osc52scan_set_state(scan, byte, STATE_DEFAULT);
+                break;
+            case STATE_OTHER_TERM:
+                if (byte == TERM_AFTER_ESC)
+                {
+                    osc52scan_set_state(scan, byte, STATE_DEFAULT);
+                }
+                else
+                {
+                    osc52scan_unpeek(scan);
+                    osc52scan_set_state(scan, byte, STATE_ESC_RECEIVED);
+                }
+                break;
+        }
+    }
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
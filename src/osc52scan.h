@@ -0,0 +1,73 @@
+#ifndef OSC52SCAN_H
+#define OSC52SCAN_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* The state machine which looks for OSC 52 sequences in a terminal's output
+ * and captures their payloads. It has no dependencies on the terminal, so it
+ * can be tested and benchmarked on its own; osc52filter.c feeds it.
+ */
+
+#include <glib.h>
+
+typedef enum {
+    STATE_DEFAULT,          // Default state, wait for start of Escape sequence
+    STATE_ESC_RECEIVED,     // Just received ESC_CODE
+    STATE_OSC_RECEIVED,     // Just received OSC_CODE or
+                            // ESC_CODE + OSC_AFTER_ESC
+    STATE_5_RECEIVED,       // Received '5' as first digit of OSC number
+    STATE_52_RECEIVED,      // Received "52" as OSC number
+    STATE_CAPTURE_OSC52,    // Got OSC 52, capturing data
+    STATE_CAPTURE_TERM_ESC, // Received ESC_CODE while capturing,
+                            // expecting TERM_AFTER_ESC
+    STATE_OTHER_ESC,        // Waiting for terminator sequence without capture
+    STATE_OTHER_TERM,       // Received ESC_CODE in STATE_OTHER_ESC,
+                            // expecting TERM_AFTER_ESC
+} Osc52State;
+
+/* Called with a complete payload ("c;base64data"), nul-terminated. The
+ * function takes ownership of data. */
+typedef void (*Osc52ScanCopyFunc)(guint8 *data, size_t data_len,
+        gpointer handle);
+
+typedef struct {
+    Osc52State state;
+    size_t max_buflen;
+    guint8 *data;           // data being collected for OSC 52 payload
+    size_t data_len;
+    const guint8 *buf;      // points to next byte to be read from fed buf
+    size_t buflen;          // number of bytes remaining in buf
+    Osc52ScanCopyFunc copy_func;
+    gpointer handle;
+} Osc52Scanner;
+
+void osc52scan_init(Osc52Scanner *scan, size_t max_buflen,
+        Osc52ScanCopyFunc copy_func, gpointer handle);
+
+/* Discards any capture in progress and returns to the default state */
+void osc52scan_reset(Osc52Scanner *scan);
+
+void osc52scan_set_buffer_size(Osc52Scanner *scan, size_t buflen);
+
+/* Scans the next chunk of output; sequences may be split between chunks */
+void osc52scan_feed(Osc52Scanner *scan, const void *buf, size_t len);
+
+#endif /* OSC52SCAN_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,407 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <gio/gio.h>
+
+#include "outputlog.h"
+
+/* Must be a power of 2 */
+#define OUTPUTLOG_RING_SIZE (1 << 20)
+
+/* How long the writer waits for more data before flushing the file. When
+ * there's nothing to flush it waits indefinitely. */
+#define OUTPUTLOG_FLUSH_MS 1000
+
+/* After a write error, data is dropped for this long before trying again */
+#define OUTPUTLOG_RETRY_SECONDS 5
+
+/* Writers which are still finishing after outputlog_close */
+static GMutex outputlog_writers_lock;
+static GCond outputlog_writers_cond;
+static int outputlog_writers = 0;
+
+struct OutputLog {
+    /* The ring is single producer, single consumer. head and tail are
+     * free-running counters which are only written by the producer and
+     * consumer respectively.
+     */
+    guint8 *ring;
+    gint head;
+    gint tail;
+    gint dropped;
+    gint failed;
+    gint stopping;
+    gint refcount;          /* the writer thread and the owner */
+    gint waiting;           /* the writer thread has emptied the ring */
+    int event_fd;
+    GThread *thread;
+
+    /* Only accessed by the writer thread after outputlog_open */
+    char *dir;
+    char *name;
+    guint64 rotate_bytes;
+    guint rotate_seconds;
+    gboolean compress;
+    GOutputStream *stream;
+    guint64 file_bytes;
+    gint64 file_opened;
+    gboolean unflushed;
+    guint dropped_reported;
+    gint64 retry_time;
+};
+
+static void outputlog_close_file(OutputLog *log)
+{
+    GError *error = NULL;
+
+    if (!log->stream)
+        return;
+    if (!g_output_stream_close(log->stream, NULL, &error))
+    {
+        g_warning("Error closing output log: %s", error->message);
+        g_error_free(error);
+    }
+    g_object_unref(log->stream);
+    log->stream = NULL;
+}
+
+static gboolean outputlog_open_file(OutputLog *log)
+{
+    GDateTime *now = g_date_time_new_now_local();
+    char *stamp = g_date_time_format(now, "%Y%m%d-%H%M%S");
+    GFileOutputStream *fstream = NULL;
+    GError *error = NULL;
+    int n;
+
+    g_date_time_unref(now);
+    if (g_mkdir_with_parents(log->dir, 0700))
+    {
+        g_warning("Unable to create output log directory '%s': %s",
+                log->dir, strerror(errno));
+        g_free(stamp);
+        return FALSE;
+    }
+    /* Rotation can happen more than once a second */
+    for (n = 0; !fstream && n < 100; ++n)
+    {
+        char *leaf = n ?
+            g_strdup_printf("%s-%s-%d.log%s", log->name, stamp, n,
+                    log->compress ? ".gz" : "") :
+            g_strdup_printf("%s-%s.log%s", log->name, stamp,
+                    log->compress ? ".gz" : "");
+        char *path = g_build_filename(log->dir, leaf, NULL);
+        GFile *file = g_file_new_for_path(path);
+
+        g_clear_error(&error);
+        fstream = g_file_create(file, G_FILE_CREATE_PRIVATE, NULL, &error);
+        g_object_unref(file);
+        g_free(path);
+        g_free(leaf);
+        if (!fstream && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_EXISTS))
+            break;
+    }
+    g_free(stamp);
+    if (!fstream)
+    {
+        g_warning("Unable to create output log file in '%s': %s",
+                log->dir, error ? error->message : "?");
+        g_clear_error(&error);
+        return FALSE;
+    }
+    if (log->compress)
+    {
+        GZlibCompressor *compressor =
+            g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+
+        log->stream = g_converter_output_stream_new(G_OUTPUT_STREAM(fstream),
+                G_CONVERTER(compressor));
+        g_object_unref(compressor);
+        g_object_unref(fstream);
+    }
+    else
+    {
+        log->stream = G_OUTPUT_STREAM(fstream);
+    }
+    log->file_bytes = 0;
+    log->file_opened = g_get_monotonic_time();
+    return TRUE;
+}
+
+static gboolean outputlog_write_file(OutputLog *log, const void *data,
+        gsize len)
+{
+    GError *error = NULL;
+
+    if (!log->stream && !outputlog_open_file(log))
+        return FALSE;
+    if (!g_output_stream_write_all(log->stream, data, len, NULL, NULL,
+                &error))
+    {
+        g_warning("Error writing output log: %s", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    log->file_bytes += len;
+    log->unflushed = TRUE;
+    return TRUE;
+}
+
+static void outputlog_check_rotation(OutputLog *log)
+{
+    if (!log->stream)
+        return;
+    if ((log->rotate_bytes && log->file_bytes >= log->rotate_bytes) ||
+        (log->rotate_seconds && g_get_monotonic_time() - log->file_opened >=
+                (gint64) log->rotate_seconds * G_USEC_PER_SEC))
+    {
+        outputlog_close_file(log);
+        log->unflushed = FALSE;
+    }
+}
+
+/* Writes a marker for any output which was dropped since the last one.
+ * Returns FALSE if the marker couldn't be written. */
+static gboolean outputlog_note_drops(OutputLog *log)
+{
+    guint dropped = (guint) g_atomic_int_get(&log->dropped);
+    char *msg;
+    gboolean ok;
+
+    if (dropped == log->dropped_reported)
+        return TRUE;
+    msg = g_strdup_printf("\n[roxterm: %u bytes of output not logged]\n",
+            dropped - log->dropped_reported);
+    ok = outputlog_write_file(log, msg, strlen(msg));
+    if (ok)
+        log->dropped_reported = dropped;
+    g_free(msg);
+    return ok;
+}
+
+/* The file is closed so that the next attempt starts a new one */
+static void outputlog_fail(OutputLog *log)
+{
+    g_atomic_int_set(&log->failed, TRUE);
+    log->retry_time = g_get_monotonic_time() +
+            OUTPUTLOG_RETRY_SECONDS * G_USEC_PER_SEC;
+    outputlog_close_file(log);
+    log->unflushed = FALSE;
+}
+
+/* Returns FALSE if the data wasn't written, either because of an error or
+ * because it's too soon after the last one to try again */
+static gboolean outputlog_try_write(OutputLog *log, const void *data,
+        gsize len)
+{
+    gboolean failed = g_atomic_int_get(&log->failed);
+
+    if (failed && g_get_monotonic_time() < log->retry_time)
+        return FALSE;
+    if (!outputlog_note_drops(log) || !outputlog_write_file(log, data, len))
+    {
+        outputlog_fail(log);
+        return FALSE;
+    }
+    if (failed)
+        g_atomic_int_set(&log->failed, FALSE);
+    return TRUE;
+}
+
+static void outputlog_drain(OutputLog *log)
+{
+    guint head = (guint) g_atomic_int_get(&log->head);
+    guint tail = (guint) log->tail;
+
+    while (tail != head)
+    {
+        guint offset = tail & (OUTPUTLOG_RING_SIZE - 1);
+        guint len = MIN(head - tail, OUTPUTLOG_RING_SIZE - offset);
+
+        outputlog_check_rotation(log);
+        if (!outputlog_try_write(log, log->ring + offset, len))
+            g_atomic_int_add(&log->dropped, (gint) len);
+        tail += len;
+        g_atomic_int_set(&log->tail, (gint) tail);
+    }
+    outputlog_check_rotation(log);
+    if (!g_atomic_int_get(&log->failed) && !outputlog_note_drops(log))
+        outputlog_fail(log);
+}
+
+static void outputlog_unref(OutputLog *log)
+{
+    if (!g_atomic_int_dec_and_test(&log->refcount))
+        return;
+    close(log->event_fd);
+    g_free(log->ring);
+    g_free(log->dir);
+    g_free(log->name);
+    g_free(log);
+}
+
+/* Once told to stop, the thread writes anything left in the ring then drops
+ * its reference, so outputlog_close doesn't have to wait for the disk */
+static gpointer outputlog_thread(gpointer handle)
+{
+    OutputLog *log = handle;
+    struct pollfd pfd;
+
+    pfd.fd = log->event_fd;
+    pfd.events = POLLIN;
+    for (;;)
+    {
+        gboolean stopping = g_atomic_int_get(&log->stopping);
+        int result;
+
+        outputlog_drain(log);
+        if (stopping)
+            break;
+        /* Only wake up when more data arrives, not for every write. The ring
+         * must be checked again after setting waiting, in case data arrived
+         * before the producer could see it. If the producer has already
+         * cleared it the eventfd has been written and is read below.
+         */
+        g_atomic_int_set(&log->waiting, TRUE);
+        if ((guint) g_atomic_int_get(&log->head) != (guint) log->tail)
+        {
+            g_atomic_int_compare_and_exchange(&log->waiting, TRUE, FALSE);
+            continue;
+        }
+        pfd.revents = 0;
+        result = poll(&pfd, 1, log->unflushed ? OUTPUTLOG_FLUSH_MS : -1);
+        if (result > 0 && (pfd.revents & POLLIN))
+        {
+            eventfd_t val;
+
+            eventfd_read(log->event_fd, &val);
+        }
+        else if (result == 0 && log->unflushed && log->stream)
+        {
+            if (!g_output_stream_flush(log->stream, NULL, NULL))
+                outputlog_fail(log);
+            log->unflushed = FALSE;
+        }
+    }
+    outputlog_close_file(log);
+    outputlog_unref(log);
+    g_mutex_lock(&outputlog_writers_lock);
+    --outputlog_writers;
+    g_cond_broadcast(&outputlog_writers_cond);
+    g_mutex_unlock(&outputlog_writers_lock);
+    return NULL;
+}
+
+OutputLog *outputlog_open(const char *dir, const char *name,
+        guint64 rotate_bytes, guint rotate_seconds, gboolean compress)
+{
+    OutputLog *log;
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (fd < 0)
+    {
+        g_warning("Unable to create eventfd for output log: %s",
+                strerror(errno));
+        return NULL;
+    }
+    log = g_new0(OutputLog, 1);
+    log->ring = g_malloc(OUTPUTLOG_RING_SIZE);
+    log->event_fd = fd;
+    log->refcount = 2;
+    log->dir = g_strdup(dir);
+    log->name = g_strdup(name);
+    log->rotate_bytes = rotate_bytes;
+    log->rotate_seconds = rotate_seconds;
+    log->compress = compress;
+    g_mutex_lock(&outputlog_writers_lock);
+    ++outputlog_writers;
+    g_mutex_unlock(&outputlog_writers_lock);
+    log->thread = g_thread_new("roxterm-log", outputlog_thread, log);
+    return log;
+}
+
+void outputlog_write(OutputLog *log, const void *data, gsize len)
+{
+    guint head = (guint) log->head;
+    guint tail = (guint) g_atomic_int_get(&log->tail);
+    guint offset = head & (OUTPUTLOG_RING_SIZE - 1);
+    guint first;
+
+    if (len > OUTPUTLOG_RING_SIZE - (head - tail))
+    {
+        g_atomic_int_add(&log->dropped, (gint) len);
+        return;
+    }
+    first = MIN(len, OUTPUTLOG_RING_SIZE - offset);
+    memcpy(log->ring + offset, data, first);
+    if (first < len)
+        memcpy(log->ring, (const guint8 *) data + first, len - first);
+    g_atomic_int_set(&log->head, (gint) (head + len));
+    if (g_atomic_int_compare_and_exchange(&log->waiting, TRUE, FALSE))
+        eventfd_write(log->event_fd, 1);
+}
+
+guint outputlog_get_dropped(OutputLog *log)
+{
+    return (guint) g_atomic_int_get(&log->dropped);
+}
+
+gboolean outputlog_has_failed(OutputLog *log)
+{
+    return g_atomic_int_get(&log->failed);
+}
+
+gsize outputlog_get_memory_usage(OutputLog *log)
+{
+    (void) log;
+    return sizeof(OutputLog) + OUTPUTLOG_RING_SIZE;
+}
+
+void outputlog_close(OutputLog *log)
+{
+    g_atomic_int_set(&log->stopping, TRUE);
+    eventfd_write(log->event_fd, 1);
+    g_thread_unref(log->thread);
+    outputlog_unref(log);
+}
+
+void outputlog_wait_for_writers(guint timeout_ms)
+{
+    gint64 end = g_get_monotonic_time() + timeout_ms * G_TIME_SPAN_MILLISECOND;
+
+    g_mutex_lock(&outputlog_writers_lock);
+    while (outputlog_writers > 0)
+    {
+        if (!g_cond_wait_until(&outputlog_writers_cond,
+                    &outputlog_writers_lock, end))
+        {
+            break;
+        }
+    }
+    g_mutex_unlock(&outputlog_writers_lock);
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
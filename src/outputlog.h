@@ -0,0 +1,64 @@
+#ifndef OUTPUTLOG_H
+#define OUTPUTLOG_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Logs a terminal's output to files without ever blocking the terminal.
+ * Data is copied into a ring buffer which a background thread drains to
+ * disk. If the ring is full the data is dropped and counted, and the writer
+ * thread notes the gap in the log.
+ */
+
+#include <glib.h>
+
+typedef struct OutputLog OutputLog;
+
+/* Files are named dir/name-YYYYmmdd-HHMMSS.log, plus .gz if compress is
+ * TRUE. A new file is started when the current one has had rotate_bytes
+ * written to it (before compression) or is rotate_seconds old; either may be
+ * 0 to disable that kind of rotation. Errors are reported asynchronously via
+ * outputlog_has_failed.
+ */
+OutputLog *outputlog_open(const char *dir, const char *name,
+        guint64 rotate_bytes, guint rotate_seconds, gboolean compress);
+
+/* Must only be called from one thread */
+void outputlog_write(OutputLog *log, const void *data, gsize len);
+
+/* Number of bytes dropped because the ring buffer was full or the log file
+ * couldn't be written */
+guint outputlog_get_dropped(OutputLog *log);
+
+/* TRUE while writes are failing; the writer retries every few seconds and
+ * notes the bytes it dropped in the log when it recovers */
+gboolean outputlog_has_failed(OutputLog *log);
+
+gsize outputlog_get_memory_usage(OutputLog *log);
+
+/* Doesn't wait: the writer thread writes any buffered data in the background
+ * then frees log */
+void outputlog_close(OutputLog *log);
+
+/* Waits up to timeout_ms for closed logs to finish writing, eg before the
+ * process exits */
+void outputlog_wait_for_writers(guint timeout_ms);
+
+#endif /* OUTPUTLOG_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
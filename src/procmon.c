@@ -0,0 +1,345 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "defns.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <glib-unix.h>
+
+#include "procmon.h"
+
+#define PROCMON_INTERVAL_MS 1000
+
+/* Only the foreground process group can be read cheaply from the pty, so
+ * /proc is only checked for background jobs every this many samples */
+#define PROCMON_CHILDREN_SAMPLES 5
+
+/* How long the children flag can be acted on after it was sampled */
+#define PROCMON_FRESH_US (PROCMON_INTERVAL_MS * 1000)
+
+struct ProcMonEntry {
+    GPid pid;
+    int pty_fd;
+    ProcMonHandler handler;
+    gpointer handler_data;
+    pid_t fg_pgrp;
+    char *fg_name;
+    gboolean has_children;
+    gint64 children_checked;    /* Monotonic time has_children was sampled */
+    int fg_pidfd;
+    guint fg_pidfd_tag;
+};
+
+typedef struct {
+    ProcMonRefreshFunc func;
+    gpointer data;
+} ProcMonWaiter;
+
+typedef struct {
+    GArray *pids;           /* GPid */
+    GArray *has_children;   /* gboolean, filled in by the worker */
+} ProcMonBatch;
+
+static GList *procmon_entries = NULL;
+static guint procmon_timer_tag = 0;
+static guint procmon_sample_count = 0;
+static GThreadPool *procmon_pool = NULL;
+static GArray *procmon_waiters = NULL;  /* NULL unless refreshing */
+
+static int procmon_pidfd_open(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return (int) syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void) pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static char *procmon_read_comm(pid_t pid)
+{
+    char *filename = g_strdup_printf("/proc/%d/comm", (int) pid);
+    char *comm = NULL;
+
+    if (g_file_get_contents(filename, &comm, NULL, NULL))
+        g_strchomp(comm);
+    g_free(filename);
+    return comm;
+}
+
+static gboolean procmon_read_has_children(GPid pid)
+{
+    char *filename = g_strdup_printf("/proc/%d/task/%d/children",
+            (int) pid, (int) pid);
+    char *children = NULL;
+    gboolean result = FALSE;
+
+    if (g_file_get_contents(filename, &children, NULL, NULL))
+        result = children[0] != 0;
+    g_free(children);
+    g_free(filename);
+    return result;
+}
+
+static void procmon_unwatch_foreground(ProcMonEntry *entry)
+{
+    if (entry->fg_pidfd_tag)
+    {
+        g_source_remove(entry->fg_pidfd_tag);
+        entry->fg_pidfd_tag = 0;
+    }
+    if (entry->fg_pidfd >= 0)
+    {
+        close(entry->fg_pidfd);
+        entry->fg_pidfd = -1;
+    }
+}
+
+static void procmon_sample(ProcMonEntry *entry, gboolean check_children);
+
+static gboolean procmon_foreground_exited(gint fd, GIOCondition condition,
+        gpointer handle)
+{
+    ProcMonEntry *entry = handle;
+
+    (void) fd;
+    (void) condition;
+    entry->fg_pidfd_tag = 0;
+    procmon_unwatch_foreground(entry);
+    procmon_sample(entry, TRUE);
+    return G_SOURCE_REMOVE;
+}
+
+static void procmon_watch_foreground(ProcMonEntry *entry)
+{
+    procmon_unwatch_foreground(entry);
+    if (entry->fg_pgrp == entry->pid)
+        return;
+    /* The group leader's pid is the same as the pgid */
+    entry->fg_pidfd = procmon_pidfd_open(entry->fg_pgrp);
+    if (entry->fg_pidfd >= 0)
+    {
+        entry->fg_pidfd_tag = g_unix_fd_add(entry->fg_pidfd, G_IO_IN,
+                procmon_foreground_exited, entry);
+    }
+}
+
+static void procmon_sample(ProcMonEntry *entry, gboolean check_children)
+{
+    pid_t pgrp = tcgetpgrp(entry->pty_fd);
+    gboolean had_children = entry->has_children;
+    gboolean changed = FALSE;
+
+    if (pgrp <= 0)
+        pgrp = entry->pid;
+    if (pgrp != entry->fg_pgrp)
+    {
+        entry->fg_pgrp = pgrp;
+        g_free(entry->fg_name);
+        entry->fg_name = procmon_read_comm(pgrp);
+        procmon_watch_foreground(entry);
+        changed = TRUE;
+    }
+    if (pgrp != entry->pid)
+    {
+        entry->has_children = TRUE;
+        entry->children_checked = g_get_monotonic_time();
+    }
+    else if (check_children || changed)
+    {
+        entry->has_children = procmon_read_has_children(entry->pid);
+        entry->children_checked = g_get_monotonic_time();
+    }
+    if ((changed || had_children != entry->has_children) && entry->handler)
+        entry->handler(entry, entry->handler_data);
+}
+
+static gboolean procmon_timer(gpointer handle)
+{
+    gboolean check_children =
+        !(++procmon_sample_count % PROCMON_CHILDREN_SAMPLES);
+    GList *link;
+
+    (void) handle;
+    /* A handler can't remove any entry other than its own, which is why
+     * next is read first */
+    for (link = procmon_entries; link; )
+    {
+        GList *next = link->next;
+
+        procmon_sample(link->data, check_children);
+        link = next;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+ProcMonEntry *procmon_add(GPid pid, int pty_fd,
+        ProcMonHandler handler, gpointer data)
+{
+    ProcMonEntry *entry = g_new0(ProcMonEntry, 1);
+
+    entry->pid = pid;
+    entry->pty_fd = pty_fd;
+    entry->fg_pgrp = pid;
+    entry->fg_pidfd = -1;
+    entry->fg_name = procmon_read_comm(pid);
+    procmon_entries = g_list_prepend(procmon_entries, entry);
+    if (!procmon_timer_tag)
+    {
+        procmon_timer_tag = g_timeout_add(PROCMON_INTERVAL_MS,
+                procmon_timer, NULL);
+    }
+    /* The handler isn't called for the initial state */
+    procmon_sample(entry, TRUE);
+    entry->handler = handler;
+    entry->handler_data = data;
+    return entry;
+}
+
+void procmon_remove(ProcMonEntry *entry)
+{
+    procmon_unwatch_foreground(entry);
+    procmon_entries = g_list_remove(procmon_entries, entry);
+    if (!procmon_entries && procmon_timer_tag)
+    {
+        g_source_remove(procmon_timer_tag);
+        procmon_timer_tag = 0;
+    }
+    g_free(entry->fg_name);
+    g_free(entry);
+}
+
+gboolean procmon_has_children(ProcMonEntry *entry)
+{
+    return entry->has_children;
+}
+
+gboolean procmon_is_fresh(ProcMonEntry *entry)
+{
+    return g_get_monotonic_time() - entry->children_checked <=
+            PROCMON_FRESH_US;
+}
+
+static gboolean procmon_refresh_deliver(gpointer handle)
+{
+    ProcMonBatch *batch = handle;
+    gint64 now = g_get_monotonic_time();
+    GArray *waiters = procmon_waiters;
+    GList *link;
+    guint n;
+
+    /* Entries may have been added or removed meanwhile, so match by pid */
+    for (link = procmon_entries; link; )
+    {
+        ProcMonEntry *entry = link->data;
+        GList *next = link->next;
+
+        for (n = 0; n < batch->pids->len; ++n)
+        {
+            gboolean had_children = entry->has_children;
+
+            if (g_array_index(batch->pids, GPid, n) != entry->pid)
+                continue;
+            entry->has_children =
+                g_array_index(batch->has_children, gboolean, n);
+            entry->children_checked = now;
+            if (had_children != entry->has_children && entry->handler)
+                entry->handler(entry, entry->handler_data);
+            break;
+        }
+        link = next;
+    }
+    g_array_free(batch->pids, TRUE);
+    g_array_free(batch->has_children, TRUE);
+    g_free(batch);
+    /* A waiter may start another refresh */
+    procmon_waiters = NULL;
+    for (n = 0; n < waiters->len; ++n)
+    {
+        ProcMonWaiter *w = &g_array_index(waiters, ProcMonWaiter, n);
+
+        w->func(w->data);
+    }
+    g_array_free(waiters, TRUE);
+    return G_SOURCE_REMOVE;
+}
+
+static void procmon_refresh_worker(gpointer data, gpointer user_data)
+{
+    ProcMonBatch *batch = data;
+    guint n;
+
+    (void) user_data;
+    g_array_set_size(batch->has_children, batch->pids->len);
+    for (n = 0; n < batch->pids->len; ++n)
+    {
+        g_array_index(batch->has_children, gboolean, n) =
+            procmon_read_has_children(g_array_index(batch->pids, GPid, n));
+    }
+    g_idle_add(procmon_refresh_deliver, batch);
+}
+
+void procmon_refresh(ProcMonRefreshFunc func, gpointer data)
+{
+    ProcMonWaiter waiter = { func, data };
+    ProcMonBatch *batch;
+    GList *link;
+
+    if (procmon_waiters)
+    {
+        g_array_append_val(procmon_waiters, waiter);
+        return;
+    }
+    procmon_waiters = g_array_new(FALSE, FALSE, sizeof(ProcMonWaiter));
+    g_array_append_val(procmon_waiters, waiter);
+    batch = g_new(ProcMonBatch, 1);
+    batch->pids = g_array_new(FALSE, FALSE, sizeof(GPid));
+    batch->has_children = g_array_new(FALSE, FALSE, sizeof(gboolean));
+    for (link = procmon_entries; link; link = g_list_next(link))
+    {
+        ProcMonEntry *entry = link->data;
+
+        g_array_append_val(batch->pids, entry->pid);
+    }
+    if (!procmon_pool)
+    {
+        procmon_pool = g_thread_pool_new(procmon_refresh_worker, NULL,
+                1, FALSE, NULL);
+    }
+    g_thread_pool_push(procmon_pool, batch, NULL);
+}
+
+gboolean procmon_is_busy(ProcMonEntry *entry)
+{
+    return entry->fg_pgrp != entry->pid;
+}
+
+const char *procmon_get_foreground_name(ProcMonEntry *entry)
+{
+    return entry->fg_name;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
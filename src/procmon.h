@@ -0,0 +1,67 @@
+#ifndef PROCMON_H
+#define PROCMON_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Keeps track of what each terminal's child is running so that callers can
+ * read cached state instead of going to /proc. All terminals are sampled
+ * together by one timer; the terminal's foreground process group comes from
+ * the pty, and a pidfd on the foreground process reports when it exits
+ * without waiting for the next sample.
+ */
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+typedef struct ProcMonEntry ProcMonEntry;
+
+/* Called when the foreground process or the children flag changes */
+typedef void (*ProcMonHandler)(ProcMonEntry *entry, gpointer data);
+
+/* pty_fd is the master side of the child's pty */
+ProcMonEntry *procmon_add(GPid pid, int pty_fd,
+        ProcMonHandler handler, gpointer data);
+
+void procmon_remove(ProcMonEntry *entry);
+
+/* Whether the child has any children of its own, including background jobs.
+ * Background jobs are only checked every few seconds, so check
+ * procmon_is_fresh before acting on the result. */
+gboolean procmon_has_children(ProcMonEntry *entry);
+
+/* Whether procmon_has_children was sampled recently enough to act on */
+gboolean procmon_is_fresh(ProcMonEntry *entry);
+
+typedef void (*ProcMonRefreshFunc)(gpointer data);
+
+/* Samples every entry's children together in a worker thread, then calls
+ * func on the main thread. If a sample is already in progress func is called
+ * when that one finishes instead of starting another. */
+void procmon_refresh(ProcMonRefreshFunc func, gpointer data);
+
+/* Whether a process other than the child itself is in the foreground */
+gboolean procmon_is_busy(ProcMonEntry *entry);
+
+/* Name of the foreground process, may be NULL */
+const char *procmon_get_foreground_name(ProcMonEntry *entry);
+
+#endif /* PROCMON_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,82 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "defns.h"
+
+#include "profilegui-ui.h"
+#include "resources.h"
+
+/* In the same order as profile_notebook */
+static const char *profilegui_ui_pages[PROFILEGUI_UI_N_PAGES] = {
+    "text", "appearance", "command", "general",
+    "scrolling", "compat", "tabs", "clipboard",
+    "output",
+};
+
+static void profilegui_ui_add_objects(GtkBuilder *builder, char **names)
+{
+    GError *error = NULL;
+
+    if (!gtk_builder_add_objects_from_resource(builder,
+            ROXTERM_RESOURCE_UI, names, &error))
+    {
+        g_error(_("Unable to load GTK UI definitions: %s"), error->message);
+    }
+}
+
+GtkBuilder *profilegui_ui_new(void)
+{
+    static const char *adj_names[] = {
+            "width_adjustment", "height_adjustment",
+            "exit_pause_adjustment", "scrollback_lines_adjustment",
+            "saturation_adjustment", "ssh_port_adjustment",
+            "hspacing_adjustment", "vspacing_adjustment",
+            "osc52_buffer_adjustment", "log_rotate_size_adjustment",
+            "log_rotate_time_adjustment", "flood_threshold_adjustment",
+            "flood_update_rate_adjustment",
+            NULL };
+    static const char *obj_names[] = {
+            "Profile_Editor", "ssh_dialog",
+            "general_entries_size_group", "general_entry_labels_size_group",
+            NULL };
+    GtkBuilder *builder = gtk_builder_new();
+
+    profilegui_ui_add_objects(builder, (char **) adj_names);
+    profilegui_ui_add_objects(builder, (char **) obj_names);
+    return builder;
+}
+
+void profilegui_ui_build_page(GtkBuilder *builder, guint page_num)
+{
+    char *obj_names[2];
+    char *box_name;
+
+    g_return_if_fail(page_num < PROFILEGUI_UI_N_PAGES);
+    obj_names[0] = g_strdup_printf("%s_frame", profilegui_ui_pages[page_num]);
+    obj_names[1] = NULL;
+    profilegui_ui_add_objects(builder, obj_names);
+    box_name = g_strdup_printf("%s_page", profilegui_ui_pages[page_num]);
+    gtk_box_pack_start(GTK_BOX(gtk_builder_get_object(builder, box_name)),
+            GTK_WIDGET(gtk_builder_get_object(builder, obj_names[0])),
+            TRUE, TRUE, 0);
+    g_free(box_name);
+    g_free(obj_names[0]);
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,45 @@
+#ifndef PROFILEGUI_UI_H
+#define PROFILEGUI_UI_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+/* Loads the profile editor's widgets from the UI definition. Each page of
+ * profile_notebook is a separate top-level object, so that it needn't be
+ * loaded until it's first shown. This is shared by profilegui and its
+ * benchmark so that they load exactly the same objects.
+ */
+
+/* Number of pages in profile_notebook */
+#define PROFILEGUI_UI_N_PAGES 9
+
+/* Loads Profile_Editor, ssh_dialog and the objects they depend on, with all
+ * the notebook pages empty */
+GtkBuilder *profilegui_ui_new(void);
+
+/* Loads a page's widgets and packs them into its notebook page */
+void profilegui_ui_build_page(GtkBuilder *builder, guint page_num);
+
+#endif /* PROFILEGUI_UI_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -35,7 +35,7 @@
 #include "gtk/gtk.h"
 #include "options.h"
 #include "profilegui.h"
-#include "resources.h"
+#include "profilegui-ui.h"
 
 #define MANAGE_PREVIEW
 
@@ -59,13 +59,17 @@ struct _ProfileGUI {
         guint ssh_user : 1;
         guint ssh_options : 1;
         guint win_title : 1;
+        guint log_output_dir : 1;
     } changed;
     DragReceiveData *bgimg_drd;
     GtkListStore *list_store;
+    guint pages_built;          /* Bit mask of profile_notebook pages */
 };
 
 static GHashTable *profilegui_being_edited = NULL;
 
+static void profilegui_build_page(ProfileGUI *pg, guint page_num);
+
 static
 GtkWidget *profilegui_widget(ProfileGUI *pg, const char *name)
 {
@@ -104,6 +108,7 @@ void profilegui_check_entries_for_changes(ProfileGUI * pg)
     PG_UPDATE_IF(command)
     PG_UPDATE_IF(title_string)
     PG_UPDATE_IF(win_title)
+    PG_UPDATE_IF(log_output_dir)
 }
 
 static void profilegui_set_command_shading(ProfileGUI *pg)
@@ -162,6 +167,7 @@ void on_editable_changed(GtkEditable * editable, ProfileGUI *pg)
     else PG_IF_CHANGED(ssh_user);
     else PG_IF_CHANGED(ssh_options);
     else PG_IF_CHANGED(win_title);
+    else PG_IF_CHANGED(log_output_dir);
     else if (!strcmp(n, "ssh_port"))
     {
         GtkAdjustment *adj = gtk_spin_button_get_adjustment(
@@ -242,8 +248,8 @@ void on_profile_notebook_switch_page(GtkNotebook * notebook, GtkWidget *page,
 {
     (void) notebook;
     (void) page;
-    (void) page_num;
     profilegui_check_entries_for_changes(pg);
+    profilegui_build_page(pg, page_num);
 }
 
 void on_command_toggled(GtkToggleButton *button, ProfileGUI *pg)
@@ -452,7 +458,23 @@ static gboolean profilegui_font_filter(const PangoFontFamily *family,
     return pango_font_family_is_monospace((PangoFontFamily *) family);
 }
 
-static void profilegui_fill_in_dialog(ProfileGUI * pg)
+static void profilegui_init_kinetic_warning(ProfileGUI *pg)
+{
+    const char *warning_template = _(
+        "Kinetic scrolling is available with vte 0.64 or later. It enhances "
+        "the UX for touch pads and screens, but can be <a href=\"%s\">"
+        "buggy</a>. Enabling \"Scroll in units of pixels\" (vte &gt;= 0.66) or "
+        "disabling \"Limit scrollback\" (vte &lt; 0.66) is advised to mitigate "
+        "against these bugs when Kinetic scrolling is enabled.");
+    static const char *kinetic_bug_url =
+        "https://gitlab.gnome.org/GNOME/vte/-/issues/336";
+    GtkWidget *kinetic_warning_label = profilegui_widget(pg, "kinetic_warning");
+    char *warning = g_strdup_printf(warning_template, kinetic_bug_url);
+    gtk_label_set_markup(GTK_LABEL(kinetic_warning_label), warning);
+    g_free(warning);
+}
+
+static void profilegui_fill_in_text_page(ProfileGUI *pg)
 {
     Options *profile = pg->capp.options;
     char *val;
@@ -462,6 +484,18 @@ static void profilegui_fill_in_dialog(ProfileGUI * pg)
     capplet_set_spin_button(&pg->capp, "hspacing", 0);
     capplet_set_toggle(&pg->capp, "bold_is_bright", FALSE);
     capplet_set_radio(&pg->capp, "text_blink_mode", 0);
+    font_chooser = GTK_FONT_CHOOSER(profilegui_widget(pg, "font_button"));
+    gtk_font_chooser_set_filter_func(font_chooser, profilegui_font_filter,
+            NULL, NULL);
+    gtk_font_chooser_set_font( font_chooser,
+            val = options_lookup_string_with_default(profile,
+                "font", "Monospace 10"));
+    g_free(val);
+}
+
+static void profilegui_fill_in_appearance_page(ProfileGUI *pg)
+{
+    Options *profile = pg->capp.options;
 
     if (options_lookup_int_with_default(profile, "full_screen", 0))
     {
@@ -479,16 +513,50 @@ static void profilegui_fill_in_dialog(ProfileGUI * pg)
     {
         capplet_set_toggle(&pg->capp, "borderless", TRUE);
     }
-    font_chooser = GTK_FONT_CHOOSER(profilegui_widget(pg, "font_button"));
-    gtk_font_chooser_set_filter_func(font_chooser, profilegui_font_filter,
-            NULL, NULL);
-    gtk_font_chooser_set_font( font_chooser,
-            val = options_lookup_string_with_default(profile,
-                "font", "Monospace 10"));
-    g_free(val);
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(profilegui_widget(pg,
                 "show_menubar")), !options_lookup_int_with_default(profile,
             "hide_menubar", FALSE));
+    capplet_set_float_range(&pg->capp, "saturation", 1.0);
+    capplet_set_boolean_toggle(&pg->capp, "always_show_tabs", TRUE);
+    capplet_set_boolean_toggle(&pg->capp, "show_add_tab_btn", TRUE);
+    capplet_set_spin_button(&pg->capp, "width", 80);
+    capplet_set_spin_button(&pg->capp, "height", 24);
+    on_cell_size_toggled(GTK_TOGGLE_BUTTON(profilegui_widget(pg, "cell_size")),
+            pg);
+    profilegui_init_colour_scheme_combos(pg);
+    profilegui_set_colour_scheme_combos(&pg->capp);
+    capplet_set_text_entry(&pg->capp, "win_title", "%s");
+}
+
+static void profilegui_fill_in_command_page(ProfileGUI *pg)
+{
+    Options *profile = pg->capp.options;
+
+    capplet_set_text_entry(&pg->capp, "ssh", NULL);
+    capplet_ignore_changes = TRUE;
+    gtk_toggle_button_set_active(
+            GTK_TOGGLE_BUTTON(profilegui_widget(pg, "use_default_shell")),
+            TRUE);
+    gtk_entry_set_text(GTK_ENTRY(profilegui_widget(pg, "ssh_host")),
+            options_lookup_string_with_default(profile, "ssh_address",
+                    "localhost"));
+    capplet_ignore_changes = FALSE;
+    capplet_set_boolean_toggle(&pg->capp, "use_ssh", FALSE);
+    capplet_set_boolean_toggle(&pg->capp, "login_shell", FALSE);
+    capplet_set_boolean_toggle(&pg->capp, "use_custom_command", FALSE);
+    capplet_set_text_entry(&pg->capp, "command", NULL);
+    capplet_set_combo(&pg->capp, "exit_action", 0);
+    capplet_set_spin_button_float(&pg->capp, "exit_pause");
+    exit_action_changed(
+        GTK_COMBO_BOX(capplet_lookup_widget(&pg->capp, "exit_action")),
+        pg);
+    profilegui_set_command_shading(pg);
+}
+
+static void profilegui_fill_in_general_page(ProfileGUI *pg)
+{
+    Options *profile = pg->capp.options;
+
     capplet_set_boolean_toggle(&pg->capp, "audible_bell", TRUE);
     capplet_set_boolean_toggle(&pg->capp, "bell_highlights_tab", TRUE);
     {
@@ -502,23 +570,11 @@ static void profilegui_fill_in_dialog(ProfileGUI * pg)
     capplet_set_boolean_toggle(&pg->capp, "hide_mouse", TRUE);
     capplet_set_text_entry(&pg->capp, "word_chars", "-,./?%&#:_=+@~");
     capplet_set_text_entry(&pg->capp, "term", NULL);
-    capplet_set_float_range(&pg->capp, "saturation", 1.0);
-    capplet_set_combo(&pg->capp, "tab_pos", 0);
-    capplet_set_boolean_toggle(&pg->capp, "wrap_switch_tab", FALSE);
-    capplet_set_boolean_toggle(&pg->capp, "tab_close_btn", TRUE);
-    capplet_set_boolean_toggle(&pg->capp, "show_tab_status", FALSE);
-    capplet_set_boolean_toggle(&pg->capp, "always_show_tabs", TRUE);
-    capplet_set_boolean_toggle(&pg->capp, "show_add_tab_btn", TRUE);
-    capplet_set_boolean_toggle(&pg->capp, "new_tabs_adjacent", FALSE);
-    capplet_set_boolean_toggle(&pg->capp, "ctrl_tab_shortcut", FALSE);
-    capplet_set_radio(&pg->capp, "middle_click_tab", 0);
-    profilegui_set_close_buttons_shading(pg);
-    capplet_set_text_entry(&pg->capp, "ssh", NULL);
-    /*capplet_set_boolean_toggle(&pg->capp, "match_plain_files", FALSE);*/
-    capplet_set_spin_button(&pg->capp, "width", 80);
-    capplet_set_spin_button(&pg->capp, "height", 24);
-    on_cell_size_toggled(GTK_TOGGLE_BUTTON(profilegui_widget(pg, "cell_size")),
-            pg);
+}
+
+static void profilegui_fill_in_scrolling_page(ProfileGUI *pg)
+{
+    profilegui_init_kinetic_warning(pg);
     capplet_set_boolean_toggle(&pg->capp, "overlay_scrollbar", TRUE);
     capplet_set_radio(&pg->capp, "scrollbar_pos", 1);
     profilegui_set_scrollbar_shading(pg);
@@ -529,6 +585,10 @@ static void profilegui_fill_in_dialog(ProfileGUI * pg)
     gboolean kinetic = capplet_set_boolean_toggle(&pg->capp,
             "kinetic_scrolling", TRUE);
     capplet_set_boolean_toggle(&pg->capp, "pixel_scrolling", kinetic);
+}
+
+static void profilegui_fill_in_compat_page(ProfileGUI *pg)
+{
     capplet_set_combo(&pg->capp, "backspace_binding",
             DEFAULT_BACKSPACE_BINDING);
     capplet_set_combo(&pg->capp, "delete_binding",
@@ -537,29 +597,65 @@ static void profilegui_fill_in_dialog(ProfileGUI * pg)
     capplet_set_boolean_toggle(&pg->capp, "disable_menu_shortcuts", FALSE);
     capplet_set_boolean_toggle(&pg->capp, "disable_tab_menu_shortcuts",
             FALSE);
-    capplet_ignore_changes = TRUE;
-    gtk_toggle_button_set_active(
-            GTK_TOGGLE_BUTTON(profilegui_widget(pg, "use_default_shell")),
-            TRUE);
-    gtk_entry_set_text(GTK_ENTRY(profilegui_widget(pg, "ssh_host")),
-            options_lookup_string_with_default(profile, "ssh_address",
-                    "localhost"));
-    capplet_ignore_changes = FALSE;
-    capplet_set_boolean_toggle(&pg->capp, "use_ssh", FALSE);
-    capplet_set_boolean_toggle(&pg->capp, "login_shell", FALSE);
-    capplet_set_boolean_toggle(&pg->capp, "use_custom_command", FALSE);
-    capplet_set_text_entry(&pg->capp, "command", NULL);
-    capplet_set_combo(&pg->capp, "exit_action", 0);
-    profilegui_set_colour_scheme_combos(&pg->capp);
-    capplet_set_spin_button_float(&pg->capp, "exit_pause");
+}
+
+static void profilegui_fill_in_tabs_page(ProfileGUI *pg)
+{
+    capplet_set_combo(&pg->capp, "tab_pos", 0);
+    capplet_set_boolean_toggle(&pg->capp, "wrap_switch_tab", FALSE);
+    capplet_set_boolean_toggle(&pg->capp, "tab_close_btn", TRUE);
+    capplet_set_boolean_toggle(&pg->capp, "show_tab_status", FALSE);
+    capplet_set_boolean_toggle(&pg->capp, "new_tabs_adjacent", FALSE);
+    capplet_set_boolean_toggle(&pg->capp, "ctrl_tab_shortcut", FALSE);
+    capplet_set_radio(&pg->capp, "middle_click_tab", 0);
+    profilegui_set_close_buttons_shading(pg);
     capplet_set_text_entry(&pg->capp, "title_string", "%t. %s");
-    capplet_set_text_entry(&pg->capp, "win_title", "%s");
+}
+
+static void profilegui_fill_in_clipboard_page(ProfileGUI *pg)
+{
     capplet_set_radio(&pg->capp, "allow_osc52", 0);
     capplet_set_spin_button(&pg->capp, "osc52_buffer_size", 100);
-    exit_action_changed(
-        GTK_COMBO_BOX(capplet_lookup_widget(&pg->capp, "exit_action")),
-        pg);
-    profilegui_set_command_shading(pg);
+}
+
+static void profilegui_fill_in_output_page(ProfileGUI *pg)
+{
+    capplet_set_boolean_toggle(&pg->capp, "log_output", FALSE);
+    capplet_set_text_entry(&pg->capp, "log_output_dir", NULL);
+    capplet_set_boolean_toggle(&pg->capp, "log_compress", FALSE);
+    capplet_set_spin_button(&pg->capp, "log_rotate_size", 10);
+    capplet_set_spin_button(&pg->capp, "log_rotate_time", 0);
+    capplet_set_spin_button(&pg->capp, "flood_threshold", 0);
+    capplet_set_spin_button(&pg->capp, "flood_update_rate", 0);
+}
+
+/* The order matches profile_notebook and the labels in
+ * profilegui_setup_list_store */
+static void (*profilegui_fill_in_page[PROFILEGUI_UI_N_PAGES])(ProfileGUI *) = {
+    profilegui_fill_in_text_page,
+    profilegui_fill_in_appearance_page,
+    profilegui_fill_in_command_page,
+    profilegui_fill_in_general_page,
+    profilegui_fill_in_scrolling_page,
+    profilegui_fill_in_compat_page,
+    profilegui_fill_in_tabs_page,
+    profilegui_fill_in_clipboard_page,
+    profilegui_fill_in_output_page,
+};
+
+/* Pages aren't loaded until they're first shown, see profilegui-ui.h */
+static void profilegui_build_page(ProfileGUI *pg, guint page_num)
+{
+    if (page_num >= PROFILEGUI_UI_N_PAGES ||
+            (pg->pages_built & (1 << page_num)))
+    {
+        return;
+    }
+    pg->pages_built |= 1 << page_num;
+    profilegui_ui_build_page(pg->capp.builder, page_num);
+    profilegui_fill_in_page[page_num](pg);
+    /* Only connects signals for the objects added since the last call */
+    profilegui_connect_handlers(pg);
 }
 
 static gboolean page_selected(GtkTreeSelection *selection,
@@ -584,6 +680,7 @@ static void profilegui_setup_list_store(ProfileGUI *pg)
     static char const *labels[] = {
             N_("Text"), N_("Appearance"), N_("Command"), N_("General"),
             N_("Scrolling"), N_("Keyboard"), N_("Tabs"), N_("Clipboard"),
+            N_("Output"),
     };
     GtkTreeIter iter;
     guint n;
@@ -614,40 +711,12 @@ static void profilegui_setup_list_store(ProfileGUI *pg)
     gtk_widget_show(tvw);
 }
 
-static void profilegui_init_kinetic_warning(ProfileGUI *pg)
-{
-    const char *warning_template = _(
-        "Kinetic scrolling is available with vte 0.64 or later. It enhances "
-        "the UX for touch pads and screens, but can be <a href=\"%s\">"
-        "buggy</a>. Enabling \"Scroll in units of pixels\" (vte &gt;= 0.66) or "
-        "disabling \"Limit scrollback\" (vte &lt; 0.66) is advised to mitigate "
-        "against these bugs when Kinetic scrolling is enabled.");
-    static const char *kinetic_bug_url =
-        "https://gitlab.gnome.org/GNOME/vte/-/issues/336";
-    GtkWidget *kinetic_warning_label = profilegui_widget(pg, "kinetic_warning");
-    char *warning = g_strdup_printf(warning_template, kinetic_bug_url);
-    gtk_label_set_markup(GTK_LABEL(kinetic_warning_label), warning);
-    g_free(warning);
-}
-
 /* Loads a Profile and creates a working dialog box for it */
 ProfileGUI *profilegui_open(const char *profile_name)
 {
     static DynamicOptions *profiles = NULL;
     ProfileGUI *pg;
     char *title;
-    static const char *adj_names[] = {
-            "width_adjustment", "height_adjustment",
-            "exit_pause_adjustment", "scrollback_lines_adjustment",
-            "saturation_adjustment", "ssh_port_adjustment",
-            "hspacing_adjustment", "vspacing_adjustment",
-            "osc52_buffer_adjustment",
-            NULL };
-    static const char *obj_names[] = {
-            "Profile_Editor", "ssh_dialog",
-            "general_entries_size_group", "general_entry_labels_size_group",
-            NULL };
-    GError *error = NULL;
 
     if (!profilegui_being_edited)
     {
@@ -669,14 +738,7 @@ ProfileGUI *profilegui_open(const char *profile_name)
     pg->capp.options = dynamic_options_lookup_and_ref(profiles, profile_name,
         "roxterm profile");
 
-    pg->capp.builder = gtk_builder_new();
-    if (!gtk_builder_add_objects_from_resource(pg->capp.builder,
-            ROXTERM_RESOURCE_UI, (char **) adj_names, &error) ||
-            !gtk_builder_add_objects_from_resource(pg->capp.builder,
-            ROXTERM_RESOURCE_UI, (char **) obj_names, &error))
-    {
-        g_error(_("Unable to load GTK UI definitions: %s"), error->message);
-    }
+    pg->capp.builder = profilegui_ui_new();
     pg->dialog = profilegui_widget(pg, "Profile_Editor");
     pg->ssh_dialog = profilegui_widget(pg, "ssh_dialog");
 
@@ -684,14 +746,12 @@ ProfileGUI *profilegui_open(const char *profile_name)
     gtk_window_set_title(GTK_WINDOW(pg->dialog), title);
     g_free(title);
 
-    profilegui_init_colour_scheme_combos(pg);
-
     profilegui_setup_list_store(pg);
 
     g_hash_table_insert(profilegui_being_edited, g_strdup(profile_name), pg);
 
-    profilegui_init_kinetic_warning(pg);
-    profilegui_fill_in_dialog(pg);
+    profilegui_build_page(pg, gtk_notebook_get_current_page(
+            GTK_NOTEBOOK(profilegui_widget(pg, "profile_notebook"))));
     profilegui_connect_handlers(pg);
 
     gtk_widget_show(pg->dialog);
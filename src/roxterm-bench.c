@@ -0,0 +1,598 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+/* End-to-end benchmark which runs a real roxterm and measures:
+ *
+ *   cold_start:     starting roxterm until the command in its first terminal
+ *                   is running, ie when a shell would show its first prompt
+ *   warm_launch:    a NewTerminal D-Bus launch into the running instance
+ *   new_tab:        the same with --tab
+ *   throughput:     MB/s written to the terminal by its command, without
+ *                   and with the OSC 52 filter in the pty's path
+ *
+ * The commands run in the terminals are this program with --child, which
+ * report back through a FIFO. roxterm's config is redirected to a temporary
+ * XDG_CONFIG_HOME holding the profiles the benchmark needs.
+ *
+ * It needs a display and a D-Bus session bus with no roxterm already on it.
+ * To run headless use eg
+ *
+ *   dbus-run-session -- xvfb-run -a roxterm-bench --roxterm=./roxterm
+ *
+ * or run broadwayd and set GDK_BACKEND=broadway. The run-roxterm-bench
+ * target does the former if the tools are installed.
+ *
+ * Results are written as CSV or JSON, one row/object per benchmark.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#define BENCH_PLAIN_PROFILE "BenchPlain"
+#define BENCH_OSC52_PROFILE "BenchOSC52"
+
+static char *bench_roxterm = "roxterm";
+static int bench_samples = 5;
+static int bench_megabytes = 64;
+static int bench_timeout = 30;
+static char *bench_format = "csv";
+static char *bench_output = NULL;
+static char *bench_child = NULL;
+static char *bench_fifo = NULL;
+
+static GOptionEntry bench_options[] = {
+    { "roxterm", 'r', 0, G_OPTION_ARG_FILENAME, &bench_roxterm,
+        "roxterm executable to benchmark", "PATH" },
+    { "samples", 'n', 0, G_OPTION_ARG_INT, &bench_samples,
+        "Number of samples for each benchmark", "N" },
+    { "megabytes", 'm', 0, G_OPTION_ARG_INT, &bench_megabytes,
+        "Amount of output for throughput benchmarks", "MB" },
+    { "timeout", 't', 0, G_OPTION_ARG_INT, &bench_timeout,
+        "Seconds to wait for each sample", "SECONDS" },
+    { "format", 'f', 0, G_OPTION_ARG_STRING, &bench_format,
+        "csv or json", "FORMAT" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &bench_output,
+        "Write results to FILE instead of stdout", "FILE" },
+    { "child", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_STRING, &bench_child,
+        NULL, NULL },
+    { "fifo", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_FILENAME, &bench_fifo,
+        NULL, NULL },
+    { NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    GArray *values;             /* of double */
+} BenchResult;
+
+typedef struct {
+    char *self;
+    char *tmp_dir;
+    char *fifo;
+    int fifo_fd;
+    char **env;
+    GPid server;
+    GPtrArray *results;         /* of BenchResult * */
+} BenchContext;
+
+/**********************************************/
+/* The commands run inside the terminals */
+
+static void bench_child_report(const char *msg)
+{
+    int fd = open(bench_fifo, O_WRONLY);
+
+    /* Messages are shorter than PIPE_BUF so they're written atomically */
+    if (fd == -1 || write(fd, msg, strlen(msg)) != (ssize_t) strlen(msg))
+        exit(1);
+    close(fd);
+}
+
+static int bench_child_output(void)
+{
+    char block[4096];
+    gsize total = (gsize) bench_megabytes * 1024 * 1024;
+    gsize written = 0;
+    gsize n;
+    gint64 t0;
+    char *msg;
+
+    /* Lines of ordinary text with an SGR sequence at the start of each */
+    for (n = 0; n < sizeof(block); ++n)
+    {
+        if (n % 80 == 79)
+            block[n] = '\n';
+        else
+            block[n] = 'A' + n % 58;
+    }
+    for (n = 0; n + 80 <= sizeof(block); n += 80)
+    {
+        memcpy(block + n, "\033[30m", 5);
+        block[n + 3] = '0' + n / 80 % 8;
+    }
+
+    t0 = g_get_monotonic_time();
+    while (written < total)
+    {
+        ssize_t r = write(1, block, sizeof(block));
+
+        if (r < 0 && errno != EINTR)
+            return 1;
+        if (r > 0)
+            written += r;
+    }
+    msg = g_strdup_printf("output %" G_GSIZE_FORMAT " %" G_GINT64_FORMAT "\n",
+            written, g_get_monotonic_time() - t0);
+    bench_child_report(msg);
+    g_free(msg);
+    return 0;
+}
+
+static int bench_run_child(void)
+{
+    if (!bench_fifo)
+        return 1;
+    if (!strcmp(bench_child, "ready"))
+    {
+        bench_child_report("ready\n");
+        return 0;
+    }
+    else if (!strcmp(bench_child, "hold"))
+    {
+        /* Keeps the first window open so later launches are warm */
+        bench_child_report("ready\n");
+        for (;;)
+            pause();
+    }
+    else if (!strcmp(bench_child, "output"))
+    {
+        return bench_child_output();
+    }
+    return 1;
+}
+
+/**********************************************/
+/* Setup */
+
+static void bench_write_profile(BenchContext *bc, const char *name,
+        int allow_osc52)
+{
+    char *dir = g_build_filename(bc->tmp_dir, "config",
+            "roxterm.sourceforge.net", "Profiles", NULL);
+    char *filename = g_build_filename(dir, name, NULL);
+    char *contents = g_strdup_printf("[roxterm profile]\n"
+            "allow_osc52=%d\n"
+            "flood_threshold=0\n"
+            "log_output=0\n"
+            "scroll_on_output=0\n", allow_osc52);
+    GError *error = NULL;
+
+    g_mkdir_with_parents(dir, 0700);
+    if (!g_file_set_contents(filename, contents, -1, &error))
+        g_error("Unable to write %s: %s", filename, error->message);
+    g_free(contents);
+    g_free(filename);
+    g_free(dir);
+}
+
+static gboolean bench_roxterm_is_running(void)
+{
+    GDBusConnection *conn = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+    GVariant *reply;
+    gboolean owned = FALSE;
+
+    if (!conn)
+    {
+        g_printerr("roxterm-bench: no D-Bus session bus\n");
+        exit(1);
+    }
+    reply = g_dbus_connection_call_sync(conn, "org.freedesktop.DBus",
+            "/org/freedesktop/DBus", "org.freedesktop.DBus", "NameHasOwner",
+            g_variant_new("(s)", "net.sf.roxterm.term"), G_VARIANT_TYPE("(b)"),
+            G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+    if (reply)
+    {
+        g_variant_get(reply, "(b)", &owned);
+        g_variant_unref(reply);
+    }
+    g_object_unref(conn);
+    return owned;
+}
+
+static void bench_init(BenchContext *bc, const char *argv0)
+{
+    GError *error = NULL;
+    char *config;
+
+    bc->self = g_path_is_absolute(argv0) ? g_strdup(argv0) :
+        g_find_program_in_path(argv0);
+    if (!bc->self)
+    {
+        char *cwd = g_get_current_dir();
+
+        bc->self = g_build_filename(cwd, argv0, NULL);
+        g_free(cwd);
+    }
+    bc->tmp_dir = g_dir_make_tmp("roxterm-bench-XXXXXX", &error);
+    if (!bc->tmp_dir)
+        g_error("Unable to create temporary directory: %s", error->message);
+    bc->fifo = g_build_filename(bc->tmp_dir, "fifo", NULL);
+    if (mkfifo(bc->fifo, 0600))
+        g_error("Unable to create %s: %s", bc->fifo, g_strerror(errno));
+    /* Opening for writing too means we never see EOF between children */
+    bc->fifo_fd = open(bc->fifo, O_RDWR | O_NONBLOCK);
+    if (bc->fifo_fd == -1)
+        g_error("Unable to open %s: %s", bc->fifo, g_strerror(errno));
+
+    bench_write_profile(bc, BENCH_PLAIN_PROFILE, 0);
+    bench_write_profile(bc, BENCH_OSC52_PROFILE, 2);
+    config = g_build_filename(bc->tmp_dir, "config", NULL);
+    bc->env = g_environ_setenv(g_get_environ(), "XDG_CONFIG_HOME", config,
+            TRUE);
+    g_free(config);
+    bc->results = g_ptr_array_new();
+}
+
+static void bench_remove_tree(const char *path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    const char *leaf;
+
+    if (dir)
+    {
+        while ((leaf = g_dir_read_name(dir)) != NULL)
+        {
+            char *child = g_build_filename(path, leaf, NULL);
+
+            bench_remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+static void bench_cleanup(BenchContext *bc)
+{
+    if (bc->server)
+    {
+        kill(bc->server, SIGTERM);
+        waitpid(bc->server, NULL, 0);
+    }
+    close(bc->fifo_fd);
+    bench_remove_tree(bc->tmp_dir);
+}
+
+/**********************************************/
+/* Running samples */
+
+/* Waits for a line from a child and returns it, or NULL on timeout */
+static char *bench_read_report(BenchContext *bc)
+{
+    GString *line = g_string_new(NULL);
+    gint64 deadline = g_get_monotonic_time() +
+        (gint64) bench_timeout * G_USEC_PER_SEC;
+
+    for (;;)
+    {
+        struct pollfd pfd = { bc->fifo_fd, POLLIN, 0 };
+        int remaining = (int) ((deadline - g_get_monotonic_time()) / 1000);
+        char c;
+
+        if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0)
+        {
+            g_string_free(line, TRUE);
+            return NULL;
+        }
+        while (read(bc->fifo_fd, &c, 1) == 1)
+        {
+            if (c == '\n')
+                return g_string_free(line, FALSE);
+            g_string_append_c(line, c);
+        }
+    }
+}
+
+static GPid bench_spawn_roxterm(BenchContext *bc, const char *profile,
+        gboolean tab, const char *child_mode)
+{
+    char *profile_arg = g_strdup_printf("--profile=%s", profile);
+    char *child_arg = g_strdup_printf("--child=%s", child_mode);
+    char *fifo_arg = g_strdup_printf("--fifo=%s", bc->fifo);
+    char *mb_arg = g_strdup_printf("--megabytes=%d", bench_megabytes);
+    char *argv[10];
+    int n = 0;
+    GPid pid = 0;
+    GError *error = NULL;
+
+    argv[n++] = bench_roxterm;
+    argv[n++] = profile_arg;
+    argv[n++] = "--atexit=close";
+    if (tab)
+        argv[n++] = "--tab";
+    argv[n++] = "-e";
+    argv[n++] = bc->self;
+    argv[n++] = child_arg;
+    argv[n++] = fifo_arg;
+    argv[n++] = mb_arg;
+    argv[n] = NULL;
+    if (!g_spawn_async(NULL, argv, bc->env,
+            G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+            NULL, NULL, &pid, &error))
+    {
+        g_error("Unable to run %s: %s", bench_roxterm, error->message);
+    }
+    g_free(mb_arg);
+    g_free(fifo_arg);
+    g_free(child_arg);
+    g_free(profile_arg);
+    return pid;
+}
+
+/* Waits for a process to exit, killing it if it takes too long */
+static void bench_reap(GPid pid)
+{
+    int n;
+
+    for (n = 0; n < bench_timeout * 10; ++n)
+    {
+        if (waitpid(pid, NULL, WNOHANG) == pid)
+            return;
+        g_usleep(G_USEC_PER_SEC / 10);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+static BenchResult *bench_result_new(BenchContext *bc,
+        const char *name, const char *unit)
+{
+    BenchResult *r = g_new0(BenchResult, 1);
+
+    r->name = name;
+    r->unit = unit;
+    r->values = g_array_new(FALSE, FALSE, sizeof(double));
+    g_ptr_array_add(bc->results, r);
+    return r;
+}
+
+/* Latency in ms from launching roxterm to its command running */
+static gboolean bench_sample_latency(BenchContext *bc, BenchResult *r,
+        gboolean tab)
+{
+    gint64 t0 = g_get_monotonic_time();
+    GPid pid = bench_spawn_roxterm(bc, BENCH_PLAIN_PROFILE, tab, "ready");
+    char *report = bench_read_report(bc);
+    double ms = (double) (g_get_monotonic_time() - t0) / 1000.0;
+
+    /* For a warm launch this is the D-Bus client, which exits straight away,
+     * for a cold start it's the instance itself, which exits when the
+     * command does */
+    bench_reap(pid);
+    if (!report)
+        return FALSE;
+    g_free(report);
+    g_array_append_val(r->values, ms);
+    return TRUE;
+}
+
+static gboolean bench_sample_throughput(BenchContext *bc, BenchResult *r,
+        const char *profile)
+{
+    GPid pid = bench_spawn_roxterm(bc, profile, FALSE, "output");
+    char *report;
+    guint64 bytes, usec;
+    double mbps;
+
+    bench_reap(pid);
+    report = bench_read_report(bc);
+    if (!report)
+        return FALSE;
+    if (sscanf(report, "output %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
+            &bytes, &usec) != 2 || !usec)
+    {
+        g_free(report);
+        return FALSE;
+    }
+    g_free(report);
+    mbps = (double) bytes / (1024.0 * 1024.0) / ((double) usec / 1.0e6);
+    g_array_append_val(r->values, mbps);
+    return TRUE;
+}
+
+static gboolean bench_start_server(BenchContext *bc)
+{
+    char *report;
+
+    bc->server = bench_spawn_roxterm(bc, BENCH_PLAIN_PROFILE, FALSE, "hold");
+    report = bench_read_report(bc);
+    g_free(report);
+    return report != NULL;
+}
+
+static gboolean bench_run(BenchContext *bc)
+{
+    BenchResult *r;
+    int n;
+
+    r = bench_result_new(bc, "cold_start", "ms");
+    for (n = 0; n < bench_samples; ++n)
+    {
+        if (!bench_sample_latency(bc, r, FALSE))
+            return FALSE;
+    }
+
+    if (!bench_start_server(bc))
+        return FALSE;
+    r = bench_result_new(bc, "warm_launch", "ms");
+    for (n = 0; n < bench_samples; ++n)
+    {
+        if (!bench_sample_latency(bc, r, FALSE))
+            return FALSE;
+    }
+    r = bench_result_new(bc, "new_tab", "ms");
+    for (n = 0; n < bench_samples; ++n)
+    {
+        if (!bench_sample_latency(bc, r, TRUE))
+            return FALSE;
+    }
+    r = bench_result_new(bc, "throughput", "MB/s");
+    for (n = 0; n < bench_samples; ++n)
+    {
+        if (!bench_sample_throughput(bc, r, BENCH_PLAIN_PROFILE))
+            return FALSE;
+    }
+    r = bench_result_new(bc, "throughput_osc52", "MB/s");
+    for (n = 0; n < bench_samples; ++n)
+    {
+        if (!bench_sample_throughput(bc, r, BENCH_OSC52_PROFILE))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**********************************************/
+/* Reporting */
+
+static int bench_compare_doubles(gconstpointer a, gconstpointer b)
+{
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+
+    return da < db ? -1 : da > db;
+}
+
+static void bench_write_results(BenchContext *bc, FILE *fp)
+{
+    gboolean json = !strcmp(bench_format, "json");
+    guint n;
+
+    if (json)
+        fprintf(fp, "{\n  \"benchmarks\": [");
+    else
+        fprintf(fp, "benchmark,unit,samples,min,median,mean,max\n");
+    for (n = 0; n < bc->results->len; ++n)
+    {
+        BenchResult *r = g_ptr_array_index(bc->results, n);
+        GArray *v = r->values;
+        double sum = 0;
+        double median;
+        guint m;
+
+        if (!v->len)
+            continue;
+        g_array_sort(v, bench_compare_doubles);
+        for (m = 0; m < v->len; ++m)
+            sum += g_array_index(v, double, m);
+        median = (v->len % 2) ? g_array_index(v, double, v->len / 2) :
+            (g_array_index(v, double, v->len / 2 - 1) +
+             g_array_index(v, double, v->len / 2)) / 2;
+        if (json)
+        {
+            fprintf(fp, "%s\n    { \"benchmark\": \"%s\", \"unit\": \"%s\", "
+                    "\"samples\": %u, \"min\": %.3f, \"median\": %.3f, "
+                    "\"mean\": %.3f, \"max\": %.3f }",
+                    n ? "," : "", r->name, r->unit, v->len,
+                    g_array_index(v, double, 0), median, sum / v->len,
+                    g_array_index(v, double, v->len - 1));
+        }
+        else
+        {
+            fprintf(fp, "%s,%s,%u,%.3f,%.3f,%.3f,%.3f\n",
+                    r->name, r->unit, v->len,
+                    g_array_index(v, double, 0), median, sum / v->len,
+                    g_array_index(v, double, v->len - 1));
+        }
+    }
+    if (json)
+        fprintf(fp, "\n  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    GOptionContext *octx = g_option_context_new(NULL);
+    GError *error = NULL;
+    BenchContext bc = { 0 };
+    gboolean ok;
+    FILE *fp = stdout;
+
+    g_option_context_add_main_entries(octx, bench_options, NULL);
+    g_option_context_set_summary(octx,
+            "Measures roxterm's startup and launch latency and output "
+            "throughput.");
+    if (!g_option_context_parse(octx, &argc, &argv, &error))
+    {
+        g_printerr("roxterm-bench: %s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(octx);
+    if (bench_child)
+        return bench_run_child();
+    if (strcmp(bench_format, "csv") && strcmp(bench_format, "json"))
+    {
+        g_printerr("roxterm-bench: format must be csv or json\n");
+        return 1;
+    }
+    if (bench_samples < 1)
+        bench_samples = 1;
+    if (bench_roxterm_is_running())
+    {
+        g_printerr("roxterm-bench: roxterm is already running on this "
+                "D-Bus session; use dbus-run-session\n");
+        return 1;
+    }
+
+    bench_init(&bc, argv[0]);
+    ok = bench_run(&bc);
+    bench_cleanup(&bc);
+    if (!ok)
+        g_printerr("roxterm-bench: timed out waiting for roxterm\n");
+
+    if (bench_output)
+    {
+        fp = fopen(bench_output, "w");
+        if (!fp)
+        {
+            g_printerr("roxterm-bench: unable to write %s: %s\n",
+                    bench_output, g_strerror(errno));
+            return 1;
+        }
+    }
+    bench_write_results(&bc, fp);
+    if (fp != stdout)
+        fclose(fp);
+    return ok ? 0 : 1;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,257 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+/* Decodes a trace file written by tracepoint_dump into one line per record,
+ * with the records from all threads merged in time order:
+ *
+ *   seconds tid thread event arg1 arg2
+ *
+ * seconds is relative to the first record, or wall clock time with
+ * --realtime. It only needs GLib so it can be run on a machine without
+ * roxterm's other dependencies, but the file must come from a machine with
+ * the same byte order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tracepoint.h"
+
+typedef struct {
+    TracepointRecord rec;
+    const TracepointRingHeader *ring;
+} DecodedRecord;
+
+static gboolean decode_realtime = FALSE;
+static gboolean decode_csv = FALSE;
+
+static GOptionEntry decode_options[] = {
+    { "realtime", 'r', 0, G_OPTION_ARG_NONE, &decode_realtime,
+        "Show wall clock times instead of relative times", NULL },
+    { "csv", 'c', 0, G_OPTION_ARG_NONE, &decode_csv,
+        "Write CSV", NULL },
+    { NULL }
+};
+
+/* Must match Osc52State in osc52scan.h */
+static const char *decode_osc52_states[] = {
+    "DEFAULT",
+    "ESC_RECEIVED",
+    "OSC_RECEIVED",
+    "5_RECEIVED",
+    "52_RECEIVED",
+    "CAPTURE_OSC52",
+    "CAPTURE_TERM_ESC",
+    "OTHER_ESC",
+    "OTHER_TERM",
+};
+
+static int decode_compare_records(gconstpointer a, gconstpointer b)
+{
+    guint64 ta = ((const DecodedRecord *) a)->rec.time_ns;
+    guint64 tb = ((const DecodedRecord *) b)->rec.time_ns;
+
+    return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/* Event names come from the file rather than this build, so a decoder
+ * built from a different version of roxterm can still read it */
+static const char *decode_event_name(char **names, guint n_names,
+        guint32 event)
+{
+    return event < n_names ? names[event] : "unknown";
+}
+
+static void decode_format_arg(GString *s, const char *event, guint64 arg)
+{
+    if (!strcmp(event, "osc52_state") &&
+            arg < G_N_ELEMENTS(decode_osc52_states))
+    {
+        g_string_append(s, decode_osc52_states[arg]);
+    }
+    else
+    {
+        g_string_append_printf(s, "%" G_GUINT64_FORMAT, arg);
+    }
+}
+
+static gboolean decode_file(const char *filename)
+{
+    char *contents;
+    gsize len;
+    GError *error = NULL;
+    TracepointFileHeader *header;
+    const char *p, *end;
+    char **names;
+    TracepointRingHeader *rings;
+    GArray *records;
+    guint64 base_ns;
+    guint n;
+    GString *line;
+
+    if (!g_file_get_contents(filename, &contents, &len, &error))
+    {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return FALSE;
+    }
+    /* g_file_get_contents' buffer is suitably aligned for the header but
+     * not for what follows the event names, so that's copied out */
+    header = (TracepointFileHeader *) contents;
+    if (len < sizeof(*header) || memcmp(header->magic, TRACEPOINT_MAGIC,
+                sizeof(TRACEPOINT_MAGIC)))
+    {
+        g_printerr("%s is not a roxterm trace file\n", filename);
+        g_free(contents);
+        return FALSE;
+    }
+    if (header->byte_order != TRACEPOINT_BYTE_ORDER)
+    {
+        g_printerr("%s was written on a machine with a different "
+                "byte order\n", filename);
+        g_free(contents);
+        return FALSE;
+    }
+    if (header->version != TRACEPOINT_FORMAT_VERSION ||
+            header->record_size != sizeof(TracepointRecord))
+    {
+        g_printerr("%s has unsupported format version %u\n",
+                filename, header->version);
+        g_free(contents);
+        return FALSE;
+    }
+
+    p = contents + sizeof(*header);
+    end = contents + len;
+    names = g_new0(char *, header->n_events + 1);
+    for (n = 0; n < header->n_events; ++n)
+    {
+        const char *nul = memchr(p, 0, end - p);
+
+        if (!nul)
+            goto truncated;
+        names[n] = g_strdup(p);
+        p = nul + 1;
+    }
+
+    rings = g_new0(TracepointRingHeader, header->n_rings);
+    records = g_array_new(FALSE, FALSE, sizeof(DecodedRecord));
+    for (n = 0; n < header->n_rings; ++n)
+    {
+        TracepointRingHeader *ring = &rings[n];
+        guint r;
+
+        if ((gsize) (end - p) < sizeof(*ring))
+            goto truncated_records;
+        memcpy(ring, p, sizeof(*ring));
+        p += sizeof(*ring);
+        if ((gsize) (end - p) / sizeof(TracepointRecord) < ring->n_records)
+            goto truncated_records;
+        for (r = 0; r < ring->n_records; ++r)
+        {
+            DecodedRecord d;
+
+            memcpy(&d.rec, p, sizeof(d.rec));
+            d.ring = ring;
+            g_array_append_val(records, d);
+            p += sizeof(TracepointRecord);
+        }
+        if (ring->n_lost)
+        {
+            g_printerr("Thread %u lost %u records to ring overflow\n",
+                    ring->tid, ring->n_lost);
+        }
+    }
+    g_array_sort(records, decode_compare_records);
+
+    if (decode_realtime)
+        base_ns = header->dump_monotonic_ns - header->dump_realtime_ns;
+    else if (records->len)
+        base_ns = g_array_index(records, DecodedRecord, 0).rec.time_ns;
+    else
+        base_ns = 0;
+    line = g_string_new(NULL);
+    if (decode_csv)
+        puts("seconds,tid,thread,event,arg1,arg2");
+    for (n = 0; n < records->len; ++n)
+    {
+        const DecodedRecord *d = &g_array_index(records, DecodedRecord, n);
+        const char *event = decode_event_name(names, header->n_events,
+                d->rec.event);
+        /* Unsigned arithmetic gives the right result for realtime */
+        guint64 t = d->rec.time_ns - base_ns;
+        const char *sep = decode_csv ? "," : " ";
+
+        g_string_printf(line, "%" G_GUINT64_FORMAT ".%09" G_GUINT64_FORMAT
+                "%s%u%s%.16s%s%s%s",
+                t / 1000000000, t % 1000000000, sep,
+                d->ring->tid, sep, d->ring->thread_name, sep, event, sep);
+        decode_format_arg(line, event, d->rec.arg1);
+        g_string_append(line, sep);
+        decode_format_arg(line, event, d->rec.arg2);
+        puts(line->str);
+    }
+    g_string_free(line, TRUE);
+    g_array_free(records, TRUE);
+    g_free(rings);
+    g_strfreev(names);
+    g_free(contents);
+    return TRUE;
+
+truncated_records:
+    g_array_free(records, TRUE);
+    g_free(rings);
+truncated:
+    g_printerr("%s is truncated\n", filename);
+    g_strfreev(names);
+    g_free(contents);
+    return FALSE;
+}
+
+int main(int argc, char **argv)
+{
+    GOptionContext *octx;
+    GError *error = NULL;
+    gboolean ok = TRUE;
+    int n;
+
+    octx = g_option_context_new("FILE... - decode roxterm trace files");
+    g_option_context_add_main_entries(octx, decode_options, NULL);
+    if (!g_option_context_parse(octx, &argc, &argv, &error))
+    {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        g_option_context_free(octx);
+        return 2;
+    }
+    g_option_context_free(octx);
+    if (argc < 2)
+    {
+        g_printerr("No trace file given\n");
+        return 2;
+    }
+    for (n = 1; n < argc; ++n)
+        ok = decode_file(argv[n]) && ok;
+    return ok ? 0 : 1;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
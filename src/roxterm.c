@@ -25,7 +25,9 @@
 #include <sys/stat.h>
 #include <sys/fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <pwd.h>
+#include <termios.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -43,14 +45,20 @@
 #include "dlg.h"
 #include "dragrcv.h"
 #include "dynopts.h"
+#include "filecheck.h"
+#include "fontcache.h"
 #include "globalopts.h"
 #include "optsfile.h"
 #include "optsdbus.h"
+#include "mempressure.h"
 #include "osc52filter.h"
+#include "procmon.h"
 #include "roxterm.h"
 #include "multitab.h"
 #include "roxterm-regex.h"
 #include "search.h"
+#include "searchall.h"
+#include "searchindex.h"
 #include "session-file.h"
 #include "shortcuts.h"
 #include "uri.h"
@@ -93,6 +101,8 @@ typedef struct {
     ROXTerm_MatchType type;
 } ROXTerm_MatchMap;
 
+typedef struct SaveBufferJob SaveBufferJob;
+
 struct ROXTermData {
     /* We do not own references to tab or widget */
     MultiTab *tab;
@@ -110,6 +120,10 @@ struct ROXTermData {
     char **actual_commandv;     /* The actual command used */
     char *directory;            /* Copied from global_options_directory */
     GArray *match_map;
+    GHashTable *match_cache;    /* column -> ROXTermCellMatch */
+    glong match_cache_row;
+    guint match_cache_generation;
+    guint contents_generation;  /* Incremented on contents-changed */
     gboolean no_respawn;
     gboolean running;
     DragReceiveData *drd;
@@ -128,13 +142,16 @@ struct ROXTermData {
     gulong win_state_changed_tag;
     GtkWidget *replace_task_dialog;
     gboolean postponed_free;
-    PangoFontDescription *pango_desc;
+    FontCacheEntry *font;       /* NULL for VTE's default font, unzoomed */
     gboolean dont_lookup_dimensions;
     char *reply;
     int columns, rows;
     char **env;
     char *search_pattern;
     guint search_flags;
+    SearchIndex *search_index;
+    glong search_row;       /* Row of last match found via search_index */
+    ProcMonEntry *procmon;
     /*int file_match_tag[2];*/
     gboolean from_session;
     int padding_w, padding_h;
@@ -154,24 +171,184 @@ struct ROXTermData {
     gsize clipboard_offset;
     gsize clipboard_size;
     gboolean clipboard_primary;
+    gsize id;           /* Serial number in registry, 0 if not registered */
+    SaveBufferJob *save_job;
+    gint64 last_viewed;         /* Monotonic time when last selected */
+    gboolean scrollback_trimmed;
+    glong scrollback_lines_lost;    /* Total trimmed since last cleared */
+    gboolean theme_pending;     /* Dark/light change not applied yet */
+    gboolean suspended;         /* Not visible, see roxterm_update_suspended */
+    guint suspended_generation; /* contents_generation when suspended */
+    gboolean iconified;
+    guint activity_pending;     /* ROXTermActivity not shown yet */
+    guint activity_shown;       /* ROXTermActivity already shown */
+    guint activity_tag;
+    gboolean flooding;          /* See roxterm_flood_sample */
+    guint contents_changes;     /* Since last flood sample */
+    gsize flood_rate;           /* Bytes read in last sample */
+    guint flood_calm;           /* Samples below half the threshold */
+    int pause_fd;               /* Slave side of the pty while paused */
+    guint pause_check_tag;
 };
 
 #define PROFILE_NAME_KEY "roxterm_profile_name"
 
-static GList *roxterm_terms = NULL;
-
 static DynamicOptions *roxterm_profiles = NULL;
 
 static void roxterm_apply_profile(ROXTermData * roxterm, VteTerminal * vte,
         gboolean update_geometry);
 
+static void roxterm_save_buffer_cancel(ROXTermData *roxterm);
+
+static void roxterm_update_tab_tooltip(ROXTermData *roxterm);
+
+static void roxterm_scrollback_viewed(ROXTermData *roxterm);
+
+static void roxterm_map_handler(GtkWidget *widget, ROXTermData *roxterm);
+
+static void roxterm_unmap_handler(GtkWidget *widget, ROXTermData *roxterm);
+
+static void roxterm_contents_changed_handler(VteTerminal *vte,
+        ROXTermData *roxterm);
+
 inline static MultiWin *roxterm_get_win(ROXTermData *roxterm)
 {
     return roxterm->tab ? multi_tab_get_parent(roxterm->tab) : NULL;
 }
 
+/******************** Terminal registry *********************/
+
+/* Every terminal attached to a tab is given a serial number which is never
+ * reused, so a stale ROXTERM_ID can't alias a newer terminal which happens to
+ * have been allocated at the same address. roxterm_users maps each profile
+ * and colour scheme to the set of terminals currently using it.
+ */
+static GHashTable *roxterm_registry = NULL;     /* id -> ROXTermData */
+static GHashTable *roxterm_live = NULL;         /* set of ROXTermData */
+static GHashTable *roxterm_users = NULL;        /* Options -> set */
+static gsize roxterm_next_id = 1;
+
+static void roxterm_users_add(Options *opts, ROXTermData *roxterm)
+{
+    GHashTable *users;
+
+    if (!opts || !roxterm->id)
+        return;
+    users = g_hash_table_lookup(roxterm_users, opts);
+    if (!users)
+    {
+        users = g_hash_table_new(NULL, NULL);
+        g_hash_table_insert(roxterm_users, opts, users);
+    }
+    g_hash_table_add(users, roxterm);
+}
+
+static void roxterm_users_remove(Options *opts, ROXTermData *roxterm)
+{
+    GHashTable *users;
+
+    if (!opts || !roxterm->id)
+        return;
+    users = g_hash_table_lookup(roxterm_users, opts);
+    if (users && g_hash_table_remove(users, roxterm)
+            && !g_hash_table_size(users))
+    {
+        g_hash_table_remove(roxterm_users, opts);
+    }
+}
+
+/* Returns a set of the registered terminals using opts, or NULL */
+inline static GHashTable *roxterm_get_users(Options *opts)
+{
+    return roxterm_users ? g_hash_table_lookup(roxterm_users, opts) : NULL;
+}
+
+static void roxterm_register(ROXTermData *roxterm)
+{
+    if (!roxterm_registry)
+    {
+        roxterm_registry = g_hash_table_new(NULL, NULL);
+        roxterm_live = g_hash_table_new(NULL, NULL);
+        roxterm_users = g_hash_table_new_full(NULL, NULL, NULL,
+                (GDestroyNotify) g_hash_table_unref);
+    }
+    roxterm->id = roxterm_next_id++;
+    if (!roxterm_next_id)
+        roxterm_next_id = 1;
+    g_hash_table_insert(roxterm_registry, GSIZE_TO_POINTER(roxterm->id),
+            roxterm);
+    g_hash_table_add(roxterm_live, roxterm);
+    roxterm_users_add(roxterm->profile, roxterm);
+    roxterm_users_add(roxterm->colour_scheme, roxterm);
+}
+
+static void roxterm_unregister(ROXTermData *roxterm)
+{
+    if (!roxterm->id)
+        return;
+    roxterm_users_remove(roxterm->profile, roxterm);
+    roxterm_users_remove(roxterm->colour_scheme, roxterm);
+    g_hash_table_remove(roxterm_registry, GSIZE_TO_POINTER(roxterm->id));
+    g_hash_table_remove(roxterm_live, roxterm);
+    roxterm->id = 0;
+}
+
+ROXTermData *roxterm_from_id(gsize id)
+{
+    return roxterm_registry ?
+        g_hash_table_lookup(roxterm_registry, GSIZE_TO_POINTER(id)) : NULL;
+}
+
+inline static guint roxterm_count(void)
+{
+    return roxterm_registry ? g_hash_table_size(roxterm_registry) : 0;
+}
+
+/****************** End terminal registry *******************/
+
 /*********************** URI handling ***********************/
 
+/* Checking for a match runs every pattern over the text around the pointer,
+ * so the results for each cell are kept until the terminal's contents
+ * change. VTE doesn't say which rows have changed, so any change discards
+ * the cache, as does checking a different row, changing the patterns or
+ * applying a profile.
+ */
+
+typedef struct {
+    char *url;
+    ROXTerm_MatchType type;
+} ROXTermCellMatch;
+
+static void roxterm_cell_match_free(ROXTermCellMatch *match)
+{
+    g_free(match->url);
+    g_free(match);
+}
+
+static void roxterm_clear_match_cache(ROXTermData *roxterm)
+{
+    if (roxterm->match_cache)
+        g_hash_table_remove_all(roxterm->match_cache);
+}
+
+static GHashTable *roxterm_get_match_cache(ROXTermData *roxterm, glong row)
+{
+    if (!roxterm->match_cache)
+    {
+        roxterm->match_cache = g_hash_table_new_full(NULL, NULL, NULL,
+                (GDestroyNotify) roxterm_cell_match_free);
+    }
+    else if (roxterm->match_cache_row != row ||
+            roxterm->match_cache_generation != roxterm->contents_generation)
+    {
+        g_hash_table_remove_all(roxterm->match_cache);
+    }
+    roxterm->match_cache_row = row;
+    roxterm->match_cache_generation = roxterm->contents_generation;
+    return roxterm->match_cache;
+}
+
 static int roxterm_match_add(ROXTermData *roxterm, VteTerminal *vte,
         const char *match, ROXTerm_MatchType type)
 {
@@ -190,6 +367,7 @@ static int roxterm_match_add(ROXTermData *roxterm, VteTerminal *vte,
     map.tag = vte_terminal_match_add_regex(vte, regex, 0);
     vte_terminal_match_set_cursor_name(vte, map.tag, "pointer");
     g_array_append_val(roxterm->match_map, map);
+    roxterm_clear_match_cache(roxterm);
     return map.tag;
 }
 
@@ -218,6 +396,7 @@ static void roxterm_add_matches(ROXTermData *roxterm, VteTerminal *vte)
 #if VTE_CHECK_VERSION(0,50,0)
     vte_terminal_set_allow_hyperlink(vte, roxterm_enable_hyperlinks());
 #endif
+    roxterm_clear_match_cache(roxterm);
 
     for (n = 0; roxterm_regexes[n].regex; ++n)
     {
@@ -349,6 +528,26 @@ static ROXTermData *roxterm_data_clone(ROXTermData *old_gt)
     new_gt->pending_clipboard = NULL;
     new_gt->clipboard_offset = 0;
     new_gt->clipboard_size = 0;
+    new_gt->id = 0;
+    new_gt->save_job = NULL;
+    new_gt->search_index = NULL;
+    new_gt->procmon = NULL;
+    new_gt->last_viewed = g_get_monotonic_time();
+    new_gt->scrollback_trimmed = FALSE;
+    new_gt->scrollback_lines_lost = 0;
+    new_gt->theme_pending = FALSE;
+    new_gt->suspended = FALSE;
+    new_gt->suspended_generation = 0;
+    new_gt->iconified = FALSE;
+    new_gt->activity_pending = 0;
+    new_gt->activity_shown = 0;
+    new_gt->activity_tag = 0;
+    new_gt->flooding = FALSE;
+    new_gt->contents_changes = 0;
+    new_gt->flood_rate = 0;
+    new_gt->flood_calm = 0;
+    new_gt->pause_fd = -1;
+    new_gt->pause_check_tag = 0;
 
     if (old_gt->colour_scheme)
     {
@@ -381,11 +580,10 @@ static ROXTermData *roxterm_data_clone(ROXTermData *old_gt)
 
     new_gt->match_map = g_array_new(FALSE, FALSE, sizeof(ROXTerm_MatchMap));
     new_gt->matched_url = NULL;
+    new_gt->match_cache = NULL;
 
-    if (old_gt->pango_desc)
-    {
-        new_gt->pango_desc = pango_font_description_copy(old_gt->pango_desc);
-    }
+    if (old_gt->font)
+        new_gt->font = font_cache_entry_ref(old_gt->font);
     if (old_gt->widget && gtk_widget_get_realized(old_gt->widget))
     {
         VteTerminal *vte = VTE_TERMINAL(old_gt->widget);
@@ -445,9 +643,9 @@ static char **roxterm_get_environment(ROXTermData *roxterm, const char *term)
     else
         g_hash_table_remove(env, "TERM");
     g_hash_table_replace(env, g_strdup("ROXTERM_ID"),
-            g_strdup_printf("%p", roxterm));
+            g_strdup_printf("%p", GSIZE_TO_POINTER(roxterm->id)));
     g_hash_table_replace(env, g_strdup("ROXTERM_NUM"),
-            g_strdup_printf("%d", g_list_length(roxterm_terms)));
+            g_strdup_printf("%u", roxterm_count()));
     g_hash_table_replace(env, g_strdup("ROXTERM_PID"),
             g_strdup_printf("%d", (int) getpid()));
 
@@ -516,11 +714,18 @@ static void roxterm_show_status(ROXTermData *roxterm, const char *name)
     if (name && !strcmp(name, "dialog-information") &&
             roxterm->status_icon_name &&
             (!strcmp(roxterm->status_icon_name, "dialog-warning") ||
-            !strcmp(roxterm->status_icon_name, "dialog_error")))
+            !strcmp(roxterm->status_icon_name, "dialog_error") ||
+            !strcmp(roxterm->status_icon_name, "emblem-important")))
 
     {
         return;
     }
+    /* Anything else replaces the activity indicators */
+    if (!name || (strcmp(name, "dialog-information") &&
+            strcmp(name, "dialog-warning")))
+    {
+        roxterm->activity_shown = 0;
+    }
     roxterm->status_icon_name = name;
     if (roxterm->tab && options_lookup_int_with_default(roxterm->profile,
             "show_tab_status", FALSE))
@@ -563,13 +768,130 @@ static void roxterm_report_launch_error_async(ROXTermData *roxterm,
     g_idle_add((GSourceFunc) roxterm_command_failed, roxterm);
 }
 
-static Osc52Filter *roxterm_create_osc52_filter(ROXTermData *roxterm)
+static OutputLog *roxterm_open_output_log(ROXTermData *roxterm)
+{
+    char *dir = options_lookup_string(roxterm->profile, "log_output_dir");
+    char *name;
+    int rotate_size = options_lookup_int_with_default(roxterm->profile,
+            "log_rotate_size", 10);
+    int rotate_time = options_lookup_int_with_default(roxterm->profile,
+            "log_rotate_time", 0);
+    OutputLog *log;
+
+    if (!dir || !dir[0])
+    {
+        g_free(dir);
+        dir = g_build_filename(g_get_user_data_dir(), ROXTERM_LEAF_DIR,
+                "logs", NULL);
+    }
+    name = g_strdup_printf("%s-%" G_GSIZE_FORMAT,
+            options_get_leafname(roxterm->profile), roxterm->id);
+    log = outputlog_open(dir, name,
+            (guint64) MAX(rotate_size, 0) * 1024 * 1024,
+            (guint) MAX(rotate_time, 0) * 60,
+            options_lookup_int_with_default(roxterm->profile,
+                    "log_compress", 0));
+    g_free(name);
+    g_free(dir);
+    return log;
+}
+
+/* Default for flood_threshold, in KiB/s; counting bytes needs the pty
+ * filter, so it's off unless set */
+#define ROXTERM_FLOOD_THRESHOLD 0
+
+/* The filter on the pty's fd handles OSC 52, output logging and counting
+ * bytes for flood protection; it's only needed if at least one of them is
+ * enabled. Pass reopen_log if the log options have changed.
+ */
+static void roxterm_update_pty_filter(ROXTermData *roxterm,
+        gboolean reopen_log)
 {
+    gboolean log_output = options_lookup_int_with_default(roxterm->profile,
+            "log_output", 0);
     int buflen = options_lookup_int_with_default(roxterm->profile,
-                                                 "osc52_buffer_size", 100);
-    roxterm->osc52_filter = osc52filter_create(roxterm,
-                                               (size_t) buflen * 1024);
-    return roxterm->osc52_filter;
+            "osc52_buffer_size", 100);
+    int flood_threshold = options_lookup_int_with_default(roxterm->profile,
+            "flood_threshold", ROXTERM_FLOOD_THRESHOLD);
+
+    if (!roxterm->allow_osc52 && !log_output && flood_threshold <= 0)
+    {
+        if (roxterm->osc52_filter)
+        {
+            osc52filter_remove(roxterm->osc52_filter);
+            roxterm->osc52_filter = NULL;
+        }
+        return;
+    }
+    if (!roxterm->osc52_filter)
+    {
+        roxterm->osc52_filter = osc52filter_create(roxterm,
+                (size_t) buflen * 1024);
+        if (!roxterm->osc52_filter)
+            return;
+        reopen_log = TRUE;
+    }
+    else
+    {
+        osc52filter_set_buffer_size(roxterm->osc52_filter,
+                (size_t) buflen * 1024);
+    }
+    osc52filter_set_capture(roxterm->osc52_filter, roxterm->allow_osc52 != 0);
+    if (!log_output)
+    {
+        osc52filter_set_log(roxterm->osc52_filter, NULL);
+    }
+    else if (reopen_log || !osc52filter_get_log(roxterm->osc52_filter))
+    {
+        osc52filter_set_log(roxterm->osc52_filter,
+                roxterm_open_output_log(roxterm));
+    }
+}
+
+/* The busy icon only replaces the plain close icon, not notifications */
+static void roxterm_show_process_status(ROXTermData *roxterm)
+{
+    const char *name = roxterm->status_icon_name;
+
+    if (name && strcmp(name, "window-close") && strcmp(name, "system-run"))
+        return;
+    if (roxterm->procmon && procmon_is_busy(roxterm->procmon))
+        roxterm_show_status(roxterm, "system-run");
+    else if (name && !strcmp(name, "system-run"))
+        roxterm_show_status(roxterm, "window-close");
+}
+
+static void roxterm_process_changed(ProcMonEntry *entry,
+        ROXTermData *roxterm)
+{
+    if (roxterm->tab)
+    {
+        multi_tab_set_process_name(roxterm->tab,
+                procmon_get_foreground_name(entry));
+    }
+    roxterm_show_process_status(roxterm);
+    roxterm_update_tab_tooltip(roxterm);
+}
+
+static void roxterm_stop_procmon(ROXTermData *roxterm)
+{
+    if (roxterm->procmon)
+    {
+        procmon_remove(roxterm->procmon);
+        roxterm->procmon = NULL;
+    }
+}
+
+static void roxterm_start_procmon(ROXTermData *roxterm, VteTerminal *vte)
+{
+    VtePty *pty = vte_terminal_get_pty(vte);
+
+    roxterm_stop_procmon(roxterm);
+    if (!pty)
+        return;
+    roxterm->procmon = procmon_add(roxterm->pid, vte_pty_get_fd(pty),
+            (ProcMonHandler) roxterm_process_changed, roxterm);
+    roxterm_process_changed(roxterm->procmon, roxterm);
 }
 
 /* Mustn't free this error: https://bugzilla.gnome.org/show_bug.cgi?id=793675 */
@@ -583,9 +905,11 @@ static void roxterm_fork_callback(VteTerminal *vte,
     {
         roxterm->widget = NULL;
     }
-    else if (roxterm->allow_osc52)
+    else
     {
-        roxterm_create_osc52_filter(roxterm);
+        roxterm_update_pty_filter(roxterm, FALSE);
+        if (pid > 0)
+            roxterm_start_procmon(roxterm, vte);
     }
     if (pid == -1)
     {
@@ -888,16 +1212,128 @@ static void roxterm_launch_uri(ROXTermData *roxterm,
     }
 }
 
+/* File matches are only treated as links if the file exists. That's
+ * checked in the background, so if a file hasn't been checked yet by the
+ * time it's launched, it's launched when the result arrives. If that takes
+ * too long, or it's clicked again meanwhile, the earlier launch is dropped.
+ */
+
+typedef struct {
+    gsize roxterm_id;
+    char *uri;
+    guint32 timestamp;
+} ROXTermFileLaunch;
+
+/* Returns NULL if uri isn't a local file */
+static char *roxterm_get_file_match_path(const char *uri)
+{
+    char *host = NULL;
+    char *path = g_filename_from_uri(uri, &host, NULL);
+
+    if (path && host && strcmp(host, "localhost") &&
+            strcmp(host, g_get_host_name()))
+    {
+        g_free(path);
+        path = NULL;
+    }
+    g_free(host);
+    return path;
+}
+
+/* Files on other hosts can't be checked, so they're left for the URI
+ * handler to deal with. If abs_path isn't NULL it's set to the absolute path
+ * that was checked, or NULL for a remote file; free it with g_free.
+ */
+static FileCheckResult roxterm_check_file_match(ROXTermData *roxterm,
+        FileCheckHandler handler, gpointer data, char **abs_path)
+{
+    char *path = roxterm_get_file_match_path(roxterm->matched_url);
+    char *cwd;
+    FileCheckResult result;
+
+    if (abs_path)
+        *abs_path = NULL;
+    if (!path)
+        return FILE_CHECK_EXISTS;
+    if (!g_path_is_absolute(path))
+    {
+        char *rel = path;
+
+        cwd = roxterm_get_cwd(roxterm);
+        if (!cwd)
+            cwd = g_get_current_dir();
+        path = g_build_filename(cwd, rel, NULL);
+        g_free(cwd);
+        g_free(rel);
+    }
+    result = file_check(path, NULL, handler, data);
+    if (abs_path)
+        *abs_path = path;
+    else
+        g_free(path);
+    return result;
+}
+
+static void roxterm_file_launch_free(ROXTermFileLaunch *launch)
+{
+    g_free(launch->uri);
+    g_free(launch);
+}
+
+static void roxterm_file_launch_checked(const char *path,
+        FileCheckResult result, gpointer data)
+{
+    ROXTermFileLaunch *launch = data;
+    ROXTermData *roxterm = roxterm_from_id(launch->roxterm_id);
+
+    /* FILE_CHECK_UNKNOWN means it timed out or was superseded */
+    if (roxterm && result == FILE_CHECK_EXISTS)
+    {
+        roxterm_launch_uri(roxterm, launch->uri, launch->timestamp);
+    }
+    else if (roxterm && result == FILE_CHECK_MISSING)
+    {
+        dlg_warning(roxterm_get_toplevel(roxterm),
+                _("Unable to open '%s': file not found"), path);
+    }
+    roxterm_file_launch_free(launch);
+}
+
 static void roxterm_launch_matched_uri(ROXTermData *roxterm, guint32 timestamp)
 {
     const char *m = roxterm->matched_url;
     char *mod = NULL;
+    char *path;
 
     if (roxterm->match_type == ROXTerm_Match_SSH_Host)
     {
         roxterm_launch_ssh(roxterm, roxterm->matched_url);
         return;
     }
+    if (roxterm->match_type == ROXTerm_Match_File)
+    {
+        ROXTermFileLaunch *launch = g_new(ROXTermFileLaunch, 1);
+
+        launch->roxterm_id = roxterm->id;
+        launch->uri = g_strdup(m);
+        launch->timestamp = timestamp;
+        switch (roxterm_check_file_match(roxterm,
+                roxterm_file_launch_checked, launch, &path))
+        {
+            case FILE_CHECK_UNKNOWN:
+                g_free(path);
+                return;
+            case FILE_CHECK_MISSING:
+                /* The handler isn't called for cached results */
+                roxterm_file_launch_checked(path, FILE_CHECK_MISSING, launch);
+                g_free(path);
+                return;
+            default:
+                g_free(path);
+                roxterm_file_launch_free(launch);
+                break;
+        }
+    }
     mod = roxterm_get_modified_uri(roxterm);
     roxterm_launch_uri(roxterm, mod ? mod : m, timestamp);
     g_free(mod);
@@ -928,6 +1364,12 @@ static void roxterm_data_delete(ROXTermData *roxterm)
     }
     if (roxterm->post_exit_tag)
         g_source_remove(roxterm->post_exit_tag);
+    if (roxterm->activity_tag)
+        g_source_remove(roxterm->activity_tag);
+    if (roxterm->pause_check_tag)
+        g_source_remove(roxterm->pause_check_tag);
+    if (roxterm->pause_fd != -1)
+        close(roxterm->pause_fd);
     if (roxterm->colour_scheme)
     {
         UNREF_LOG(colour_scheme_unref(roxterm->colour_scheme));
@@ -938,15 +1380,22 @@ static void roxterm_data_delete(ROXTermData *roxterm)
                 options_get_leafname(roxterm->profile)));
     }
     drag_receive_data_delete(roxterm->drd);
+    if (roxterm->match_cache)
+        g_hash_table_destroy(roxterm->match_cache);
     if (roxterm->actual_commandv != roxterm->commandv)
         g_strfreev(roxterm->actual_commandv);
     if (roxterm->commandv)
         g_strfreev(roxterm->commandv);
     g_free(roxterm->directory);
     g_strfreev(roxterm->env);
-    if (roxterm->pango_desc)
-        pango_font_description_free(roxterm->pango_desc);
+    if (roxterm->font)
+        font_cache_entry_unref(roxterm->font);
     g_free(roxterm->buffer_file_name);
+    if (roxterm->save_job)
+        roxterm_save_buffer_cancel(roxterm);
+    if (roxterm->search_index)
+        search_index_free(roxterm->search_index);
+    roxterm_stop_procmon(roxterm);
     if (roxterm->osc52_filter)
     {
         osc52filter_remove(roxterm->osc52_filter);
@@ -1036,48 +1485,11 @@ roxterm_update_bold_colour(ROXTermData * roxterm, VteTerminal * vte)
             colour_scheme_get_bold_colour(roxterm->colour_scheme, TRUE));
 }
 
-guint16 extrapolate_chroma(guint16 bg, guint16 fg, double factor)
-{
-    gint32 ext = (gint32) bg +
-        (gint32) ((double) ((gint32) fg - (gint32) bg) * factor);
-
-    return (guint16) CLAMP(ext, 0, 0xffff);
-}
-
-static const GdkRGBA *extrapolate_colours(const GdkRGBA *bg,
-        const GdkRGBA *fg, double factor)
-{
-    static GdkRGBA ext;
-
-#define EXTRAPOLATE(c) ext. c = \
-    extrapolate_chroma(bg ? bg->  c : 0, fg ? fg->  c : 0xffff, factor)
-    EXTRAPOLATE(red);
-    EXTRAPOLATE(green);
-    EXTRAPOLATE(blue);
-    return &ext;
-}
-
 static const GdkRGBA *roxterm_get_background_colour_with_transparency(
         ROXTermData * roxterm)
 {
-    const GdkRGBA *bgro =
-            colour_scheme_get_background_colour(roxterm->colour_scheme, TRUE);
-    static GdkRGBA background;
-    float alpha = roxterm_get_config_saturation(roxterm);
-    
-    if (bgro)
-    {
-        background = *bgro;
-    }
-    else if (alpha < 1.0f)
-    {
-        bgro = colour_scheme_get_background_colour(roxterm->colour_scheme,
-                FALSE);
-        background = *bgro;
-        bgro = NULL;
-    }
-    background.alpha = alpha;
-    return (alpha < 1.0f) ? &background : bgro;
+    return colour_scheme_get_background_colour_with_alpha(
+            roxterm->colour_scheme, roxterm_get_config_saturation(roxterm));
 }
 
 static void
@@ -1101,7 +1513,8 @@ roxterm_apply_colour_scheme(ROXTermData *roxterm, VteTerminal *vte)
     if (!ncolours && foreground && background)
     {
         vte_terminal_set_color_bold(vte,
-                extrapolate_colours(background, foreground, 1.2));
+                colour_scheme_get_extrapolated_bold_colour(
+                    roxterm->colour_scheme));
         bold = TRUE;
     }
     bd = colour_scheme_get_bold_colour(roxterm->colour_scheme, TRUE);
@@ -1147,15 +1560,43 @@ roxterm_get_padding(ROXTermData *roxterm, int *width, int *height)
     *height = padding.top + padding.bottom + 2;
 }
 
+/* Remembers a size VTE measured for the terminal's font */
+static void roxterm_cache_cell_size(ROXTermData *roxterm, VteTerminal *vte,
+        int width, int height)
+{
+    if (roxterm->font && gtk_widget_get_realized(GTK_WIDGET(vte)))
+    {
+        font_cache_entry_set_cell_size(roxterm->font,
+                vte_terminal_get_cell_width_scale(vte),
+                vte_terminal_get_cell_height_scale(vte),
+                gtk_widget_get_scale_factor(GTK_WIDGET(vte)),
+                width, height);
+    }
+}
+
+/* The results include spacing (cell-*-scale) */
+static void roxterm_get_cell_size(ROXTermData *roxterm, VteTerminal *vte,
+        int *width, int *height)
+{
+    if (roxterm->font && font_cache_entry_get_cell_size(roxterm->font,
+            vte_terminal_get_cell_width_scale(vte),
+            vte_terminal_get_cell_height_scale(vte),
+            gtk_widget_get_scale_factor(GTK_WIDGET(vte)), width, height))
+    {
+        return;
+    }
+    *width = vte_terminal_get_char_width(vte);
+    *height = vte_terminal_get_char_height(vte);
+    roxterm_cache_cell_size(roxterm, vte, *width, *height);
+}
+
 static void roxterm_geometry_func(ROXTermData *roxterm,
         GdkGeometry *geom, GdkWindowHints *hints)
 {
     VteTerminal *vte = VTE_TERMINAL(roxterm->widget);
 
     roxterm_get_padding(roxterm, &geom->base_width, &geom->base_height);
-    /* The following results include spacing (cell-*-scale) */
-    geom->width_inc = vte_terminal_get_char_width(vte);
-    geom->height_inc = vte_terminal_get_char_height(vte);
+    roxterm_get_cell_size(roxterm, vte, &geom->width_inc, &geom->height_inc);
     geom->min_width = geom->base_width + 4 * geom->width_inc;
     geom->min_height = geom->base_height + 4 * geom->height_inc;
     if (hints)
@@ -1173,12 +1614,12 @@ static void roxterm_size_func(ROXTermData *roxterm, gboolean pixels,
         *pheight = vte_terminal_get_row_count(vte);
     if (pixels)
     {
-        int px, py;
+        int px, py, cw, ch;
 
         roxterm_get_padding(roxterm, &px, &py);
-        /* The following results include spacing (cell-*-scale) */
-        *pwidth = *pwidth * vte_terminal_get_char_width(vte) + px;
-        *pheight = *pheight * vte_terminal_get_char_height(vte) + py;
+        roxterm_get_cell_size(roxterm, vte, &cw, &ch);
+        *pwidth = *pwidth * cw + px;
+        *pheight = *pheight * ch + py;
     }
 }
 
@@ -1208,26 +1649,6 @@ static void roxterm_update_size(ROXTermData * roxterm, VteTerminal * vte)
     roxterm_update_geometry(roxterm, vte);
 }
 
-static void resize_pango_for_zoom(PangoFontDescription *pango_desc,
-        double zf)
-{
-    int size;
-    gboolean abs = FALSE;
-
-    if (zf == 1.0)
-        return;
-    size = pango_font_description_get_size(pango_desc);
-    if (!size)
-        size = 10 * PANGO_SCALE;
-    else
-        abs = pango_font_description_get_size_is_absolute(pango_desc);
-    size = (int) ((double) size * zf);
-    if (abs)
-        pango_font_description_set_absolute_size(pango_desc, size);
-    else
-        pango_font_description_set_size(pango_desc, size);
-}
-
 /* The spacing apply functions don't need to explicitly resize the window
  * because VTE triggers the apropriate signal.
  */
@@ -1249,50 +1670,35 @@ roxterm_apply_hspacing(ROXTermData *roxterm, VteTerminal *vte)
     vte_terminal_set_cell_width_scale(vte, CLAMP(spacing, 0.0, 1.0) + 1.0);
 }
 
-static void
-roxterm_apply_profile_font(ROXTermData *roxterm, VteTerminal *vte,
-    gboolean update_geometry)
+/* With no font in the profile VTE's default is used, but zooming needs a
+ * size to scale, so this works out the same font VTE would use */
+static char *roxterm_get_default_font_spec(VteTerminal *vte)
+{
+    GtkStyleContext *context = gtk_widget_get_style_context(GTK_WIDGET(vte));
+    PangoFontDescription *desc = NULL;
+    char *spec;
+
+    gtk_style_context_get(context, gtk_style_context_get_state(context),
+            GTK_STYLE_PROPERTY_FONT, &desc, NULL);
+    if (!desc)
+        desc = pango_font_description_new();
+    pango_font_description_set_family(desc, "monospace");
+    spec = pango_font_description_to_string(desc);
+    pango_font_description_free(desc);
+    return spec;
+}
+
+/* Takes over the reference to font, which may be NULL for VTE's default */
+static void roxterm_set_font(ROXTermData *roxterm, VteTerminal *vte,
+        FontCacheEntry *font, gboolean update_geometry)
 {
-    char *fdesc;
-    PangoFontDescription *pango_desc = NULL;
     int w = vte_terminal_get_column_count(vte);
     int h = vte_terminal_get_row_count(vte);
 
-    if (roxterm->pango_desc)
-    {
-        pango_font_description_free(roxterm->pango_desc);
-        roxterm->pango_desc = NULL;
-    }
-    fdesc = options_lookup_string(roxterm->profile, "font");
-    double zf = roxterm->target_zoom_factor;
-
-    if (fdesc && fdesc[0])
-    {
-        pango_desc = pango_font_description_from_string(fdesc);
-        if (!pango_desc)
-            g_warning(_("Couldn't create a font from '%s'"), fdesc);
-    }
-    if (!pango_desc)
-    {
-        if (zf == roxterm->current_zoom_factor)
-        {
-            if (fdesc)
-                g_free(fdesc);
-            return;
-        }
-        pango_desc = pango_font_description_copy(
-                vte_terminal_get_font(vte));
-        zf /= roxterm->current_zoom_factor;
-    }
-    if (!pango_desc)
-    {
-        g_free(fdesc);
-        g_return_if_fail(pango_desc != NULL);
-    }
-    resize_pango_for_zoom(pango_desc, zf);
-    vte_terminal_set_font(vte, pango_desc);
-    roxterm->pango_desc = pango_desc;
-    g_free(fdesc);
+    if (roxterm->font)
+        font_cache_entry_unref(roxterm->font);
+    roxterm->font = font;
+    vte_terminal_set_font(vte, font ? font_cache_entry_get_desc(font) : NULL);
     roxterm->current_zoom_factor = roxterm->target_zoom_factor;
     roxterm_apply_vspacing(roxterm, vte);
     roxterm_apply_hspacing(roxterm, vte);
@@ -1303,33 +1709,39 @@ roxterm_apply_profile_font(ROXTermData *roxterm, VteTerminal *vte,
 }
 
 static void
-roxterm_update_font(ROXTermData *roxterm, VteTerminal *vte,
+roxterm_apply_profile_font(ROXTermData *roxterm, VteTerminal *vte,
     gboolean update_geometry)
 {
-    PangoFontDescription *pango_desc = NULL;
-    double zf;
-    int w, h;
+    char *spec = options_lookup_string(roxterm->profile, "font");
+    FontCacheEntry *font = NULL;
 
-    if (!roxterm->pango_desc)
+    if (spec && spec[0])
+        font = font_cache_lookup(spec, roxterm->target_zoom_factor);
+    if (!font && roxterm->target_zoom_factor != 1.0)
     {
-        roxterm_apply_profile_font(roxterm, vte, update_geometry);
-        return;
+        g_free(spec);
+        spec = roxterm_get_default_font_spec(vte);
+        font = font_cache_lookup(spec, roxterm->target_zoom_factor);
     }
-    w = vte_terminal_get_column_count(vte);
-    h = vte_terminal_get_row_count(vte);
-    zf = roxterm->target_zoom_factor /
-            (roxterm->current_zoom_factor ?
-                    roxterm->current_zoom_factor : 1);
-    pango_desc = roxterm->pango_desc;
-    resize_pango_for_zoom(pango_desc, zf);
-    vte_terminal_set_font(vte, pango_desc);
-    roxterm->current_zoom_factor = roxterm->target_zoom_factor;
-    roxterm_apply_vspacing(roxterm, vte);
-    roxterm_apply_hspacing(roxterm, vte);
-    if (update_geometry)
+    g_free(spec);
+    roxterm_set_font(roxterm, vte, font, update_geometry);
+}
+
+/* Keeps the current font, which may not be the profile's if it was restored
+ * from a session, at the new zoom factor */
+static void
+roxterm_update_font(ROXTermData *roxterm, VteTerminal *vte,
+    gboolean update_geometry)
+{
+    if (!roxterm->font)
     {
-        roxterm_set_vte_size(roxterm, vte, w, h);
+        roxterm_apply_profile_font(roxterm, vte, update_geometry);
+        return;
     }
+    roxterm_set_font(roxterm, vte,
+            font_cache_lookup(font_cache_entry_get_spec(roxterm->font),
+                    roxterm->target_zoom_factor),
+            update_geometry);
 }
 
 static void roxterm_set_zoom_factor(ROXTermData *roxterm, double factor,
@@ -1358,6 +1770,12 @@ static void roxterm_match_text_size(ROXTermData *roxterm, ROXTermData *other)
     roxterm->target_zoom_factor = other->current_zoom_factor;
     roxterm->current_zoom_factor = other->current_zoom_factor;
     roxterm->zoom_index = other->zoom_index;
+    if (roxterm->font != other->font)
+    {
+        if (roxterm->font)
+            font_cache_entry_unref(roxterm->font);
+        roxterm->font = other->font ? font_cache_entry_ref(other->font) : NULL;
+    }
     if (!pango_font_description_equal(
             vte_terminal_get_font(VTE_TERMINAL(roxterm->widget)), fd))
     {
@@ -1383,14 +1801,57 @@ static gboolean roxterm_popup_handler(GtkWidget * widget, ROXTermData * roxterm)
     return TRUE;
 }
 
-/* Checks whether a button event position is over a matched expression; if so
- * roxterm->matched_url is set and the result is TRUE */
-static gboolean roxterm_check_match(ROXTermData *roxterm, VteTerminal *vte,
+/* Works out which cell an event is over in the same way as VTE, with row
+ * numbers counted from the start of the scrollback */
+static gboolean roxterm_get_event_cell(ROXTermData *roxterm, VteTerminal *vte,
+        GdkEvent *event, glong *column, glong *row)
+{
+    GtkBorder padding;
+    double x, y;
+    int cw, ch;
+
+    if (!gdk_event_get_coords(event, &x, &y))
+        return FALSE;
+    roxterm_get_cell_size(roxterm, vte, &cw, &ch);
+    if (cw <= 0 || ch <= 0)
+        return FALSE;
+    gtk_style_context_get_padding(gtk_widget_get_style_context(roxterm->widget),
+            gtk_widget_get_state_flags(roxterm->widget), &padding);
+    x -= padding.left;
+    y -= padding.top;
+    if (x < 0 || y < 0)
+        return FALSE;
+    *column = (glong) x / cw;
+    *row = (glong) ((y + gtk_adjustment_get_value(
+            gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte))) * ch) / ch);
+    return TRUE;
+}
+
+static gboolean roxterm_find_match(ROXTermData *roxterm, VteTerminal *vte,
         GdkEvent *event)
 {
     int tag;
+    glong column, row;
+    GHashTable *cache = NULL;
+    ROXTermCellMatch *match;
+#if VTE_CHECK_VERSION(0,50,0)
+    char *hyper;
+#endif
+
+    if (roxterm_get_event_cell(roxterm, vte, event, &column, &row))
+    {
+        cache = roxterm_get_match_cache(roxterm, row);
+        match = g_hash_table_lookup(cache, GINT_TO_POINTER(column));
+        if (match)
+        {
+            g_free(roxterm->matched_url);
+            roxterm->matched_url = g_strdup(match->url);
+            roxterm->match_type = match->type;
+            return roxterm->matched_url != NULL;
+        }
+    }
 #if VTE_CHECK_VERSION(0,50,0)
-    char *hyper = roxterm_enable_hyperlinks() ?
+    hyper = roxterm_enable_hyperlinks() ?
         vte_terminal_hyperlink_check_event(vte, event) : NULL;
 #endif
 
@@ -1413,15 +1874,41 @@ static gboolean roxterm_check_match(ROXTermData *roxterm, VteTerminal *vte,
         roxterm->matched_url = hyper;
     }
 #endif
+    if (cache)
+    {
+        match = g_new(ROXTermCellMatch, 1);
+        match->url = g_strdup(roxterm->matched_url);
+        match->type = roxterm->match_type;
+        g_hash_table_insert(cache, GINT_TO_POINTER(column), match);
+    }
     return roxterm->matched_url != NULL;
 }
 
-static void roxterm_clear_hold_over_uri(ROXTermData *roxterm)
+/* Checks whether a button event position is over a matched expression; if so
+ * roxterm->matched_url is set and the result is TRUE. A file that's known
+ * not to exist isn't a match; otherwise checking it is started now so the
+ * result is likely to be ready if it's launched.
+ */
+static gboolean roxterm_check_match(ROXTermData *roxterm, VteTerminal *vte,
+        GdkEvent *event)
 {
-    if (roxterm->hold_over_uri)
+    if (roxterm_find_match(roxterm, vte, event) &&
+            roxterm->match_type == ROXTerm_Match_File &&
+            roxterm_check_file_match(roxterm, NULL, NULL, NULL) ==
+                FILE_CHECK_MISSING)
     {
-        g_signal_handler_disconnect(roxterm->widget, roxterm->hold_handler_id);
-        roxterm->hold_over_uri = FALSE;
+        g_free(roxterm->matched_url);
+        roxterm->matched_url = NULL;
+    }
+    return roxterm->matched_url != NULL;
+}
+
+static void roxterm_clear_hold_over_uri(ROXTermData *roxterm)
+{
+    if (roxterm->hold_over_uri)
+    {
+        g_signal_handler_disconnect(roxterm->widget, roxterm->hold_handler_id);
+        roxterm->hold_over_uri = FALSE;
     }
 }
 
@@ -1691,12 +2178,65 @@ static void roxterm_shade_save_buffer_menu_item(ROXTermData *roxterm)
         MENUTREE_FILE_SAVE_BUFFER, shade);
 }
 
+static void roxterm_shade_cancel_save_buffer_menu_item(ROXTermData *roxterm)
+{
+    MultiWin *win = roxterm_get_win(roxterm);
+    gboolean shade = roxterm->save_job == NULL;
+
+    if (!win || roxterm->tab != multi_win_get_current_tab(win))
+        return;
+    menutree_shade(multi_win_get_menu_bar(win),
+        MENUTREE_FILE_CANCEL_SAVE_BUFFER, shade);
+    menutree_shade(multi_win_get_popup_menu(win),
+        MENUTREE_FILE_CANCEL_SAVE_BUFFER, shade);
+}
+
+/* Output can also be restarted from the keyboard with ^Q, or any key with
+ * IXANY, without us being told, so the slave side of the pty is kept open
+ * while paused and polled: it has no room for writing while it's stopped.
+ */
+static gboolean roxterm_output_is_paused(ROXTermData *roxterm)
+{
+    struct pollfd pfd;
+
+    if (roxterm->pause_fd == -1)
+        return FALSE;
+    pfd.fd = roxterm->pause_fd;
+    pfd.events = POLLOUT;
+    if (poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLOUT))
+    {
+        close(roxterm->pause_fd);
+        roxterm->pause_fd = -1;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Only the current tab's state is shown */
+static void roxterm_update_pause_output_label(ROXTermData *roxterm)
+{
+    MultiWin *win = roxterm_get_win(roxterm);
+    MenuTree *mtree;
+    gboolean paused;
+
+    if (!win || roxterm->tab != multi_win_get_current_tab(win))
+        return;
+    paused = roxterm_output_is_paused(roxterm);
+    if ((mtree = multi_win_get_menu_bar(win)) != NULL)
+        menutree_change_pause_output_label(mtree, paused);
+    if ((mtree = multi_win_get_popup_menu(win)) != NULL)
+        menutree_change_pause_output_label(mtree, paused);
+}
+
 static void roxterm_tab_selection_handler(ROXTermData * roxterm, MultiTab * tab)
 {
     MultiWin *win = roxterm_get_win(roxterm);
     (void) tab;
 
     roxterm->status_icon_name = NULL;
+    roxterm->activity_shown = 0;
+    roxterm_show_process_status(roxterm);
+    roxterm_scrollback_viewed(roxterm);
     check_preferences_submenu_pair(roxterm,
             MENUTREE_PREFERENCES_SELECT_PROFILE,
             options_get_leafname(roxterm->profile));
@@ -1708,6 +2248,8 @@ static void roxterm_tab_selection_handler(ROXTermData * roxterm, MultiTab * tab)
             options_get_leafname(multi_win_get_shortcut_scheme(win)));
     roxterm_shade_search_menu_items(roxterm);
     roxterm_shade_save_buffer_menu_item(roxterm);
+    roxterm_shade_cancel_save_buffer_menu_item(roxterm);
+    roxterm_update_pause_output_label(roxterm);
 
     multi_win_set_ignore_toggles(win, TRUE);
     multi_win_set_ignore_toggles(win, FALSE);
@@ -1802,6 +2344,90 @@ static void roxterm_reset_and_clear_action(MultiWin * win)
 
     g_return_if_fail(roxterm);
     vte_terminal_reset(VTE_TERMINAL(roxterm->widget), TRUE, TRUE);
+    if (roxterm->scrollback_lines_lost)
+    {
+        roxterm->scrollback_lines_lost = 0;
+        roxterm_update_tab_tooltip(roxterm);
+    }
+}
+
+/* Stopping output on the pty's slave side holds the program's writes in the
+ * kernel until output is restarted */
+static void roxterm_pause_output_action(MultiWin * win)
+{
+    ROXTermData *roxterm = multi_win_get_user_data_for_current_tab(win);
+    VtePty *pty;
+    char name[64];
+    int fd;
+
+    if (!roxterm || !roxterm->widget)
+        return;
+    pty = vte_terminal_get_pty(VTE_TERMINAL(roxterm->widget));
+    if (!pty || !roxterm->running)
+        return;
+    if (roxterm_output_is_paused(roxterm))
+    {
+        if (tcflow(roxterm->pause_fd, TCOON))
+        {
+            dlg_warning(roxterm_get_toplevel(roxterm),
+                    _("Unable to resume output: %s"), strerror(errno));
+        }
+        else
+        {
+            close(roxterm->pause_fd);
+            roxterm->pause_fd = -1;
+        }
+    }
+    else
+    {
+        if (ptsname_r(vte_pty_get_fd(pty), name, sizeof(name)) ||
+            (fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK)) == -1)
+        {
+            dlg_warning(roxterm_get_toplevel(roxterm),
+                    _("Unable to open terminal device: %s"), strerror(errno));
+            return;
+        }
+        if (tcflow(fd, TCOOFF))
+        {
+            dlg_warning(roxterm_get_toplevel(roxterm),
+                    _("Unable to pause output: %s"), strerror(errno));
+            close(fd);
+        }
+        else
+        {
+            roxterm->pause_fd = fd;
+        }
+    }
+    roxterm_update_pause_output_label(roxterm);
+    roxterm_update_tab_tooltip(roxterm);
+}
+
+static gboolean roxterm_pause_check(gpointer data)
+{
+    ROXTermData *roxterm = data;
+
+    roxterm->pause_check_tag = 0;
+    if (!roxterm_output_is_paused(roxterm))
+    {
+        roxterm_update_pause_output_label(roxterm);
+        roxterm_update_tab_tooltip(roxterm);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/* Typing may have restarted paused output; VTE writes it to the pty later,
+ * so check shortly afterwards */
+static void roxterm_commit_handler(VteTerminal *vte, char *text, guint size,
+        ROXTermData *roxterm)
+{
+    (void) vte;
+    (void) text;
+    (void) size;
+    if (roxterm->pause_fd != -1 && !roxterm->pause_check_tag)
+    {
+        roxterm->pause_check_tag = g_timeout_add(100,
+                roxterm_pause_check, roxterm);
+    }
 }
 
 static void roxterm_respawn_action(MultiWin * win)
@@ -1880,12 +2506,17 @@ static void roxterm_open_search_action(MultiWin *win)
     search_open_dialog(roxterm);
 }
 
+static void roxterm_open_search_all_action(MultiWin *win)
+{
+    search_all_open_dialog(GTK_WINDOW(multi_win_get_widget(win)));
+}
+
 static void roxterm_find_next_action(MultiWin *win)
 {
     ROXTermData *roxterm = multi_win_get_user_data_for_current_tab(win);
 
     g_return_if_fail(roxterm);
-    vte_terminal_search_find_next(VTE_TERMINAL(roxterm->widget));
+    roxterm_search_find(roxterm, FALSE);
 }
 
 static void roxterm_find_prev_action(MultiWin *win)
@@ -1893,7 +2524,7 @@ static void roxterm_find_prev_action(MultiWin *win)
     ROXTermData *roxterm = multi_win_get_user_data_for_current_tab(win);
 
     g_return_if_fail(roxterm);
-    vte_terminal_search_find_previous(VTE_TERMINAL(roxterm->widget));
+    roxterm_search_find(roxterm, TRUE);
 }
 
 static void roxterm_show_about(MultiWin * win)
@@ -2007,8 +2638,8 @@ roxterm_char_size_changed(GtkSettings * settings, guint arg1, guint arg2,
     ROXTermData * roxterm)
 {
     (void) settings;
-    (void) arg1;
-    (void) arg2;
+    roxterm_cache_cell_size(roxterm, VTE_TERMINAL(roxterm->widget),
+            (int) arg1, (int) arg2);
     roxterm_update_geometry(roxterm, VTE_TERMINAL(roxterm->widget));
 }
 
@@ -2097,7 +2728,7 @@ static gboolean roxterm_post_child_exit(ROXTermData *roxterm)
 static void roxterm_child_exited(VteTerminal *vte, int status,
         ROXTermData *roxterm)
 {
-    if (!g_list_find(roxterm_terms, roxterm))
+    if (!roxterm_is_valid(roxterm))
     {
         g_warning("roxterm_child_exited for widget %p: data %p not listed",
                 vte, roxterm);
@@ -2108,6 +2739,15 @@ static void roxterm_child_exited(VteTerminal *vte, int status,
     (void) status;
 
     roxterm->running = FALSE;
+    if (roxterm->pause_fd != -1)
+    {
+        close(roxterm->pause_fd);
+        roxterm->pause_fd = -1;
+    }
+    roxterm_update_pause_output_label(roxterm);
+    roxterm_stop_procmon(roxterm);
+    if (roxterm->tab)
+        multi_tab_set_process_name(roxterm->tab, NULL);
     roxterm_show_status(roxterm, "dialog-error");
     RoxtermChildExitAction action = roxterm_get_child_exit_action(roxterm);
     if (action != Roxterm_ChildExitAsk &&
@@ -2134,6 +2774,9 @@ static void roxterm_change_profile(ROXTermData *roxterm, Options *profile)
 {
     if (roxterm->profile != profile)
     {
+        MultiWin *win = roxterm_get_win(roxterm);
+
+        roxterm_users_remove(roxterm->profile, roxterm);
         if (roxterm->profile)
         {
             dynamic_options_unref(roxterm_profiles,
@@ -2141,14 +2784,19 @@ static void roxterm_change_profile(ROXTermData *roxterm, Options *profile)
         }
         roxterm->profile = profile;
         options_ref(roxterm->profile);
+        roxterm_users_add(profile, roxterm);
         /* Force profile's font */
-        if (roxterm->pango_desc)
+        if (roxterm->font)
         {
-            pango_font_description_free(roxterm->pango_desc);
-            roxterm->pango_desc = NULL;
+            font_cache_entry_unref(roxterm->font);
+            roxterm->font = NULL;
         }
+        if (win)
+            multi_win_begin_geometry(win);
         roxterm_apply_profile(roxterm, VTE_TERMINAL(roxterm->widget), FALSE);
         roxterm_update_size(roxterm, VTE_TERMINAL(roxterm->widget));
+        if (win)
+            multi_win_commit_geometry(win);
     }
 }
 
@@ -2157,10 +2805,12 @@ static void roxterm_change_colour_scheme(ROXTermData *roxterm,
 {
     if (roxterm->colour_scheme != colour_scheme)
     {
+        roxterm_users_remove(roxterm->colour_scheme, roxterm);
         if (roxterm->colour_scheme)
             colour_scheme_unref(roxterm->colour_scheme);
         roxterm->colour_scheme = colour_scheme;
         options_ref(colour_scheme);
+        roxterm_users_add(colour_scheme, roxterm);
         roxterm_apply_colour_scheme(roxterm, VTE_TERMINAL(roxterm->widget));
     }
 }
@@ -2359,36 +3009,116 @@ static void roxterm_shortcuts_selected(GtkCheckMenuItem *mitem,
     shortcuts_unref(shortcuts);
 }
 
-static void roxterm_text_changed_handler(VteTerminal *vte, ROXTermData *roxterm)
+/******************** Activity indicators *********************/
+
+/* Output and bells can arrive thousands of times a second, so the handlers
+ * only record them, and the tab's status icon and attention flashing are
+ * updated at most once per frame. The window's urgency hint is set straight
+ * away, because it's how a minimized window gets noticed. Each kind of
+ * activity is only shown once until the tab is selected.
+ */
+
+typedef enum {
+    ROXTERM_ACTIVITY_OUTPUT = 1,
+    ROXTERM_ACTIVITY_BELL = 2
+} ROXTermActivity;
+
+#define ROXTERM_ACTIVITY_UPDATE_MS 16
+
+static void roxterm_set_bell_urgency(ROXTermData *roxterm)
 {
-    (void) vte;
-    if (roxterm->tab != multi_win_get_current_tab(roxterm_get_win(roxterm)))
+    GtkWindow *gwin = roxterm_get_toplevel(roxterm);
+
+    if (gwin && options_lookup_int_with_default(roxterm->profile,
+            "bell_highlights_tab", TRUE) &&
+            !gtk_window_is_active(gwin) && !gtk_window_get_urgency_hint(gwin))
     {
-        roxterm_show_status(roxterm, "dialog-information");
+        gtk_window_set_urgency_hint(gwin, TRUE);
     }
 }
 
-static void roxterm_bell_handler(VteTerminal *vte, ROXTermData *roxterm)
+static void roxterm_show_activity(ROXTermData *roxterm)
 {
     MultiWin *win = roxterm_get_win(roxterm);
-    (void) vte;
+    guint pending = roxterm->activity_pending;
+    gboolean current;
 
-    if (roxterm->tab != multi_win_get_current_tab(win))
+    roxterm->activity_pending = 0;
+    if (!win || !roxterm->tab)
+        return;
+    current = roxterm->tab == multi_win_get_current_tab(win);
+    if (pending & ROXTERM_ACTIVITY_BELL)
     {
-        roxterm_show_status(roxterm, "dialog-warning");
+        if (!current)
+            roxterm_show_status(roxterm, "dialog-warning");
+        if (!current && options_lookup_int_with_default(roxterm->profile,
+                "bell_highlights_tab", TRUE))
+        {
+            multi_tab_draw_attention(roxterm->tab);
+        }
     }
-    if (options_lookup_int_with_default(roxterm->profile,
-            "bell_highlights_tab", TRUE))
+    else if ((pending & ROXTERM_ACTIVITY_OUTPUT) && !current)
     {
-        GtkWindow *gwin = GTK_WINDOW(multi_win_get_widget(win));
+        roxterm_show_status(roxterm, "dialog-information");
+    }
+    /* The current tab has no indicators, so it has to keep checking */
+    if (!current)
+        roxterm->activity_shown |= pending;
+}
 
-        if (roxterm->tab != multi_win_get_current_tab(win))
-            multi_tab_draw_attention(roxterm->tab);
-        if (!gtk_window_is_active(gwin))
-            gtk_window_set_urgency_hint(gwin, TRUE);
+static gboolean roxterm_activity_timeout(ROXTermData *roxterm)
+{
+    roxterm->activity_tag = 0;
+    roxterm_show_activity(roxterm);
+    return G_SOURCE_REMOVE;
+}
+
+/* The tab indicators aren't drawn while the window is minimized, they're
+ * brought up to date when it's restored */
+static void roxterm_schedule_activity(ROXTermData *roxterm)
+{
+    if (roxterm->activity_pending && !roxterm->iconified &&
+            !roxterm->activity_tag)
+    {
+        roxterm->activity_tag = g_timeout_add(ROXTERM_ACTIVITY_UPDATE_MS,
+                (GSourceFunc) roxterm_activity_timeout, roxterm);
     }
 }
 
+static void roxterm_note_activity(ROXTermData *roxterm,
+        ROXTermActivity activity)
+{
+    if ((roxterm->activity_shown | roxterm->activity_pending) & activity)
+        return;
+    roxterm->activity_pending |= activity;
+    if (activity == ROXTERM_ACTIVITY_BELL)
+        roxterm_set_bell_urgency(roxterm);
+    roxterm_schedule_activity(roxterm);
+}
+
+static void roxterm_text_changed_handler(VteTerminal *vte, ROXTermData *roxterm)
+{
+    (void) vte;
+    /* Only a notebook's current page is mapped, so if this terminal isn't
+     * suspended it's already on show */
+    if (roxterm->suspended)
+        roxterm_note_activity(roxterm, ROXTERM_ACTIVITY_OUTPUT);
+}
+
+static void roxterm_bell_handler(VteTerminal *vte, ROXTermData *roxterm)
+{
+    GtkWindow *gwin = roxterm_get_toplevel(roxterm);
+
+    (void) vte;
+    /* The urgency hint is the only thing a bell can change for the current
+     * tab */
+    if (!roxterm->suspended && gwin && gtk_window_is_active(gwin))
+        return;
+    roxterm_note_activity(roxterm, ROXTERM_ACTIVITY_BELL);
+}
+
+/****************** End activity indicators *******************/
+
 /* Ignore keys which are shortcuts, otherwise they get sent to terminal
  * when menu item is shaded.
  */
@@ -2439,45 +3169,300 @@ static void roxterm_resize_window_handler(VteTerminal *vte,
     roxterm_set_vte_size(roxterm, vte, columns, rows);
 }
 
-static void roxterm_save_buffer(ROXTermData *roxterm)
+/* Returns the text of rows start_row up to but not including end_row, with a
+ * newline after each row that doesn't wrap onto the next */
+static char *roxterm_get_text_rows(VteTerminal *vte,
+        glong start_row, glong end_row, gsize *len)
 {
-    GFile *gfile = g_file_new_for_path(roxterm->buffer_file_name);
-    GError *error = NULL;
-    GFileOutputStream *stream = g_file_replace(gfile, NULL, FALSE,
-        G_FILE_CREATE_NONE, NULL, &error);
-    gboolean result = FALSE;
-    if (stream)
-    {
-        GOutputStream *ostream = G_OUTPUT_STREAM(stream);
-        result = vte_terminal_write_contents_sync(
-            VTE_TERMINAL(roxterm->widget),
-            ostream,
-            VTE_WRITE_DEFAULT,
-            NULL,
-            &error);
-        // Don't overwrite write error if close fails too
-        g_output_stream_close(ostream, NULL, result ? &error : NULL);
-        if (result && error)
-        {
-            const char *msg = error ? error->message : NULL;
-            if (!msg) msg = "NULL";
-            g_critical("Error closing '%s' after saving buffer: %s",
-                roxterm->buffer_file_name, msg);
-        }
+    glong columns = vte_terminal_get_column_count(vte);
+    char *text;
+
+#if VTE_CHECK_VERSION(0, 76, 0)
+    text = vte_terminal_get_text_range_format(vte, VTE_FORMAT_TEXT,
+            start_row, 0, end_row - 1, columns, len);
+#else
+    text = vte_terminal_get_text_range(vte, start_row, 0, end_row - 1, columns,
+            NULL, NULL, NULL);
+    *len = text ? strlen(text) : 0;
+#endif
+    if (!text)
+        *len = 0;
+    return text;
+}
+
+/* Saving the buffer copies the rows out of VTE a chunk at a time from an idle
+ * callback, which has to be on the main thread, and writes each chunk to the
+ * file asynchronously before copying the next, so neither a large buffer nor
+ * a slow filesystem blocks the UI. The rows to save are fixed when the save
+ * starts; output arriving meanwhile isn't included. The job refers to its
+ * terminal by id in case the terminal is destroyed while the save is still in
+ * progress.
+ */
+#define SAVE_BUFFER_CHUNK_ROWS 2000
+
+struct SaveBufferJob {
+    gsize roxterm_id;
+    char *filename;
+    glong next_row;
+    glong end_row;
+    glong total_rows;
+    int percent;
+    char *chunk;
+    guint idle_tag;
+    GOutputStream *stream;
+    GCancellable *cancellable;
+};
+
+static void roxterm_save_buffer_job_free(SaveBufferJob *job)
+{
+    if (job->idle_tag)
+        g_source_remove(job->idle_tag);
+    if (job->stream)
+        g_object_unref(job->stream);
+    g_object_unref(job->cancellable);
+    g_free(job->chunk);
+    g_free(job->filename);
+    g_free(job);
+}
+
+static void roxterm_save_buffer_show_progress(ROXTermData *roxterm,
+        SaveBufferJob *job)
+{
+    if (!roxterm->tab)
+        return;
+    if (job)
+        roxterm_show_status(roxterm, "document-save");
+    else if (!g_strcmp0(roxterm->status_icon_name, "document-save"))
+        roxterm_show_status(roxterm, NULL);
+    roxterm_shade_cancel_save_buffer_menu_item(roxterm);
+    roxterm_update_tab_tooltip(roxterm);
+}
+
+static void roxterm_save_buffer_discarded(GObject *stream, GAsyncResult *res,
+        gpointer handle)
+{
+    g_output_stream_close_finish(G_OUTPUT_STREAM(stream), res, NULL);
+    roxterm_save_buffer_job_free(handle);
+}
+
+/* Detaches the job from its terminal (if it still exists) and reports any
+ * error, then frees the job. If the save failed or was cancelled the stream
+ * is closed with the cancelled cancellable so that g_file_replace discards
+ * the partial file instead of replacing the original.
+ */
+static void roxterm_save_buffer_finish(SaveBufferJob *job, GError *error)
+{
+    ROXTermData *roxterm = roxterm_from_id(job->roxterm_id);
+
+    if (roxterm && roxterm->save_job == job)
+    {
+        roxterm->save_job = NULL;
+        roxterm_save_buffer_show_progress(roxterm, NULL);
     }
-    if (!result)
+    if (error && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     {
-        const char *msg = error ? error->message : NULL;
-        if (!msg)
-            msg = _("Unknown error");
-        dlg_critical(roxterm_get_toplevel(roxterm),
+        dlg_critical(roxterm ? roxterm_get_toplevel(roxterm) : NULL,
             _("Unable to save buffer to '%s': %s"),
-            roxterm->buffer_file_name, msg);
+            job->filename, error->message);
     }
-    if (error)
+    if (error && job->stream)
     {
+        g_cancellable_cancel(job->cancellable);
+        g_output_stream_close_async(job->stream, G_PRIORITY_DEFAULT,
+                job->cancellable, roxterm_save_buffer_discarded, job);
+        return;
+    }
+    roxterm_save_buffer_job_free(job);
+}
+
+static void roxterm_save_buffer_cancelled(SaveBufferJob *job)
+{
+    GError *error = g_error_new_literal(G_IO_ERROR, G_IO_ERROR_CANCELLED,
+            "Cancelled");
+
+    roxterm_save_buffer_finish(job, error);
+    g_error_free(error);
+}
+
+static void roxterm_save_buffer_closed(GObject *stream, GAsyncResult *res,
+        gpointer handle)
+{
+    SaveBufferJob *job = handle;
+    GError *error = NULL;
+
+    if (!g_output_stream_close_finish(G_OUTPUT_STREAM(stream), res, &error))
+    {
+        /* The stream is already closed, don't try again */
+        g_clear_object(&job->stream);
+        roxterm_save_buffer_finish(job, error);
         g_error_free(error);
+        return;
     }
+    roxterm_save_buffer_finish(job, NULL);
+}
+
+static void roxterm_save_buffer_queue_chunk(SaveBufferJob *job);
+
+static void roxterm_save_buffer_chunk_written(GObject *stream,
+        GAsyncResult *res, gpointer handle)
+{
+    SaveBufferJob *job = handle;
+    GError *error = NULL;
+
+    g_clear_pointer(&job->chunk, g_free);
+    if (!g_output_stream_write_all_finish(G_OUTPUT_STREAM(stream), res,
+                NULL, &error))
+    {
+        roxterm_save_buffer_finish(job, error);
+        g_error_free(error);
+        return;
+    }
+    roxterm_save_buffer_queue_chunk(job);
+}
+
+static gboolean roxterm_save_buffer_copy_chunk(gpointer handle)
+{
+    SaveBufferJob *job = handle;
+    ROXTermData *roxterm = roxterm_from_id(job->roxterm_id);
+    VteTerminal *vte;
+    glong first_row, end_row;
+    gsize len;
+    int percent;
+
+    job->idle_tag = 0;
+    if (!roxterm || roxterm->save_job != job)
+    {
+        /* Cancelled or superseded after the last chunk was written */
+        roxterm_save_buffer_cancelled(job);
+        return G_SOURCE_REMOVE;
+    }
+    vte = VTE_TERMINAL(roxterm->widget);
+    /* Rows that have scrolled out of the history since the save started are
+     * lost */
+    first_row = (glong) gtk_adjustment_get_lower(
+            gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte)));
+    job->next_row = MAX(job->next_row, first_row);
+    if (job->next_row >= job->end_row)
+    {
+        g_output_stream_close_async(job->stream, G_PRIORITY_DEFAULT,
+                job->cancellable, roxterm_save_buffer_closed, job);
+        return G_SOURCE_REMOVE;
+    }
+    end_row = MIN(job->next_row + SAVE_BUFFER_CHUNK_ROWS, job->end_row);
+    job->chunk = roxterm_get_text_rows(vte, job->next_row, end_row, &len);
+    percent = (int) (100 - (job->end_row - end_row) * 100 /
+            MAX(job->total_rows, 1));
+    job->next_row = end_row;
+    if (percent != job->percent)
+    {
+        job->percent = percent;
+        roxterm_save_buffer_show_progress(roxterm, job);
+    }
+    if (!len)
+    {
+        g_clear_pointer(&job->chunk, g_free);
+        roxterm_save_buffer_queue_chunk(job);
+        return G_SOURCE_REMOVE;
+    }
+    g_output_stream_write_all_async(job->stream, job->chunk, len,
+            G_PRIORITY_DEFAULT, job->cancellable,
+            roxterm_save_buffer_chunk_written, job);
+    return G_SOURCE_REMOVE;
+}
+
+/* Copying is at idle priority so that the terminal still gets redrawn and
+ * handles input between chunks */
+static void roxterm_save_buffer_queue_chunk(SaveBufferJob *job)
+{
+    job->idle_tag = g_idle_add(roxterm_save_buffer_copy_chunk, job);
+}
+
+static void roxterm_save_buffer_opened(GObject *file, GAsyncResult *res,
+        gpointer handle)
+{
+    SaveBufferJob *job = handle;
+    GError *error = NULL;
+    GFileOutputStream *fstream = g_file_replace_finish(G_FILE(file), res,
+            &error);
+
+    if (!fstream)
+    {
+        roxterm_save_buffer_finish(job, error);
+        g_error_free(error);
+        return;
+    }
+    if (g_str_has_suffix(job->filename, ".gz"))
+    {
+        GZlibCompressor *compressor =
+            g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+
+        job->stream = g_converter_output_stream_new(G_OUTPUT_STREAM(fstream),
+                G_CONVERTER(compressor));
+        g_object_unref(compressor);
+        g_object_unref(fstream);
+    }
+    else
+    {
+        job->stream = G_OUTPUT_STREAM(fstream);
+    }
+    roxterm_save_buffer_queue_chunk(job);
+}
+
+/* The job is freed when its pending callback sees the cancellation */
+static void roxterm_save_buffer_cancel(ROXTermData *roxterm)
+{
+    if (roxterm->save_job)
+    {
+        g_cancellable_cancel(roxterm->save_job->cancellable);
+        roxterm->save_job = NULL;
+        roxterm_save_buffer_show_progress(roxterm, NULL);
+    }
+}
+
+/* Returns FALSE if a save is already in progress and the user chose not to
+ * cancel it */
+static gboolean roxterm_save_buffer_check_busy(ROXTermData *roxterm)
+{
+    GtkWidget *w;
+    int response;
+
+    if (!roxterm->save_job)
+        return TRUE;
+    w = dlg_ok_cancel(roxterm_get_toplevel(roxterm),
+            _("Cancel saving buffer?"),
+            _("The buffer is still being saved to '%s'. "
+            "Do you want to cancel that and start again?"),
+            roxterm->save_job->filename);
+    response = gtk_dialog_run(GTK_DIALOG(w));
+    gtk_widget_destroy(w);
+    if (response != GTK_RESPONSE_OK)
+        return FALSE;
+    roxterm_save_buffer_cancel(roxterm);
+    return TRUE;
+}
+
+/* A filename ending in .gz causes the buffer to be compressed with gzip */
+static void roxterm_save_buffer(ROXTermData *roxterm)
+{
+    GtkAdjustment *adj = gtk_scrollable_get_vadjustment(
+            GTK_SCROLLABLE(roxterm->widget));
+    SaveBufferJob *job;
+    GFile *gfile;
+
+    job = g_new0(SaveBufferJob, 1);
+    job->roxterm_id = roxterm->id;
+    job->filename = g_strdup(roxterm->buffer_file_name);
+    job->next_row = (glong) gtk_adjustment_get_lower(adj);
+    job->end_row = (glong) gtk_adjustment_get_upper(adj);
+    job->total_rows = job->end_row - job->next_row;
+    job->cancellable = g_cancellable_new();
+    roxterm->save_job = job;
+    roxterm_save_buffer_show_progress(roxterm, job);
+    gfile = g_file_new_for_path(job->filename);
+    g_file_replace_async(gfile, NULL, FALSE, G_FILE_CREATE_NONE,
+            G_PRIORITY_DEFAULT, job->cancellable,
+            roxterm_save_buffer_opened, job);
+    g_object_unref(gfile);
 }
 
 static void roxterm_save_buffer_as_action(MultiWin *win)
@@ -2501,7 +3486,8 @@ static void roxterm_save_buffer_as_action(MultiWin *win)
     else
         gtk_file_chooser_set_filename(chooser, _("Untitled"));
     GtkResponseType response = gtk_dialog_run(GTK_DIALOG(dialog));
-    if (response == GTK_RESPONSE_ACCEPT)
+    if (response == GTK_RESPONSE_ACCEPT &&
+            roxterm_save_buffer_check_busy(roxterm))
     {
         g_free(roxterm->buffer_file_name);
         roxterm->buffer_file_name = gtk_file_chooser_get_filename(chooser);
@@ -2520,7 +3506,15 @@ static void roxterm_save_buffer_action(MultiWin * win)
         roxterm_save_buffer_as_action(win);
         return;
     }
-    roxterm_save_buffer(roxterm);
+    if (roxterm_save_buffer_check_busy(roxterm))
+        roxterm_save_buffer(roxterm);
+}
+
+static void roxterm_cancel_save_buffer_action(MultiWin * win)
+{
+    ROXTermData *roxterm = multi_win_get_user_data_for_current_tab(win);
+    g_return_if_fail(roxterm);
+    roxterm_save_buffer_cancel(roxterm);
 }
 
 
@@ -2684,6 +3678,8 @@ static void roxterm_connect_menu_signals(MultiWin * win)
         G_CALLBACK(roxterm_save_buffer_as_action), win, NULL, NULL, NULL);
     multi_win_menu_connect_swapped(win, MENUTREE_FILE_SAVE_BUFFER,
         G_CALLBACK(roxterm_save_buffer_action), win, NULL, NULL, NULL);
+    multi_win_menu_connect_swapped(win, MENUTREE_FILE_CANCEL_SAVE_BUFFER,
+        G_CALLBACK(roxterm_cancel_save_buffer_action), win, NULL, NULL, NULL);
 
     multi_win_menu_connect_swapped(win, MENUTREE_EDIT_SELECT_ALL,
         G_CALLBACK(roxterm_select_all_action), win, NULL, NULL, NULL);
@@ -2699,6 +3695,8 @@ static void roxterm_connect_menu_signals(MultiWin * win)
         G_CALLBACK(roxterm_reset_and_clear_action), win, NULL, NULL, NULL);
     multi_win_menu_connect_swapped(win, MENUTREE_EDIT_RESPAWN,
         G_CALLBACK(roxterm_respawn_action), win, NULL, NULL, NULL);
+    multi_win_menu_connect_swapped(win, MENUTREE_EDIT_PAUSE_OUTPUT,
+        G_CALLBACK(roxterm_pause_output_action), win, NULL, NULL, NULL);
 
     multi_win_menu_connect_swapped(win,
             MENUTREE_PREFERENCES_EDIT_CURRENT_PROFILE,
@@ -2735,6 +3733,10 @@ static void roxterm_connect_menu_signals(MultiWin * win)
         G_CALLBACK(roxterm_find_next_action), win, NULL, NULL, NULL);
     multi_win_menu_connect_swapped(win, MENUTREE_SEARCH_FIND_PREVIOUS,
         G_CALLBACK(roxterm_find_prev_action), win, NULL, NULL, NULL);
+    multi_win_menu_connect_swapped(win, MENUTREE_HELP_TERMINAL_INFO,
+        G_CALLBACK(roxterm_show_terminal_info), win, NULL, NULL, NULL);
+    multi_win_menu_connect_swapped(win, MENUTREE_SEARCH_FIND_ALL,
+        G_CALLBACK(roxterm_open_search_all_action), win, NULL, NULL, NULL);
 
     roxterm_add_all_pref_submenus(win);
 }
@@ -2894,6 +3896,12 @@ static void roxterm_connect_misc_signals(ROXTermData * roxterm)
         G_CALLBACK(roxterm_uri_drag_data_get), roxterm);
     g_signal_connect(roxterm->widget, "bell",
             G_CALLBACK(roxterm_bell_handler), roxterm);
+    g_signal_connect(roxterm->widget, "commit",
+            G_CALLBACK(roxterm_commit_handler), roxterm);
+    g_signal_connect(roxterm->widget, "map",
+            G_CALLBACK(roxterm_map_handler), roxterm);
+    g_signal_connect(roxterm->widget, "unmap",
+            G_CALLBACK(roxterm_unmap_handler), roxterm);
     /* None of these seem to get raised on text output */
     /*
     g_signal_connect(roxterm->widget, "text-modified",
@@ -2905,6 +3913,8 @@ static void roxterm_connect_misc_signals(ROXTermData * roxterm)
     */
     g_signal_connect(roxterm->widget, "cursor-moved",
             G_CALLBACK(roxterm_text_changed_handler), roxterm);
+    g_signal_connect(roxterm->widget, "contents-changed",
+            G_CALLBACK(roxterm_contents_changed_handler), roxterm);
     g_signal_connect(roxterm->widget, "resize-window",
             G_CALLBACK(roxterm_resize_window_handler), roxterm);
     g_signal_connect(roxterm->widget, "composited-changed",
@@ -2924,59 +3934,705 @@ roxterm_set_word_chars(ROXTermData * roxterm, VteTerminal * vte)
         g_free(wchars);
 }
 
-inline static void
-roxterm_update_audible_bell(ROXTermData * roxterm, VteTerminal * vte)
+inline static void
+roxterm_update_audible_bell(ROXTermData * roxterm, VteTerminal * vte)
+{
+    vte_terminal_set_audible_bell(vte, options_lookup_int
+        (roxterm->profile, "audible_bell") != 0);
+}
+
+static void
+roxterm_update_cursor_blink_mode(ROXTermData * roxterm, VteTerminal * vte)
+{
+    int o;
+
+    if (roxterm->suspended)
+        return;
+    o = options_lookup_int(roxterm->profile, "cursor_blink_mode");
+
+    if (o == -1)
+    {
+        o = options_lookup_int(roxterm->profile, "cursor_blinks") + 1;
+        if (o)
+            o ^= 3;
+    }
+    vte_terminal_set_cursor_blink_mode(vte, o);
+}
+
+inline static void
+roxterm_update_cursor_shape(ROXTermData * roxterm, VteTerminal * vte)
+{
+    vte_terminal_set_cursor_shape(vte, options_lookup_int_with_default
+        (roxterm->profile, "cursor_shape", 0));
+}
+
+inline static void
+roxterm_update_mouse_autohide(ROXTermData * roxterm, VteTerminal * vte)
+{
+    vte_terminal_set_mouse_autohide(vte, options_lookup_int(roxterm->profile,
+            "mouse_autohide") != 0);
+}
+
+static void roxterm_set_scrollback_lines(ROXTermData * roxterm,
+        VteTerminal * vte)
+{
+    int lines = options_lookup_int_with_default(roxterm->profile,
+                "limit_scrollback", 0) ?
+            options_lookup_int_with_default(roxterm->profile,
+                    "scrollback_lines", 1000) :
+            -1;
+    vte_terminal_set_scrollback_lines(vte, lines);
+    roxterm->scrollback_trimmed = FALSE;
+}
+
+/******************** Scrollback budget *********************/
+
+/* The global option scrollback_budget sets a limit in MiB for the total
+ * scrollback of all terminals in this process; 0 or unset means no limit.
+ * When the limit is exceeded, or the system is short of memory, the
+ * scrollback of the least recently viewed terminals which aren't currently
+ * visible is trimmed. A trimmed terminal keeps the reduced limit until it's
+ * next selected, when its profile's limit is restored; the lines trimmed are
+ * lost, so the tab's tooltip says how many were discarded until the terminal
+ * is cleared.
+ *
+ * VTE doesn't report its memory use, so usage is estimated from the number
+ * of rows in the buffer and their width, which overestimates the compressed
+ * form that VTE actually stores.
+ */
+#define SCROLLBACK_BUDGET_INTERVAL 10   /* seconds */
+#define SCROLLBACK_ROW_OVERHEAD 16      /* estimated bytes per row */
+#define SCROLLBACK_TRIM_LINES 1000
+#define SCROLLBACK_CRITICAL_TRIM_LINES 100
+
+gsize roxterm_get_scrollback_usage(ROXTermData *roxterm, glong *rows)
+{
+    VteTerminal *vte;
+    GtkAdjustment *adj;
+    glong nrows;
+
+    if (!roxterm->widget)
+    {
+        if (rows)
+            *rows = 0;
+        return 0;
+    }
+    vte = VTE_TERMINAL(roxterm->widget);
+    adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte));
+    nrows = (glong) (gtk_adjustment_get_upper(adj) -
+            gtk_adjustment_get_lower(adj));
+    if (rows)
+        *rows = nrows;
+    return (gsize) nrows * (vte_terminal_get_column_count(vte) +
+            SCROLLBACK_ROW_OVERHEAD);
+}
+
+void roxterm_get_memory_usage(ROXTermData *roxterm,
+        ROXTermMemoryUsage *usage)
+{
+    OutputLog *log = NULL;
+
+    memset(usage, 0, sizeof(*usage));
+    usage->scrollback_bytes = roxterm_get_scrollback_usage(roxterm,
+            &usage->scrollback_rows);
+    if (roxterm->pending_clipboard)
+    {
+        usage->osc52_bytes +=
+            roxterm->clipboard_offset + roxterm->clipboard_size;
+    }
+    if (roxterm->osc52_filter)
+    {
+        usage->osc52_bytes +=
+            osc52filter_get_memory_usage(roxterm->osc52_filter);
+        log = osc52filter_get_log(roxterm->osc52_filter);
+    }
+    if (log)
+        usage->log_bytes = outputlog_get_memory_usage(log);
+    if (roxterm->search_index)
+    {
+        usage->search_bytes =
+            search_index_get_memory_usage(roxterm->search_index);
+    }
+    usage->regexes = roxterm->match_map->len +
+            (roxterm->search_pattern ? 1 : 0);
+}
+
+inline static gsize roxterm_memory_usage_total(ROXTermMemoryUsage *usage)
+{
+    return usage->scrollback_bytes + usage->osc52_bytes +
+            usage->log_bytes + usage->search_bytes;
+}
+
+static void roxterm_append_size(GString *s, const char *label, gsize bytes)
+{
+    char *size = g_format_size(bytes);
+
+    g_string_append_printf(s, "%s: %s\n", label, size);
+    g_free(size);
+}
+
+static const char *roxterm_get_tab_title(ROXTermData *roxterm)
+{
+    const char *title = roxterm->tab ?
+        multi_tab_get_window_title(roxterm->tab) : NULL;
+
+    return title ? title : "";
+}
+
+static gint roxterm_compare_memory_usage(gconstpointer a, gconstpointer b,
+        gpointer totals)
+{
+    gsize ta = GPOINTER_TO_SIZE(g_hash_table_lookup(totals, a));
+    gsize tb = GPOINTER_TO_SIZE(g_hash_table_lookup(totals, b));
+
+    return ta < tb ? 1 : ta > tb ? -1 : 0;
+}
+
+char *roxterm_describe_memory_usage(ROXTermData *roxterm)
+{
+    GString *s = g_string_new(NULL);
+    ROXTermMemoryUsage usage;
+    gsize rss, heap_used, heap_free;
+    GHashTable *totals;
+    GList *terms = NULL, *link;
+    GHashTableIter iter;
+    ROXTermData *rt;
+    guint n, menus = 0;
+
+    if (roxterm)
+    {
+        roxterm_get_memory_usage(roxterm, &usage);
+        g_string_append_printf(s, _("Terminal %s (%s)\n"),
+                roxterm_get_tab_title(roxterm),
+                options_get_leafname(roxterm->profile));
+        g_string_append_printf(s, _("Scrollback lines: %ld\n"),
+                usage.scrollback_rows);
+        roxterm_append_size(s, _("Scrollback (estimated)"),
+                usage.scrollback_bytes);
+        roxterm_append_size(s, _("OSC 52 buffers"), usage.osc52_bytes);
+        roxterm_append_size(s, _("Output log buffer"), usage.log_bytes);
+        roxterm_append_size(s, _("Search index"), usage.search_bytes);
+        g_string_append_printf(s, _("Regular expressions: %u\n"),
+                usage.regexes);
+        return g_string_free(s, FALSE);
+    }
+
+    mempressure_get_process_usage(&rss, &heap_used, &heap_free);
+    roxterm_append_size(s, _("Resident memory"), rss);
+    if (heap_used || heap_free)
+    {
+        roxterm_append_size(s, _("Heap in use"), heap_used);
+        roxterm_append_size(s, _("Heap free"), heap_free);
+    }
+    /* Only ROXTerm's own windows; their menus are counted separately
+     * because GTK makes each menu a toplevel window of its own */
+    for (link = multi_win_all; link; link = g_list_next(link))
+    {
+        if (multi_win_get_menu_bar(link->data))
+            ++menus;
+        if (multi_win_get_popup_menu(link->data))
+            ++menus;
+    }
+    g_string_append_printf(s, _("Windows: %u\nMenus: %u\nTerminals: %u\n"),
+            g_list_length(multi_win_all), menus, roxterm_count());
+    if (!roxterm_registry)
+        return g_string_free(s, FALSE);
+    totals = g_hash_table_new(NULL, NULL);
+    g_hash_table_iter_init(&iter, roxterm_registry);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &rt))
+    {
+        roxterm_get_memory_usage(rt, &usage);
+        g_hash_table_insert(totals, rt,
+                GSIZE_TO_POINTER(roxterm_memory_usage_total(&usage)));
+        terms = g_list_prepend(terms, rt);
+    }
+    terms = g_list_sort_with_data(terms, roxterm_compare_memory_usage,
+            totals);
+    g_string_append(s, _("Largest terminals (estimated):\n"));
+    for (n = 0, link = terms; n < 10 && link; ++n, link = g_list_next(link))
+    {
+        char *size = g_format_size(GPOINTER_TO_SIZE(
+                    g_hash_table_lookup(totals, link->data)));
+
+        g_string_append_printf(s, "  %s  %s\n", size,
+                roxterm_get_tab_title(link->data));
+        g_free(size);
+    }
+    g_list_free(terms);
+    g_hash_table_unref(totals);
+    return g_string_free(s, FALSE);
+}
+
+static void roxterm_terminal_info_fill(GtkWidget *dialog)
+{
+    ROXTermData *roxterm = roxterm_from_id(GPOINTER_TO_SIZE(
+                g_object_get_data(G_OBJECT(dialog), "roxterm_id")));
+    GtkLabel *label = g_object_get_data(G_OBJECT(dialog), "info_label");
+    char *terminal = roxterm ? roxterm_describe_memory_usage(roxterm) : NULL;
+    char *process = roxterm_describe_memory_usage(NULL);
+    char *text = g_strconcat(terminal ? terminal : "", terminal ? "\n" : "",
+            process, NULL);
+
+    gtk_label_set_text(label, text);
+    g_free(text);
+    g_free(process);
+    g_free(terminal);
+}
+
+static void roxterm_terminal_info_response(GtkWidget *dialog, int response,
+        gpointer handle)
+{
+    (void) handle;
+    if (response == GTK_RESPONSE_APPLY)
+        roxterm_terminal_info_fill(dialog);
+    else
+        gtk_widget_destroy(dialog);
+}
+
+static void roxterm_show_terminal_info(MultiWin *win)
+{
+    ROXTermData *roxterm = multi_win_get_user_data_for_current_tab(win);
+    GtkWidget *dialog;
+    GtkWidget *label;
+
+    g_return_if_fail(roxterm);
+    dialog = gtk_dialog_new_with_buttons(_("Terminal Information"),
+            GTK_WINDOW(multi_win_get_widget(win)),
+            GTK_DIALOG_DESTROY_WITH_PARENT,
+            _("_Refresh"), GTK_RESPONSE_APPLY,
+            _("_Close"), GTK_RESPONSE_CLOSE,
+            NULL);
+    label = gtk_label_new(NULL);
+    gtk_label_set_selectable(GTK_LABEL(label), TRUE);
+    gtk_label_set_xalign(GTK_LABEL(label), 0);
+    gtk_widget_set_margin_start(label, DLG_SPACING * 2);
+    gtk_widget_set_margin_end(label, DLG_SPACING * 2);
+    gtk_box_pack_start(GTK_BOX(gtk_dialog_get_content_area(
+            GTK_DIALOG(dialog))), label, TRUE, TRUE, DLG_SPACING);
+    g_object_set_data(G_OBJECT(dialog), "roxterm_id",
+            GSIZE_TO_POINTER(roxterm->id));
+    g_object_set_data(G_OBJECT(dialog), "info_label", label);
+    roxterm_terminal_info_fill(dialog);
+    g_signal_connect(dialog, "response",
+            G_CALLBACK(roxterm_terminal_info_response), NULL);
+    gtk_widget_show_all(dialog);
+}
+
+static gboolean roxterm_is_visible(ROXTermData *roxterm)
+{
+    MultiWin *win = roxterm_get_win(roxterm);
+
+    return win && multi_win_get_current_tab(win) == roxterm->tab &&
+            gtk_widget_get_mapped(multi_win_get_widget(win));
+}
+
+static void roxterm_scrollback_viewed(ROXTermData *roxterm)
+{
+    roxterm->last_viewed = g_get_monotonic_time();
+    if (roxterm->scrollback_trimmed && roxterm->widget)
+    {
+        roxterm_set_scrollback_lines(roxterm,
+                VTE_TERMINAL(roxterm->widget));
+    }
+}
+
+static gint roxterm_compare_last_viewed(gconstpointer a, gconstpointer b)
+{
+    const ROXTermData *ra = *(ROXTermData * const *) a;
+    const ROXTermData *rb = *(ROXTermData * const *) b;
+
+    return ra->last_viewed < rb->last_viewed ? -1 :
+            (ra->last_viewed > rb->last_viewed ? 1 : 0);
+}
+
+/* Trims terminals' scrollback to at most trim_lines, least recently viewed
+ * first, until the estimated total is no more than target bytes */
+static void roxterm_trim_scrollback(gsize target, glong trim_lines)
+{
+    GPtrArray *terms;
+    GHashTableIter iter;
+    ROXTermData *roxterm;
+    gsize total = 0;
+    guint n;
+
+    if (!roxterm_registry)
+        return;
+    terms = g_ptr_array_sized_new(roxterm_count());
+    g_hash_table_iter_init(&iter, roxterm_registry);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &roxterm))
+    {
+        total += roxterm_get_scrollback_usage(roxterm, NULL);
+        if (!roxterm_is_visible(roxterm))
+            g_ptr_array_add(terms, roxterm);
+    }
+    g_ptr_array_sort(terms, roxterm_compare_last_viewed);
+    for (n = 0; n < terms->len && total > target; ++n)
+    {
+        gsize before, after;
+        glong rows, rows_after;
+        VteTerminal *vte;
+
+        roxterm = g_ptr_array_index(terms, n);
+        vte = VTE_TERMINAL(roxterm->widget);
+        before = roxterm_get_scrollback_usage(roxterm, &rows);
+        if (rows - vte_terminal_get_row_count(vte) <= trim_lines)
+            continue;
+        vte_terminal_set_scrollback_lines(vte, trim_lines);
+        roxterm->scrollback_trimmed = TRUE;
+        after = roxterm_get_scrollback_usage(roxterm, &rows_after);
+        if (rows > rows_after)
+            roxterm->scrollback_lines_lost += rows - rows_after;
+        if (before > after)
+            total -= before - after;
+        roxterm_update_tab_tooltip(roxterm);
+    }
+    g_ptr_array_free(terms, TRUE);
+}
+
+static guint roxterm_scrollback_budget_tag = 0;
+
+static gsize roxterm_get_scrollback_budget(void)
+{
+    return (gsize) MAX(global_options_lookup_int_with_default(
+            "scrollback_budget", 0), 0) * 1024 * 1024;
+}
+
+static gboolean roxterm_check_scrollback_budget(gpointer handle)
+{
+    (void) handle;
+    roxterm_trim_scrollback(roxterm_get_scrollback_budget(),
+            SCROLLBACK_TRIM_LINES);
+    return G_SOURCE_CONTINUE;
+}
+
+/* The budget is only polled while one is set */
+static void roxterm_update_scrollback_budget_timer(void)
+{
+    gboolean want = roxterm_get_scrollback_budget() != 0;
+
+    if (want && !roxterm_scrollback_budget_tag)
+    {
+        roxterm_scrollback_budget_tag = g_timeout_add_seconds(
+                SCROLLBACK_BUDGET_INTERVAL,
+                roxterm_check_scrollback_budget, NULL);
+    }
+    else if (!want && roxterm_scrollback_budget_tag)
+    {
+        g_source_remove(roxterm_scrollback_budget_tag);
+        roxterm_scrollback_budget_tag = 0;
+    }
+}
+
+static void roxterm_memory_pressure_handler(MemPressureLevel level,
+        gpointer handle)
+{
+    gsize total = 0;
+    GHashTableIter iter;
+    ROXTermData *roxterm;
+
+    (void) handle;
+    if (!roxterm_registry)
+        return;
+    g_hash_table_iter_init(&iter, roxterm_registry);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &roxterm))
+        total += roxterm_get_scrollback_usage(roxterm, NULL);
+    g_debug("Memory pressure level %d, scrollback estimated at %"
+            G_GSIZE_FORMAT " bytes", level, total);
+    switch (level)
+    {
+        case MEMPRESSURE_LOW:
+            roxterm_trim_scrollback(total / 4 * 3, SCROLLBACK_TRIM_LINES);
+            break;
+        case MEMPRESSURE_MEDIUM:
+            roxterm_trim_scrollback(total / 2, SCROLLBACK_TRIM_LINES);
+            break;
+        case MEMPRESSURE_CRITICAL:
+            roxterm_trim_scrollback(0, SCROLLBACK_CRITICAL_TRIM_LINES);
+            break;
+    }
+}
+
+/* Shows the state of any buffer save in progress and scrollback usage. It's
+ * built when GTK is about to show it rather than whenever something in it
+ * changes. */
+static char *roxterm_get_tab_tooltip(ROXTermData *roxterm)
+{
+    GString *tip;
+    ROXTermMemoryUsage usage;
+    gsize bytes;
+    char *size;
+    OutputLog *log;
+
+    if (!roxterm->widget)
+        return NULL;
+    tip = g_string_new(NULL);
+    if (roxterm->save_job)
+    {
+        g_string_append_printf(tip, _("Saving buffer to '%s': %d%%"),
+                roxterm->save_job->filename, roxterm->save_job->percent);
+        g_string_append_c(tip, '\n');
+    }
+    if (roxterm->procmon && procmon_is_busy(roxterm->procmon) &&
+            procmon_get_foreground_name(roxterm->procmon))
+    {
+        g_string_append_printf(tip, _("Running: %s"),
+                procmon_get_foreground_name(roxterm->procmon));
+        g_string_append_c(tip, '\n');
+    }
+    if (roxterm_output_is_paused(roxterm))
+    {
+        g_string_append(tip, _("Output is paused"));
+        g_string_append_c(tip, '\n');
+    }
+    else if (roxterm->flooding)
+    {
+        size = g_format_size(roxterm->flood_rate);
+        g_string_append_printf(tip,
+                _("Output flood (%s/s), use Pause Output to stop it"), size);
+        g_string_append_c(tip, '\n');
+        g_free(size);
+    }
+    roxterm_get_memory_usage(roxterm, &usage);
+    size = g_format_size(usage.scrollback_bytes);
+    g_string_append_printf(tip, _("Scrollback: %ld lines, about %s"),
+            usage.scrollback_rows, size);
+    g_free(size);
+    bytes = roxterm_memory_usage_total(&usage) - usage.scrollback_bytes;
+    if (bytes)
+    {
+        size = g_format_size(bytes);
+        g_string_append_c(tip, '\n');
+        g_string_append_printf(tip, _("Other buffers: about %s"), size);
+        g_free(size);
+    }
+    if (roxterm->scrollback_lines_lost)
+    {
+        g_string_append_c(tip, '\n');
+        g_string_append_printf(tip,
+                _("%ld older lines of scrollback were discarded to save "
+                "memory"), roxterm->scrollback_lines_lost);
+    }
+    log = roxterm->osc52_filter ?
+        osc52filter_get_log(roxterm->osc52_filter) : NULL;
+    if (log)
+    {
+        guint dropped = outputlog_get_dropped(log);
+
+        g_string_append_c(tip, '\n');
+        if (outputlog_has_failed(log))
+            g_string_append(tip, _("Output log could not be written"));
+        else if (dropped)
+            g_string_append_printf(tip,
+                    _("Logging output, %u bytes dropped"), dropped);
+        else
+            g_string_append(tip, _("Logging output"));
+    }
+    return g_string_free(tip, FALSE);
+}
+
+static void roxterm_update_tab_tooltip(ROXTermData *roxterm)
+{
+    if (roxterm->tab)
+        multi_tab_update_status_tooltip(roxterm->tab);
+}
+
+/****************** End scrollback budget *******************/
+
+static void roxterm_set_scroll_on_output(ROXTermData * roxterm,
+        VteTerminal * vte)
+{
+    if (roxterm->suspended || roxterm->flooding)
+        return;
+    vte_terminal_set_scroll_on_output(vte, options_lookup_int_with_default
+        (roxterm->profile, "scroll_on_output", 0));
+}
+
+/******************** Suspended terminals *********************/
+
+/* A terminal is suspended while it can't be seen, because it's in a
+ * background tab or its window is minimized. It stops blinking its cursor
+ * and scrolling on output, and only notes the first output for the tab's
+ * status icon. Everything is brought up to date when it can be seen again.
+ */
+
+static void roxterm_suspend(ROXTermData *roxterm, VteTerminal *vte)
+{
+    vte_terminal_set_cursor_blink_mode(vte, VTE_CURSOR_BLINK_OFF);
+    vte_terminal_set_scroll_on_output(vte, FALSE);
+    roxterm->suspended = TRUE;
+    roxterm->suspended_generation = roxterm->contents_generation;
+}
+
+static void roxterm_resume(ROXTermData *roxterm, VteTerminal *vte)
+{
+    roxterm->suspended = FALSE;
+    roxterm_update_cursor_blink_mode(roxterm, vte);
+    roxterm_set_scroll_on_output(roxterm, vte);
+    /* Only catch up with output that arrived while it was hidden, otherwise
+     * a user who had scrolled back would lose their place */
+    if (roxterm->suspended_generation != roxterm->contents_generation &&
+            options_lookup_int_with_default(roxterm->profile,
+                "scroll_on_output", 0))
+    {
+        GtkAdjustment *adj = gtk_scrollable_get_vadjustment(
+                GTK_SCROLLABLE(vte));
+
+        gtk_adjustment_set_value(adj, gtk_adjustment_get_upper(adj) -
+                gtk_adjustment_get_page_size(adj));
+    }
+    if (roxterm->activity_pending)
+    {
+        if (roxterm->activity_tag)
+        {
+            g_source_remove(roxterm->activity_tag);
+            roxterm->activity_tag = 0;
+        }
+        roxterm_show_activity(roxterm);
+    }
+    roxterm_update_tab_tooltip(roxterm);
+}
+
+static void roxterm_update_suspended(ROXTermData *roxterm)
+{
+    VteTerminal *vte;
+    gboolean suspend;
+
+    if (!roxterm->widget)
+        return;
+    vte = VTE_TERMINAL(roxterm->widget);
+    suspend = roxterm->iconified || !gtk_widget_get_mapped(roxterm->widget);
+    if (suspend && !roxterm->suspended)
+        roxterm_suspend(roxterm, vte);
+    else if (!suspend && roxterm->suspended)
+        roxterm_resume(roxterm, vte);
+}
+
+/* Background notebook pages are unmapped */
+static void roxterm_unmap_handler(GtkWidget *widget, ROXTermData *roxterm)
 {
-    vte_terminal_set_audible_bell(vte, options_lookup_int
-        (roxterm->profile, "audible_bell") != 0);
+    (void) widget;
+    roxterm_update_suspended(roxterm);
 }
 
-static void
-roxterm_update_cursor_blink_mode(ROXTermData * roxterm, VteTerminal * vte)
+/****************** End suspended terminals *******************/
+
+/********************** Flood protection **********************/
+
+/* Every window shares one main loop, so a tab receiving output faster than
+ * it can be shown makes the others unresponsive. Output is sampled once a
+ * second, while any terminal is receiving it, as bytes read from the pty
+ * (counted by the pty filter) and as VTE's contents-changed signals. A tab
+ * over either profile threshold stops scrolling on output and indexing its
+ * scrollback, and shows a warning icon, until it has stayed below half the
+ * threshold for a few samples. VTE doesn't let us throttle its redraws,
+ * so the Pause Output action is the way to stop a flood altogether.
+ */
+
+#define ROXTERM_FLOOD_SAMPLE_MS 1000
+#define ROXTERM_FLOOD_CALM_SAMPLES 3
+
+static guint roxterm_flood_tag = 0;
+
+static void roxterm_flood_start(ROXTermData *roxterm)
 {
-    int o = options_lookup_int(roxterm->profile, "cursor_blink_mode");
+    roxterm->flooding = TRUE;
+    roxterm->flood_calm = 0;
+    vte_terminal_set_scroll_on_output(VTE_TERMINAL(roxterm->widget), FALSE);
+    if (roxterm->search_index)
+        search_index_hold(roxterm->search_index, TRUE);
+    roxterm_show_status(roxterm, "emblem-important");
+}
 
-    if (o == -1)
+static void roxterm_flood_stop(ROXTermData *roxterm)
+{
+    roxterm->flooding = FALSE;
+    roxterm->flood_rate = 0;
+    roxterm_set_scroll_on_output(roxterm, VTE_TERMINAL(roxterm->widget));
+    if (roxterm->search_index)
+        search_index_hold(roxterm->search_index, FALSE);
+    if (!g_strcmp0(roxterm->status_icon_name, "emblem-important"))
     {
-        o = options_lookup_int(roxterm->profile, "cursor_blinks") + 1;
-        if (o)
-            o ^= 3;
+        roxterm_show_status(roxterm, roxterm->running ? "window-close" : NULL);
+        roxterm_show_process_status(roxterm);
     }
-    vte_terminal_set_cursor_blink_mode(vte, o);
 }
 
-inline static void
-roxterm_update_cursor_shape(ROXTermData * roxterm, VteTerminal * vte)
+/* Returns TRUE if the terminal had any output or is still flooding */
+static gboolean roxterm_flood_check(ROXTermData *roxterm)
 {
-    vte_terminal_set_cursor_shape(vte, options_lookup_int_with_default
-        (roxterm->profile, "cursor_shape", 0));
-}
+    int byte_limit = options_lookup_int_with_default(roxterm->profile,
+            "flood_threshold", ROXTERM_FLOOD_THRESHOLD);
+    int change_limit = options_lookup_int_with_default(roxterm->profile,
+            "flood_update_rate", 0);
+    gsize bytes = roxterm->osc52_filter ?
+        osc52filter_take_bytes_read(roxterm->osc52_filter) : 0;
+    guint changes = roxterm->contents_changes;
+    gboolean was_flooding = roxterm->flooding;
+    gboolean over, calm;
 
-inline static void
-roxterm_update_mouse_autohide(ROXTermData * roxterm, VteTerminal * vte)
-{
-    vte_terminal_set_mouse_autohide(vte, options_lookup_int(roxterm->profile,
-            "mouse_autohide") != 0);
+    roxterm->contents_changes = 0;
+    if (!roxterm->widget)
+        return FALSE;
+    over = (byte_limit > 0 && bytes >= (gsize) byte_limit * 1024) ||
+        (change_limit > 0 && changes >= (guint) change_limit);
+    calm = (byte_limit <= 0 || bytes < (gsize) byte_limit * 512) &&
+        (change_limit <= 0 || changes < (guint) change_limit / 2);
+    roxterm->flood_rate = bytes;
+    if (over)
+    {
+        roxterm->flood_calm = 0;
+        if (!roxterm->flooding)
+            roxterm_flood_start(roxterm);
+    }
+    else if (roxterm->flooding)
+    {
+        if (!calm)
+            roxterm->flood_calm = 0;
+        else if (++roxterm->flood_calm >= ROXTERM_FLOOD_CALM_SAMPLES)
+            roxterm_flood_stop(roxterm);
+    }
+    if (roxterm->flooding || was_flooding)
+        roxterm_update_tab_tooltip(roxterm);
+    return changes || roxterm->flooding;
 }
 
-static void roxterm_set_scrollback_lines(ROXTermData * roxterm,
-        VteTerminal * vte)
+static gboolean roxterm_flood_sample(gpointer data)
 {
-    int lines = options_lookup_int_with_default(roxterm->profile,
-                "limit_scrollback", 0) ?
-            options_lookup_int_with_default(roxterm->profile,
-                    "scrollback_lines", 1000) :
-            -1;
-    vte_terminal_set_scrollback_lines(vte, lines);
+    GHashTableIter iter;
+    gpointer value;
+    gboolean active = FALSE;
+
+    (void) data;
+    if (roxterm_registry)
+    {
+        g_hash_table_iter_init(&iter, roxterm_registry);
+        while (g_hash_table_iter_next(&iter, NULL, &value))
+        {
+            if (roxterm_flood_check(value))
+                active = TRUE;
+        }
+    }
+    if (active)
+        return G_SOURCE_CONTINUE;
+    roxterm_flood_tag = 0;
+    return G_SOURCE_REMOVE;
 }
 
-static void roxterm_set_scroll_on_output(ROXTermData * roxterm,
-        VteTerminal * vte)
+static void roxterm_contents_changed_handler(VteTerminal *vte,
+        ROXTermData *roxterm)
 {
-    vte_terminal_set_scroll_on_output(vte, options_lookup_int_with_default
-        (roxterm->profile, "scroll_on_output", 0));
+    (void) vte;
+    ++roxterm->contents_generation;
+    ++roxterm->contents_changes;
+    if (!roxterm_flood_tag)
+    {
+        roxterm_flood_tag = g_timeout_add(ROXTERM_FLOOD_SAMPLE_MS,
+                roxterm_flood_sample, NULL);
+    }
 }
 
+/******************** End flood protection ********************/
+
 static void roxterm_set_scroll_on_keystroke(ROXTermData * roxterm,
         VteTerminal * vte)
 {
@@ -3195,26 +4851,7 @@ roxterm_update_osc52_options(ROXTermData * roxterm)
 {
     roxterm->allow_osc52 = options_lookup_int_with_default(roxterm->profile,
                                                            "allow_osc52", 0);
-    if (roxterm->allow_osc52 == 0 && roxterm->osc52_filter)
-    {
-        osc52filter_remove(roxterm->osc52_filter);
-        roxterm->osc52_filter = NULL;
-    }
-    else if (roxterm->allow_osc52)
-    {
-        if (!roxterm->osc52_filter)
-        {
-            roxterm_create_osc52_filter(roxterm);
-        }
-        else
-        {
-            int buflen = options_lookup_int_with_default(roxterm->profile,
-                                                         "osc52_buffer_size",
-                                                         100);
-            osc52filter_set_buffer_size(roxterm->osc52_filter,
-                                        (size_t) buflen * 1024);
-        }
-    }
+    roxterm_update_pty_filter(roxterm, FALSE);
 }
 
 static void
@@ -3309,9 +4946,16 @@ static void roxterm_apply_kinetic_scroling(ROXTermData *roxterm)
     }
 }
 
+/* Font, spacing and other changes are applied in one geometry transaction
+ * so the window is only resized once */
 static void roxterm_apply_profile(ROXTermData *roxterm, VteTerminal *vte,
         gboolean update_geometry)
 {
+    MultiWin *win = roxterm_get_win(roxterm);
+
+    if (win)
+        multi_win_begin_geometry(win);
+    roxterm_clear_match_cache(roxterm);
     roxterm_set_word_chars(roxterm, vte);
     roxterm_update_audible_bell(roxterm, vte);
     roxterm_update_cursor_blink_mode(roxterm, vte);
@@ -3349,6 +4993,8 @@ static void roxterm_apply_profile(ROXTermData *roxterm, VteTerminal *vte,
 
     roxterm_apply_css_class(roxterm);
     roxterm_update_osc52_options(roxterm);
+    if (win)
+        multi_win_commit_geometry(win);
 }
 
 static gboolean
@@ -3410,6 +5056,14 @@ static gboolean roxterm_window_state_changed(GtkWidget *win,
     (void) win;
     roxterm->maximise =
             (event->new_window_state & GDK_WINDOW_STATE_MAXIMIZED) != 0;
+    if (event->changed_mask & GDK_WINDOW_STATE_ICONIFIED)
+    {
+        roxterm->iconified =
+                (event->new_window_state & GDK_WINDOW_STATE_ICONIFIED) != 0;
+        roxterm_update_suspended(roxterm);
+        /* Background tabs stay suspended but can show activity again */
+        roxterm_schedule_activity(roxterm);
+    }
     return FALSE;
 }
 
@@ -3463,7 +5117,7 @@ static GtkWidget *roxterm_multi_tab_filler(MultiWin * win, MultiTab * tab,
     MultiWin *template_win = roxterm_get_win(roxterm_template);
     GtkWidget *viewport = NULL;
 
-    roxterm_terms = g_list_append(roxterm_terms, roxterm);
+    roxterm_register(roxterm);
 
     if (template_win)
     {
@@ -3562,7 +5216,7 @@ VteTerminal *roxterm_get_current_vte_ptr(MultiWin *win) {
 
 static void roxterm_multi_tab_destructor(ROXTermData * roxterm)
 {
-    roxterm_terms = g_list_remove(roxterm_terms, roxterm);
+    roxterm_unregister(roxterm);
     roxterm_data_delete(roxterm);
 }
 
@@ -3615,19 +5269,21 @@ static gboolean roxterm_get_new_tab_adjacent(ROXTermData *roxterm)
 
 static void roxterm_reflect_profile_change(Options * profile, const char *key)
 {
-    GList *link;
+    GHashTable *users = roxterm_get_users(profile);
+    GHashTableIter iter;
+    ROXTermData *roxterm;
 
-    for (link = roxterm_terms; link; link = g_list_next(link))
+    if (!users || profile->deleted)
+        return;
+    g_hash_table_iter_init(&iter, users);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &roxterm, NULL))
     {
-        ROXTermData *roxterm = link->data;
         VteTerminal *vte;
         MultiWin *win = roxterm_get_win(roxterm);
         gboolean apply_to_win = FALSE;
 
-        if (roxterm->profile != profile || roxterm->profile->deleted)
-            continue;
-
         vte = VTE_TERMINAL(roxterm->widget);
+        roxterm_clear_match_cache(roxterm);
         if (!strcmp(key, "font"))
         {
             roxterm_apply_profile_font(roxterm, vte, TRUE);
@@ -3813,6 +5469,14 @@ static void roxterm_reflect_profile_change(Options * profile, const char *key)
         {
             roxterm_update_osc52_options(roxterm);
         }
+        else if (g_str_has_prefix(key, "log_"))
+        {
+            roxterm_update_pty_filter(roxterm, TRUE);
+        }
+        else if (g_str_has_prefix(key, "flood_"))
+        {
+            roxterm_update_pty_filter(roxterm, FALSE);
+        }
         if (apply_to_win)
         {
             multi_win_foreach_tab(win, match_text_size_foreach_tab, roxterm);
@@ -3883,16 +5547,17 @@ static gboolean roxterm_update_palette_size(Options *scheme, int size)
 
 static void roxterm_reflect_colour_change(Options *scheme, const char *key)
 {
-    GList *link;
+    GHashTable *users = roxterm_get_users(scheme);
+    GHashTableIter iter;
+    ROXTermData *roxterm;
 
-    for (link = roxterm_terms; link; link = g_list_next(link))
+    if (!users || scheme->deleted)
+        return;
+    g_hash_table_iter_init(&iter, users);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &roxterm, NULL))
     {
-        ROXTermData *roxterm = link->data;
         VteTerminal *vte;
 
-        if (roxterm->colour_scheme != scheme || roxterm->colour_scheme->deleted)
-            continue;
-
         vte = VTE_TERMINAL(roxterm->widget);
 
         if (!strcmp(key, "cursor"))
@@ -3906,28 +5571,103 @@ static void roxterm_reflect_colour_change(Options *scheme, const char *key)
     }
 }
 
-static void on_dark_theme_pref_changed(gboolean prefer_dark, gpointer handle)
+/* Number of hidden terminals whose colours are updated per idle callback
+ * after a dark/light theme change */
+#define ROXTERM_THEME_BATCH 8
+
+static gboolean roxterm_prefer_dark = FALSE;
+static guint roxterm_theme_idle_tag = 0;
+/* Ids of hidden terminals still waiting for a theme change; ids rather than
+ * pointers because terminals can be closed between batches */
+static GQueue roxterm_theme_queue = G_QUEUE_INIT;
+
+static void roxterm_apply_pending_theme(ROXTermData *roxterm)
 {
+    const char *pref_key = roxterm_prefer_dark ?
+        "colour_scheme_dark" : "colour_scheme_light";
+    char *theme;
+
+    roxterm->theme_pending = FALSE;
+    if (roxterm->colour_scheme_overridden)
+        return;
+    theme = options_lookup_string(roxterm->profile, pref_key);
+    if (!theme)
+        theme = global_options_lookup_string(pref_key);
+    if (theme)
+    {
+        roxterm_change_colour_scheme_by_name(roxterm, theme);
+        g_free(theme);
+    }
+}
+
+static gboolean roxterm_apply_theme_batch(gpointer handle)
+{
+    int n = 0;
+
     (void) handle;
+    while (n < ROXTERM_THEME_BATCH && !g_queue_is_empty(&roxterm_theme_queue))
+    {
+        ROXTermData *roxterm = roxterm_from_id(GPOINTER_TO_SIZE(
+                    g_queue_pop_head(&roxterm_theme_queue)));
 
-    const char *pref_key = prefer_dark ?
-        "colour_scheme_dark" : "colour_scheme_light";
-    GList *link;
-    for (link = roxterm_terms; link; link = g_list_next(link))
+        /* Terminals that have been closed or mapped are skipped */
+        if (!roxterm || !roxterm->theme_pending)
+            continue;
+        roxterm_apply_pending_theme(roxterm);
+        ++n;
+    }
+    if (!g_queue_is_empty(&roxterm_theme_queue))
+        return G_SOURCE_CONTINUE;
+    roxterm_theme_idle_tag = 0;
+    return G_SOURCE_REMOVE;
+}
+
+/* Catches up with anything deferred while the terminal was hidden. A theme
+ * change might not have reached it yet in the idle batches. */
+static void roxterm_map_handler(GtkWidget *widget, ROXTermData *roxterm)
+{
+    (void) widget;
+    if (roxterm->theme_pending)
+        roxterm_apply_pending_theme(roxterm);
+    roxterm_update_suspended(roxterm);
+}
+
+/* Visible terminals are updated straight away so the whole screen changes in
+ * one frame; the rest are left to low priority idle callbacks so that a lot
+ * of tabs don't freeze the UI. */
+static void on_dark_theme_pref_changed(gboolean prefer_dark, gpointer handle)
+{
+    GHashTableIter iter;
+    ROXTermData *roxterm;
+    gboolean pending = FALSE;
+
+    (void) handle;
+    if (!roxterm_registry)
+        return;
+    roxterm_prefer_dark = prefer_dark;
+    g_queue_clear(&roxterm_theme_queue);
+    g_hash_table_iter_init(&iter, roxterm_registry);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &roxterm))
     {
-        ROXTermData *roxterm = link->data;
-        if (roxterm->colour_scheme_overridden) {
+        if (roxterm->colour_scheme_overridden)
             continue;
+        if (roxterm_is_visible(roxterm))
+        {
+            roxterm_apply_pending_theme(roxterm);
         }
-        char *theme = options_lookup_string(roxterm->profile, pref_key);
-        if (!theme)
-            theme = global_options_lookup_string(pref_key);
-        if (theme)
+        else
         {
-            roxterm_change_colour_scheme_by_name(roxterm, theme);
-            g_free(theme);
+            roxterm->theme_pending = TRUE;
+            g_queue_push_tail(&roxterm_theme_queue,
+                    GSIZE_TO_POINTER(roxterm->id));
+            pending = TRUE;
         }
     }
+    if (pending && !roxterm_theme_idle_tag)
+    {
+        roxterm_theme_idle_tag = g_idle_add_full(G_PRIORITY_LOW,
+                roxterm_apply_theme_batch, NULL, NULL);
+    }
 }
 
 static void
@@ -3966,9 +5706,12 @@ roxterm_opt_signal_handler(const char *profile_name, const char *key,
     else if (!strcmp(profile_name, "Global") &&
             (!strcmp(key, "warn_close") ||
             !strcmp(key, "only_warn_running") ||
+            !strcmp(key, "scrollback_budget") ||
             !strcmp(key, "prefer_dark_theme")))
     {
         options_set_int(global_options, key, val.i);
+        if (!strcmp(key, "scrollback_budget"))
+            roxterm_update_scrollback_budget_timer();
         if (!strcmp(key, "prefer_dark_theme"))
         {
             global_options_apply_dark_theme();
@@ -4128,23 +5871,30 @@ void roxterm_stuff_changed_handler(const char *what_happened,
     if (!strcmp(what_happened, OPTSDBUS_CHANGED) &&
             strcmp(family_name, "Shortcuts"))
     {
-        for (link = roxterm_terms; link; link = g_list_next(link))
+        gboolean is_profile = !strcmp(family_name, "Profiles");
+        GHashTable *users = NULL;
+
+        if (is_profile || !strcmp(family_name, "Colours"))
+        {
+            options = dynamic_options_lookup(is_profile ? roxterm_profiles :
+                    dynamic_options_get("Colours"), current_name);
+        }
+        if (options)
+            users = roxterm_get_users(options);
+        if (users)
         {
-            ROXTermData *roxterm = link->data;
+            GHashTableIter iter;
+            ROXTermData *roxterm;
 
-            if (!strcmp(family_name, "Profiles"))
+            g_hash_table_iter_init(&iter, users);
+            while (g_hash_table_iter_next(&iter, (gpointer *) &roxterm, NULL))
             {
-                if (!strcmp(options_get_leafname(roxterm->profile),
-                        current_name))
+                if (is_profile)
                 {
                     roxterm_apply_profile(roxterm,
                             VTE_TERMINAL(roxterm->widget), TRUE);
                 }
-            }
-            else if (!strcmp(family_name, "Colours"))
-            {
-                if (!strcmp(options_get_leafname(roxterm->colour_scheme),
-                        current_name))
+                else
                 {
                     roxterm_apply_colour_scheme(roxterm,
                             VTE_TERMINAL(roxterm->widget));
@@ -4202,24 +5952,24 @@ void roxterm_stuff_changed_handler(const char *what_happened,
     }
 }
 
-static gboolean roxterm_verify_id(ROXTermData *roxterm)
+static ROXTermData *roxterm_verify_id(void *id)
 {
-    GList *link;
+    ROXTermData *roxterm = roxterm_from_id(GPOINTER_TO_SIZE(id));
 
-    for (link = roxterm_terms; link; link = g_list_next(link))
+    if (!roxterm)
     {
-        if (link->data == roxterm)
-            return TRUE;
+        g_warning(_("Invalid ROXTERM_ID %p in D-Bus message "
+                "(this is expected if you used roxterm's --separate option)"),
+                id);
     }
-    g_warning(_("Invalid ROXTERM_ID %p in D-Bus message "
-            "(this is expected if you used roxterm's --separate option)"),
-            roxterm);
-    return FALSE;
+    return roxterm;
 }
 
-static void roxterm_set_profile_handler(ROXTermData *roxterm, const char *name)
+static void roxterm_set_profile_handler(void *id, const char *name)
 {
-    if (!roxterm_verify_id(roxterm))
+    ROXTermData *roxterm = roxterm_verify_id(id);
+
+    if (!roxterm)
         return;
 
     Options *profile = dynamic_options_lookup_and_ref(roxterm_profiles, name,
@@ -4239,10 +5989,11 @@ static void roxterm_set_profile_handler(ROXTermData *roxterm, const char *name)
     }
 }
 
-static void roxterm_set_colour_scheme_handler(ROXTermData *roxterm,
-        const char *name)
+static void roxterm_set_colour_scheme_handler(void *id, const char *name)
 {
-    if (!roxterm_verify_id(roxterm))
+    ROXTermData *roxterm = roxterm_verify_id(id);
+
+    if (!roxterm)
         return;
     if (!roxterm->colour_scheme_overridden)
     {
@@ -4250,13 +6001,15 @@ static void roxterm_set_colour_scheme_handler(ROXTermData *roxterm,
     }
 }
 
-static void roxterm_set_shortcut_scheme_handler(ROXTermData *roxterm,
-        const char *name)
+static void roxterm_set_shortcut_scheme_handler(void *id, const char *name)
 {
-    if (!roxterm_verify_id(roxterm))
+    ROXTermData *roxterm = roxterm_verify_id(id);
+    Options *shortcuts;
+
+    if (!roxterm)
         return;
 
-    Options *shortcuts = shortcuts_open(name, TRUE);
+    shortcuts = shortcuts_open(name, TRUE);
     multi_win_set_shortcut_scheme(roxterm_get_win(roxterm), shortcuts);
     shortcuts_unref(shortcuts);
 }
@@ -4305,6 +6058,7 @@ static ROXTermData *roxterm_data_new(double zoom_factor, const char *directory,
     (void) profile_name;
 
     roxterm->status_icon_name = NULL;
+    roxterm->pause_fd = -1;
     roxterm->target_zoom_factor = zoom_factor;
     roxterm->current_zoom_factor = 1.0;
     if (!roxterm->target_zoom_factor)
@@ -4442,10 +6196,9 @@ void roxterm_launch(char **env)
             roxterm->dont_lookup_dimensions = TRUE;
             roxterm->target_zoom_factor = partner->target_zoom_factor;
             roxterm->zoom_index = partner->zoom_index;
-            if (partner->pango_desc)
+            if (partner->font)
             {
-                roxterm->pango_desc =
-                        pango_font_description_copy(partner->pango_desc);
+                roxterm->font = font_cache_entry_ref(partner->font);
                 roxterm->current_zoom_factor = partner->current_zoom_factor;
             }
             else
@@ -4543,6 +6296,7 @@ static void roxterm_tab_to_new_window(MultiWin *win, MultiTab *tab,
     {
         g_signal_handler_disconnect(old_gwin, roxterm->win_state_changed_tag);
     }
+    roxterm->iconified = FALSE;
     roxterm_attach_state_changed_handler(roxterm);
     if (!match_tab)
         return;
@@ -4604,43 +6358,110 @@ static void only_running_toggled(GtkToggleButton *button, DontShowData *d)
     options_file_save(global_options->kf, "Global");
 }
 
-static gboolean check_pid_has_children(pid_t pid)
+/* Sets *stale if the answer relies on a process sample that's too old to
+ * act on */
+static gboolean roxterm_check_is_running(ROXTermData *roxterm,
+        gboolean *stale)
+{
+    if (roxterm && roxterm->running)
+    {
+        if (!roxterm->is_shell || !roxterm->procmon)
+            return TRUE;
+        if (!procmon_is_fresh(roxterm->procmon))
+            *stale = TRUE;
+        return procmon_has_children(roxterm->procmon);
+    }
+    return FALSE;
+}
+
+typedef struct {
+    gboolean running;
+    gboolean stale;
+} RunningCheck;
+
+static void check_each_tab_running(MultiTab *tab, void *data)
+{
+    RunningCheck *check = data;
+
+    if (roxterm_check_is_running(multi_tab_get_user_data(tab), &check->stale))
+        check->running = TRUE;
+}
+
+/* A close that's waiting for procmon_refresh before deciding whether to
+ * warn; the window or tab may go away meanwhile */
+typedef struct {
+    MultiWin *win;
+    gsize roxterm_id;
+} PendingClose;
+
+static GList *roxterm_pending_closes = NULL;
+static gboolean roxterm_closes_refreshed = FALSE;
+
+static gboolean roxterm_delete_handler(GtkWindow *gtkwin, GdkEvent *event,
+        gpointer data);
+
+static void roxterm_pending_close_refreshed(gpointer handle)
 {
-    int fd = 0;
-    ssize_t count = -1;
-    char *buf = g_strdup_printf("/proc/%d/task/%d/children", pid, pid);
-    size_t l = strlen(buf);
+    PendingClose *pending = handle;
+    MultiWin *win = NULL;
+    ROXTermData *roxterm = NULL;
 
-    fd = open(buf, O_RDONLY);
-    if (fd == -1)
+    roxterm_pending_closes = g_list_remove(roxterm_pending_closes, pending);
+    if (pending->win)
     {
-        g_warning("Failed to open %s\n", buf);
-        g_free(buf);
+        if (g_list_find(multi_win_all, pending->win))
+            win = pending->win;
     }
     else
     {
-        memset(buf, 0, l);
-        count = read(fd, buf, l);
-        if (count == -1)
-            g_warning("Failed to read %s\n", buf);
-        close(fd);
+        roxterm = roxterm_from_id(pending->roxterm_id);
     }
-    return count > 0;
-}
-
-static gboolean roxterm_check_is_running(ROXTermData *roxterm)
-{
-    if (roxterm && roxterm->running)
+    g_free(pending);
+    roxterm_closes_refreshed = TRUE;
+    if (win)
     {
-        return roxterm->is_shell ? check_pid_has_children(roxterm->pid) : TRUE;
+        if (!roxterm_delete_handler(
+                GTK_WINDOW(multi_win_get_widget(win)), (GdkEvent *) win, win))
+        {
+            multi_win_delete(win);
+        }
     }
-    return FALSE;
+    else if (roxterm && roxterm->tab)
+    {
+        if (!roxterm_delete_handler(
+                GTK_WINDOW(multi_win_get_widget(roxterm_get_win(roxterm))),
+                NULL, roxterm))
+        {
+            multi_tab_delete(roxterm->tab);
+        }
+    }
+    roxterm_closes_refreshed = FALSE;
 }
 
-static void check_each_tab_running(MultiTab *tab, void *data)
+/* Returns TRUE if the close will be retried when the processes have been
+ * sampled */
+static gboolean roxterm_defer_close(MultiWin *win, ROXTermData *roxterm)
 {
-    if (roxterm_check_is_running((ROXTermData *) multi_tab_get_user_data(tab)))
-        *((gboolean *) data) = TRUE;
+    PendingClose *pending;
+    GList *link;
+
+    if (roxterm_closes_refreshed)
+        return FALSE;
+    for (link = roxterm_pending_closes; link; link = g_list_next(link))
+    {
+        pending = link->data;
+        if (win ? pending->win == win :
+                (!pending->win && pending->roxterm_id == roxterm->id))
+        {
+            return TRUE;
+        }
+    }
+    pending = g_new(PendingClose, 1);
+    pending->win = win;
+    pending->roxterm_id = roxterm ? roxterm->id : 0;
+    roxterm_pending_closes = g_list_prepend(roxterm_pending_closes, pending);
+    procmon_refresh(roxterm_pending_close_refreshed, pending);
+    return TRUE;
 }
 
 static gboolean roxterm_delete_handler(GtkWindow *gtkwin, GdkEvent *event,
@@ -4655,8 +6476,6 @@ static gboolean roxterm_delete_handler(GtkWindow *gtkwin, GdkEvent *event,
     MultiWin *win = event ? data : NULL;
     ROXTermData *roxterm = event ? NULL : data;
     GtkWidget *ca_box;
-    gboolean running = FALSE;
-
 
     d.warn = global_options_lookup_int_with_default("warn_close", 3);
     d.only_running = global_options_lookup_int_with_default("only_warn_running",
@@ -4666,17 +6485,16 @@ static gboolean roxterm_delete_handler(GtkWindow *gtkwin, GdkEvent *event,
         return FALSE;
     if (d.only_running)
     {
+        RunningCheck check = { FALSE, FALSE };
+
         if (win)
-        {
-            multi_win_foreach_tab(win, check_each_tab_running, &running);
-            if (!running)
-                return FALSE;
-        }
+            multi_win_foreach_tab(win, check_each_tab_running, &check);
         else
-        {
-            if (!roxterm_check_is_running(roxterm))
-                return FALSE;
-        }
+            check.running = roxterm_check_is_running(roxterm, &check.stale);
+        if (check.stale && roxterm_defer_close(win, roxterm))
+            return TRUE;
+        if (!check.running)
+            return FALSE;
     }
 
     switch (d.ntabs)
@@ -4732,12 +6550,11 @@ void roxterm_init(void)
 
     optsdbus_listen_for_opt_signals(roxterm_opt_signal_handler);
     optsdbus_listen_for_stuff_changed_signals(roxterm_stuff_changed_handler);
-    optsdbus_listen_for_set_profile_signals(
-            (OptsDBusSetProfileHandler) roxterm_set_profile_handler);
+    optsdbus_listen_for_set_profile_signals(roxterm_set_profile_handler);
     optsdbus_listen_for_set_colour_scheme_signals(
-            (OptsDBusSetProfileHandler) roxterm_set_colour_scheme_handler);
+            roxterm_set_colour_scheme_handler);
     optsdbus_listen_for_set_shortcut_scheme_signals(
-            (OptsDBusSetProfileHandler) roxterm_set_shortcut_scheme_handler);
+            roxterm_set_shortcut_scheme_handler);
 
     multi_tab_init((MultiTabFiller) roxterm_multi_tab_filler,
         (MultiTabDestructor) roxterm_multi_tab_destructor,
@@ -4753,11 +6570,15 @@ void roxterm_init(void)
         (MultiTabGetShowCloseButton) roxterm_get_show_tab_close_button,
         (MultiTabGetNewTabAdjacent) roxterm_get_new_tab_adjacent,
         (MultiTabConnectMiscSignals) roxterm_connect_misc_signals,
-        (MultiWinClipboardButtonHandler) roxterm_clipboard_button_handler
+        (MultiWinClipboardButtonHandler) roxterm_clipboard_button_handler,
+        (MultiTabGetStatusTooltip) roxterm_get_tab_tooltip
     );
 
     global_options_register_dark_theme_change_handler(
         on_dark_theme_pref_changed, NULL);
+
+    roxterm_update_scrollback_budget_timer();
+    mempressure_watch(roxterm_memory_pressure_handler, NULL);
 }
 
 gboolean roxterm_spawn_command_line(const gchar *command_line,
@@ -4885,7 +6706,7 @@ typedef struct {
     gboolean fullscreen;
     char *geom;
     //int width, height;
-    PangoFontDescription *fdesc;
+    char *font;
     char *window_title;
     char *window_title_template;
     double zoom_factor;
@@ -5011,10 +6832,7 @@ static void parse_open_win(_ROXTermParseContext *rctx,
         rctx->geom = g_strdup(geom);
     }
     if (font && font[0])
-    {
-        rctx->fdesc = pango_font_description_from_string(font);
-        resize_pango_for_zoom(rctx->fdesc, rctx->zoom_factor);
-    }
+        rctx->font = g_strdup(font);
     multi_win_set_borderless(win, rctx->borderless);
     multi_win_set_show_menu_bar(win, show_mbar);
     multi_win_set_always_show_tabs(win, show_tabs);
@@ -5083,11 +6901,8 @@ static void close_win_tag(_ROXTermParseContext *rctx)
     rctx->window_title = NULL;
     g_free(rctx->window_title_template);
     rctx->window_title_template = NULL;
-    if (rctx->fdesc)
-    {
-        pango_font_description_free(rctx->fdesc);
-        rctx->fdesc = NULL;
-    }
+    g_free(rctx->font);
+    rctx->font = NULL;
     g_free(rctx->geom);
     rctx->geom = NULL;
 }
@@ -5144,8 +6959,8 @@ static void parse_open_tab(_ROXTermParseContext *rctx,
             &rctx->geom, NULL, environ);
     roxterm->from_session = TRUE;
     roxterm->dont_lookup_dimensions = TRUE;
-    if (rctx->fdesc)
-        roxterm->pango_desc = pango_font_description_copy(rctx->fdesc);
+    if (rctx->font)
+        roxterm->font = font_cache_lookup(rctx->font, rctx->zoom_factor);
     rctx->roxterm = roxterm;
 }
 
@@ -5496,13 +7311,27 @@ VteTerminal *roxterm_get_vte(ROXTermData *roxterm)
     return VTE_TERMINAL(roxterm->widget);
 }
 
+/* Shows the number of matches once the index has caught up after a search
+ * which had to fall back to VTE's */
+static void roxterm_search_index_ready(gpointer data)
+{
+    ROXTermData *roxterm = data;
+    guint count;
+
+    if (search_index_count(roxterm->search_index, &count))
+        search_show_count(roxterm, 0, count);
+}
+
 gboolean roxterm_set_search(ROXTermData *roxterm,
         const char *pattern, guint flags, GError **error)
 {
     VteRegex *regex = NULL;
     char *cooked_pattern = NULL;
+    guint32 compile_flags = PCRE2_MULTILINE |
+            ((flags & ROXTERM_SEARCH_MATCH_CASE) ? 0 : PCRE2_CASELESS);
 
     roxterm->search_flags = flags;
+    roxterm->search_row = -1;
 
     if (roxterm->search_pattern)
     {
@@ -5528,12 +7357,28 @@ gboolean roxterm_set_search(ROXTermData *roxterm,
         }
 
         regex = vte_regex_new_for_search(pattern, -1,
-                ((flags & ROXTERM_SEARCH_MATCH_CASE) ? 0 : PCRE2_CASELESS) |
-                PCRE2_NOTEMPTY | PCRE2_MULTILINE,
-                error);
-        g_free(cooked_pattern);
+                compile_flags | PCRE2_NOTEMPTY, error);
         if (!regex)
+        {
+            g_free(cooked_pattern);
             return FALSE;
+        }
+        if (!roxterm->search_index)
+        {
+            roxterm->search_index =
+                search_index_new(VTE_TERMINAL(roxterm->widget),
+                        roxterm_search_index_ready, roxterm);
+            if (roxterm->flooding)
+                search_index_hold(roxterm->search_index, TRUE);
+        }
+        search_index_set_pattern(roxterm->search_index, pattern,
+                compile_flags);
+        g_free(cooked_pattern);
+    }
+    else if (roxterm->search_index)
+    {
+        search_index_free(roxterm->search_index);
+        roxterm->search_index = NULL;
     }
 
     vte_terminal_search_set_regex(VTE_TERMINAL(roxterm->widget), regex, 0);
@@ -5543,6 +7388,76 @@ gboolean roxterm_set_search(ROXTermData *roxterm,
     return TRUE;
 }
 
+/* With no selection VTE searches forwards from the top of the visible area
+ * or backwards from the bottom, so scroll the matching row to the relevant
+ * edge to make VTE find and select it without a long scan.
+ */
+static void roxterm_search_select_row(ROXTermData *roxterm, glong row,
+        gboolean backwards)
+{
+    VteTerminal *vte = VTE_TERMINAL(roxterm->widget);
+    GtkAdjustment *adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte));
+    glong rows = vte_terminal_get_row_count(vte);
+    glong top = backwards ? row - rows + 1 : row;
+
+    top = CLAMP(top, (glong) gtk_adjustment_get_lower(adj),
+            (glong) gtk_adjustment_get_upper(adj) - rows);
+    vte_terminal_unselect_all(vte);
+    gtk_adjustment_set_value(adj, top);
+    if (backwards)
+        vte_terminal_search_find_previous(vte);
+    else
+        vte_terminal_search_find_next(vte);
+}
+
+void roxterm_search_find(ROXTermData *roxterm, gboolean backwards)
+{
+    VteTerminal *vte = VTE_TERMINAL(roxterm->widget);
+    GtkAdjustment *adj;
+    glong rows, row;
+    guint count, position = 0;
+
+    adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte));
+    rows = vte_terminal_get_row_count(vte);
+    row = roxterm->search_row;
+    if (row < 0)
+    {
+        /* Start from the edge of the visible area */
+        row = (glong) gtk_adjustment_get_value(adj);
+        row = backwards ? row + rows : row - 1;
+    }
+    if (!roxterm->search_index || !search_index_find(roxterm->search_index,
+            row, backwards, roxterm->search_flags & ROXTERM_SEARCH_WRAP,
+            &row, &position, &count))
+    {
+        /* The index is still scanning, or held during a flood */
+        roxterm->search_row = -1;
+        if (backwards)
+            vte_terminal_search_find_previous(vte);
+        else
+            vte_terminal_search_find_next(vte);
+        return;
+    }
+    search_show_count(roxterm, position, count);
+    if (row < 0)
+    {
+        gtk_widget_error_bell(roxterm->widget);
+        return;
+    }
+    roxterm->search_row = row;
+    roxterm_search_select_row(roxterm, row, backwards);
+}
+
+void roxterm_search_show_row(ROXTermData *roxterm, glong row)
+{
+    MultiWin *win = roxterm_get_multi_win(roxterm);
+
+    multi_win_select_tab(win, roxterm->tab);
+    gtk_window_present(GTK_WINDOW(multi_win_get_widget(win)));
+    roxterm->search_row = row;
+    roxterm_search_select_row(roxterm, row, FALSE);
+}
+
 const char *roxterm_get_search_pattern(ROXTermData *roxterm)
 {
     return roxterm->search_pattern;
@@ -5555,16 +7470,12 @@ guint roxterm_get_search_flags(ROXTermData *roxterm)
 
 gboolean roxterm_is_valid(ROXTermData *roxterm)
 {
-    for (GList *link = multi_win_all; link; link = g_list_next(link))
-    {
-        MultiWin *win = link->data;
-        for (GList *tab = multi_win_get_tabs(win); tab; tab = g_list_next(tab))
-        {
-            if (multi_tab_get_user_data(tab->data) == roxterm)
-                return TRUE;
-        }
-    }
-    return FALSE;
+    return roxterm_live && g_hash_table_contains(roxterm_live, roxterm);
+}
+
+gsize roxterm_get_id(ROXTermData *roxterm)
+{
+    return roxterm->id;
 }
 
 /* vi:set sw=4 ts=4 et cindent cino= */
@@ -93,6 +93,14 @@ typedef enum {
 gboolean roxterm_set_search(ROXTermData *roxterm,
         const char *pattern, guint flags, GError **error);
 
+/* Finds the next or previous match of the pattern set by roxterm_set_search,
+ * using the terminal's search index to go straight to the matching row */
+void roxterm_search_find(ROXTermData *roxterm, gboolean backwards);
+
+/* Shows the terminal's tab and selects the match of the current search
+ * pattern in the given row */
+void roxterm_search_show_row(ROXTermData *roxterm, glong row);
+
 const char *roxterm_get_search_pattern(ROXTermData *roxterm);
 guint roxterm_get_search_flags(ROXTermData *roxterm);
 
@@ -106,6 +114,34 @@ void roxterm_osc52_handler(ROXTermData * roxterm, const char *clipboards,
 /* Returns FALSE if this roxterm has been destroyed */
 gboolean roxterm_is_valid(ROXTermData *roxterm);
 
+/* Each terminal has a serial number which is never reused, so it's safer
+ * than a pointer for referring to a terminal from deferred callbacks.
+ */
+gsize roxterm_get_id(ROXTermData *roxterm);
+
+/* Returns NULL if the terminal with this id has been destroyed */
+ROXTermData *roxterm_from_id(gsize id);
+
+/* Estimated bytes used by the terminal's scrollback; rows may be NULL */
+gsize roxterm_get_scrollback_usage(ROXTermData *roxterm, glong *rows);
+
+typedef struct {
+    glong scrollback_rows;
+    gsize scrollback_bytes;     /* Estimated */
+    gsize osc52_bytes;          /* Pending clipboard and capture buffer */
+    gsize log_bytes;
+    gsize search_bytes;
+    guint regexes;
+} ROXTermMemoryUsage;
+
+void roxterm_get_memory_usage(ROXTermData *roxterm,
+        ROXTermMemoryUsage *usage);
+
+/* Returns a human-readable report for one terminal, or for the whole
+ * process and its largest terminals if roxterm is NULL. Free with g_free.
+ */
+char *roxterm_describe_memory_usage(ROXTermData *roxterm);
+
 #endif /* ROXTERM_H */
 
 /* vi:set sw=4 ts=4 et cindent cino= */
@@ -35,6 +35,7 @@ struct {
     GtkTreeModel *model;
     GtkToggleButton *match_case, *entire_word, *as_regex,
             *backwards, *wrap;
+    GtkLabel *count;
     ROXTermData *roxterm;
     VteTerminal *vte;
     MultiWin *win;
@@ -269,14 +270,22 @@ static void search_response_cb(GtkWidget *widget,
 
         if (pattern && pattern[0])
             search_update_completion(pattern);
+        /* Only reset the search if it has changed so that pressing Find
+         * again moves on to the next match */
+        if (!g_strcmp0(pattern,
+                    roxterm_get_search_pattern(search_data.roxterm)) &&
+                flags == roxterm_get_search_flags(search_data.roxterm))
+        {
+            roxterm_search_find(search_data.roxterm, backwards);
+            return;
+        }
         if (roxterm_set_search(search_data.roxterm, pattern, flags, &error))
         {
             if (pattern && pattern[0])
             {
-                if (backwards)
-                    vte_terminal_search_find_previous(search_data.vte);
-                else
-                    vte_terminal_search_find_next(search_data.vte);
+                roxterm_search_find(search_data.roxterm, backwards);
+                /* Keep dialog open to show the count */
+                return;
             }
         }
         else
@@ -291,6 +300,22 @@ static void search_response_cb(GtkWidget *widget,
     gtk_widget_hide(search_dialog);
 }
 
+void search_show_count(ROXTermData *roxterm, guint position, guint count)
+{
+    char *msg;
+
+    if (!search_dialog || roxterm != search_data.roxterm)
+        return;
+    if (!count)
+        msg = g_strdup(_("No matches"));
+    else if (!position)
+        msg = g_strdup_printf(_("%u matching lines"), count);
+    else
+        msg = g_strdup_printf(_("%u of %u matching lines"), position, count);
+    gtk_label_set_text(search_data.count, msg);
+    g_free(msg);
+}
+
 void search_open_dialog(ROXTermData *roxterm)
 {
     const char *pattern = roxterm_get_search_pattern(roxterm);
@@ -368,6 +393,11 @@ void search_open_dialog(ROXTermData *roxterm)
         search_data.wrap = GTK_TOGGLE_BUTTON(w);
         gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, FALSE, DLG_SPACING);
 
+        w = gtk_label_new(NULL);
+        gtk_widget_set_halign(w, GTK_ALIGN_START);
+        search_data.count = GTK_LABEL(w);
+        gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, FALSE, DLG_SPACING);
+
         g_signal_connect(search_dialog, "response",
                 G_CALLBACK(search_response_cb), NULL);
         g_signal_connect(search_dialog, "destroy",
@@ -396,6 +426,7 @@ void search_open_dialog(ROXTermData *roxterm)
             flags & ROXTERM_SEARCH_BACKWARDS);
     gtk_toggle_button_set_active(search_data.wrap,
             flags & ROXTERM_SEARCH_WRAP);
+    gtk_label_set_text(search_data.count, "");
 
     if (gtk_widget_get_visible(search_dialog))
     {
@@ -29,6 +29,10 @@
 
 void search_open_dialog(ROXTermData *roxterm);
 
+/* Updates the dialog's match count if it's open for roxterm; position is 0
+ * if the current match is unknown */
+void search_show_count(ROXTermData *roxterm, guint position, guint count);
+
 #endif /* SEARCH_H */
 
 /* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,617 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "defns.h"
+
+#include <string.h>
+
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+
+#include "dlg.h"
+#include "searchall.h"
+#include "searchindex.h"
+
+/* Rows copied from a terminal per main loop iteration */
+#define SEARCH_ALL_CHUNK_ROWS 5000
+
+/* Stop copying text while this many chunks are waiting for a thread */
+#define SEARCH_ALL_MAX_QUEUED 8
+
+#define SEARCH_ALL_MAX_RESULTS 10000
+
+/* Bytes of context to show before a match and length of snippets */
+#define SEARCH_ALL_SNIPPET_LEAD 40
+#define SEARCH_ALL_SNIPPET_LEN 160
+
+#define SEARCH_ALL_RESPONSE_STOP 1
+
+enum {
+    SEARCH_ALL_COL_TITLE,
+    SEARCH_ALL_COL_LINE,
+    SEARCH_ALL_COL_SNIPPET,
+    SEARCH_ALL_COL_ID,
+    SEARCH_ALL_COL_ROW,
+    SEARCH_ALL_N_COLS
+};
+
+/* Shared read-only between the worker threads */
+typedef struct {
+    gint refcount;
+    pcre2_code *code;
+} SearchAllPattern;
+
+/* A chunk of one terminal's text, one row per line */
+typedef struct {
+    gint generation;
+    SearchAllPattern *pattern;
+    gsize roxterm_id;
+    char *title;
+    glong first_row;
+    glong line_base;        /* Row shown as line 1 */
+    GString *text;
+} SearchAllJob;
+
+typedef struct {
+    char *snippet;
+    glong row;
+} SearchAllResult;
+
+/* Results of one job, passed back to the main thread */
+typedef struct {
+    gint generation;
+    gsize roxterm_id;
+    char *title;
+    glong line_base;
+    GArray *results;
+} SearchAllBatch;
+
+typedef struct {
+    gsize roxterm_id;
+    char *title;
+} SearchAllTarget;
+
+static struct {
+    GtkWidget *dialog;
+    GtkEntry *entry;
+    GtkToggleButton *match_case, *as_regex;
+    GtkListStore *store;
+    GtkLabel *status;
+    GThreadPool *pool;
+    SearchAllPattern *pattern;
+    char *pattern_text;
+    guint flags;
+    gint generation;        /* Incremented to cancel outstanding jobs */
+    GList *targets;         /* Terminals still to be copied */
+    glong next_row;
+    guint extract_tag;
+    gboolean extract_paused;
+    guint pending;          /* Jobs queued or running */
+    guint matches;
+} search_all;
+
+static void search_all_pattern_unref(SearchAllPattern *pat)
+{
+    if (g_atomic_int_dec_and_test(&pat->refcount))
+    {
+        pcre2_code_free(pat->code);
+        g_free(pat);
+    }
+}
+
+static void search_all_target_free(gpointer handle)
+{
+    SearchAllTarget *target = handle;
+
+    g_free(target->title);
+    g_free(target);
+}
+
+static void search_all_batch_free(SearchAllBatch *batch)
+{
+    guint n;
+
+    for (n = 0; n < batch->results->len; ++n)
+        g_free(g_array_index(batch->results, SearchAllResult, n).snippet);
+    g_array_free(batch->results, TRUE);
+    g_free(batch->title);
+    g_free(batch);
+}
+
+static char *search_all_make_snippet(const char *line, gsize len,
+        gsize match_start)
+{
+    const char *start = line;
+    const char *valid_end;
+    char *snippet;
+
+    if (match_start > SEARCH_ALL_SNIPPET_LEAD)
+        start = line + match_start - SEARCH_ALL_SNIPPET_LEAD;
+    /* Back up to the start of a UTF-8 character */
+    while (start > line && (*start & 0xc0) == 0x80)
+        --start;
+    len -= start - line;
+    snippet = g_strndup(start, MIN(len, SEARCH_ALL_SNIPPET_LEN));
+    /* and lose any partial character at the end */
+    g_utf8_validate(snippet, -1, &valid_end);
+    snippet[valid_end - snippet] = 0;
+    return g_strstrip(snippet);
+}
+
+static gboolean search_all_deliver(gpointer handle);
+
+static void search_all_worker(gpointer data, gpointer user_data)
+{
+    SearchAllJob *job = data;
+    SearchAllBatch *batch = g_new0(SearchAllBatch, 1);
+    pcre2_match_data *md =
+        pcre2_match_data_create_from_pattern(job->pattern->code, NULL);
+    const char *line = job->text->str;
+    const char *end = line + job->text->len;
+    glong row = job->first_row;
+
+    (void) user_data;
+    batch->generation = job->generation;
+    batch->roxterm_id = job->roxterm_id;
+    batch->title = job->title;
+    batch->line_base = job->line_base;
+    batch->results = g_array_new(FALSE, FALSE, sizeof(SearchAllResult));
+    while (line < end)
+    {
+        const char *eol = memchr(line, '\n', end - line);
+
+        if (!eol)
+            eol = end;
+        if (!(row % 1024) &&
+                g_atomic_int_get(&search_all.generation) != job->generation)
+        {
+            break;
+        }
+        if (pcre2_match(job->pattern->code, (PCRE2_SPTR) line, eol - line,
+                0, PCRE2_NOTEMPTY, md, NULL) >= 0)
+        {
+            SearchAllResult result;
+
+            result.row = row;
+            result.snippet = search_all_make_snippet(line, eol - line,
+                    pcre2_get_ovector_pointer(md)[0]);
+            g_array_append_val(batch->results, result);
+        }
+        line = eol + 1;
+        ++row;
+    }
+    pcre2_match_data_free(md);
+    search_all_pattern_unref(job->pattern);
+    g_string_free(job->text, TRUE);
+    g_free(job);
+    g_idle_add(search_all_deliver, batch);
+}
+
+static void search_all_update_status(void)
+{
+    gboolean searching = search_all.extract_tag || search_all.extract_paused
+            || search_all.pending;
+    char *msg = searching ?
+        g_strdup_printf(_("Searching... %u matches"), search_all.matches) :
+        g_strdup_printf(_("%u matches"), search_all.matches);
+
+    gtk_label_set_text(search_all.status, msg);
+    g_free(msg);
+    gtk_dialog_set_response_sensitive(GTK_DIALOG(search_all.dialog),
+            SEARCH_ALL_RESPONSE_STOP, searching);
+}
+
+static void search_all_cancel(void)
+{
+    g_atomic_int_inc(&search_all.generation);
+    if (search_all.extract_tag)
+    {
+        g_source_remove(search_all.extract_tag);
+        search_all.extract_tag = 0;
+    }
+    search_all.extract_paused = FALSE;
+    g_list_free_full(search_all.targets, search_all_target_free);
+    search_all.targets = NULL;
+    search_all.pending = 0;
+}
+
+static void search_all_next_target(void)
+{
+    search_all_target_free(search_all.targets->data);
+    search_all.targets = g_list_delete_link(search_all.targets,
+            search_all.targets);
+    search_all.next_row = -1;
+}
+
+/* Copies text from VTE, which can only be done in the main thread, a chunk
+ * at a time to keep the UI responsive */
+static gboolean search_all_extract(gpointer handle)
+{
+    (void) handle;
+    while (search_all.targets)
+    {
+        SearchAllTarget *target = search_all.targets->data;
+        ROXTermData *roxterm = roxterm_from_id(target->roxterm_id);
+        VteTerminal *vte = roxterm ? roxterm_get_vte(roxterm) : NULL;
+        GtkAdjustment *adj;
+        glong lower, upper, end, columns, row;
+        SearchAllJob *job;
+
+        if (!vte)
+        {
+            search_all_next_target();
+            continue;
+        }
+        if (g_thread_pool_unprocessed(search_all.pool) >=
+                SEARCH_ALL_MAX_QUEUED)
+        {
+            /* Resumed by search_all_deliver */
+            search_all.extract_paused = TRUE;
+            search_all.extract_tag = 0;
+            return G_SOURCE_REMOVE;
+        }
+        adj = gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte));
+        lower = (glong) gtk_adjustment_get_lower(adj);
+        upper = (glong) gtk_adjustment_get_upper(adj);
+        columns = vte_terminal_get_column_count(vte);
+        if (search_all.next_row < lower)
+            search_all.next_row = lower;
+        end = MIN(upper, search_all.next_row + SEARCH_ALL_CHUNK_ROWS);
+        job = g_new(SearchAllJob, 1);
+        job->generation = g_atomic_int_get(&search_all.generation);
+        job->pattern = search_all.pattern;
+        g_atomic_int_inc(&job->pattern->refcount);
+        job->roxterm_id = target->roxterm_id;
+        job->title = g_strdup(target->title);
+        job->first_row = search_all.next_row;
+        job->line_base = lower;
+        job->text = g_string_new(NULL);
+        for (row = search_all.next_row; row < end; ++row)
+        {
+            gsize len;
+            char *text = search_index_get_row_text(vte, row, columns, &len);
+
+            if (text)
+                g_string_append_len(job->text, text, len);
+            g_string_append_c(job->text, '\n');
+            g_free(text);
+        }
+        g_thread_pool_push(search_all.pool, job, NULL);
+        ++search_all.pending;
+        search_all.next_row = end;
+        if (end >= upper)
+            search_all_next_target();
+        return G_SOURCE_CONTINUE;
+    }
+    search_all.extract_tag = 0;
+    search_all_update_status();
+    return G_SOURCE_REMOVE;
+}
+
+static void search_all_schedule_extract(void)
+{
+    search_all.extract_paused = FALSE;
+    search_all.extract_tag = g_idle_add_full(G_PRIORITY_LOW,
+            search_all_extract, NULL, NULL);
+}
+
+static gboolean search_all_deliver(gpointer handle)
+{
+    SearchAllBatch *batch = handle;
+    guint n;
+
+    if (batch->generation != g_atomic_int_get(&search_all.generation))
+    {
+        search_all_batch_free(batch);
+        return G_SOURCE_REMOVE;
+    }
+    for (n = 0; n < batch->results->len &&
+            search_all.matches < SEARCH_ALL_MAX_RESULTS; ++n)
+    {
+        SearchAllResult *result =
+            &g_array_index(batch->results, SearchAllResult, n);
+
+        gtk_list_store_insert_with_values(search_all.store, NULL, -1,
+                SEARCH_ALL_COL_TITLE, batch->title,
+                SEARCH_ALL_COL_LINE,
+                        (gint64) (result->row - batch->line_base + 1),
+                SEARCH_ALL_COL_SNIPPET, result->snippet,
+                SEARCH_ALL_COL_ID, (guint64) batch->roxterm_id,
+                SEARCH_ALL_COL_ROW, result->row,
+                -1);
+        ++search_all.matches;
+    }
+    search_all_batch_free(batch);
+    --search_all.pending;
+    if (search_all.matches >= SEARCH_ALL_MAX_RESULTS)
+    {
+        char *msg;
+
+        search_all_cancel();
+        msg = g_strdup_printf(_("Stopped after %u matches"),
+                search_all.matches);
+        gtk_label_set_text(search_all.status, msg);
+        g_free(msg);
+        gtk_dialog_set_response_sensitive(GTK_DIALOG(search_all.dialog),
+                SEARCH_ALL_RESPONSE_STOP, FALSE);
+        return G_SOURCE_REMOVE;
+    }
+    if (search_all.extract_paused)
+        search_all_schedule_extract();
+    search_all_update_status();
+    return G_SOURCE_REMOVE;
+}
+
+static void search_all_start(void)
+{
+    const char *text = gtk_entry_get_text(search_all.entry);
+    gboolean as_regex = gtk_toggle_button_get_active(search_all.as_regex);
+    gboolean match_case =
+        gtk_toggle_button_get_active(search_all.match_case);
+    char *cooked = as_regex ? NULL : g_regex_escape_string(text, -1);
+    pcre2_code *code;
+    int errcode;
+    PCRE2_SIZE erroffset;
+    GList *wlink;
+
+    search_all_cancel();
+    gtk_list_store_clear(search_all.store);
+    search_all.matches = 0;
+    if (!text[0])
+    {
+        g_free(cooked);
+        gtk_label_set_text(search_all.status, "");
+        return;
+    }
+    code = pcre2_compile((PCRE2_SPTR) (cooked ? cooked : text),
+            PCRE2_ZERO_TERMINATED,
+            PCRE2_UTF | PCRE2_MULTILINE | (match_case ? 0 : PCRE2_CASELESS),
+            &errcode, &erroffset, NULL);
+    g_free(cooked);
+    if (!code)
+    {
+        PCRE2_UCHAR msg[256];
+
+        pcre2_get_error_message(errcode, msg, sizeof(msg));
+        dlg_warning(GTK_WINDOW(search_all.dialog),
+                _("Invalid search expression: %s"), (char *) msg);
+        return;
+    }
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+    if (search_all.pattern)
+        search_all_pattern_unref(search_all.pattern);
+    search_all.pattern = g_new(SearchAllPattern, 1);
+    search_all.pattern->refcount = 1;
+    search_all.pattern->code = code;
+    g_free(search_all.pattern_text);
+    search_all.pattern_text = g_strdup(text);
+    search_all.flags = ROXTERM_SEARCH_WRAP |
+            (match_case ? ROXTERM_SEARCH_MATCH_CASE : 0) |
+            (as_regex ? ROXTERM_SEARCH_AS_REGEX : 0);
+
+    for (wlink = multi_win_all; wlink; wlink = g_list_next(wlink))
+    {
+        GList *tlink;
+
+        for (tlink = multi_win_get_tabs(wlink->data); tlink;
+                tlink = g_list_next(tlink))
+        {
+            ROXTermData *roxterm = multi_tab_get_user_data(tlink->data);
+            SearchAllTarget *target;
+
+            if (!roxterm)
+                continue;
+            target = g_new(SearchAllTarget, 1);
+            target->roxterm_id = roxterm_get_id(roxterm);
+            target->title =
+                g_strdup(multi_tab_get_window_title(tlink->data));
+            search_all.targets = g_list_prepend(search_all.targets, target);
+        }
+    }
+    search_all.targets = g_list_reverse(search_all.targets);
+    search_all.next_row = -1;
+    if (!search_all.pool)
+    {
+        search_all.pool = g_thread_pool_new(search_all_worker, NULL,
+                g_get_num_processors(), FALSE, NULL);
+    }
+    search_all_schedule_extract();
+    search_all_update_status();
+}
+
+static void search_all_row_activated(GtkTreeView *tview, GtkTreePath *path,
+        GtkTreeViewColumn *column, gpointer handle)
+{
+    GtkTreeModel *model = gtk_tree_view_get_model(tview);
+    GtkTreeIter iter;
+    guint64 id;
+    glong row;
+    ROXTermData *roxterm;
+
+    (void) column;
+    (void) handle;
+    if (!gtk_tree_model_get_iter(model, &iter, path))
+        return;
+    gtk_tree_model_get(model, &iter,
+            SEARCH_ALL_COL_ID, &id, SEARCH_ALL_COL_ROW, &row, -1);
+    roxterm = roxterm_from_id((gsize) id);
+    if (!roxterm)
+    {
+        gtk_label_set_text(search_all.status,
+                _("That terminal has been closed"));
+        return;
+    }
+    if (roxterm_set_search(roxterm, search_all.pattern_text,
+            search_all.flags, NULL))
+    {
+        roxterm_search_show_row(roxterm, row);
+    }
+}
+
+/* Results are sorted by terminal then row because threads can finish
+ * chunks in any order */
+static gint search_all_compare(GtkTreeModel *model,
+        GtkTreeIter *a, GtkTreeIter *b, gpointer handle)
+{
+    guint64 id_a, id_b;
+    glong row_a, row_b;
+
+    (void) handle;
+    gtk_tree_model_get(model, a,
+            SEARCH_ALL_COL_ID, &id_a, SEARCH_ALL_COL_ROW, &row_a, -1);
+    gtk_tree_model_get(model, b,
+            SEARCH_ALL_COL_ID, &id_b, SEARCH_ALL_COL_ROW, &row_b, -1);
+    if (id_a != id_b)
+        return id_a < id_b ? -1 : 1;
+    return row_a < row_b ? -1 : row_a > row_b;
+}
+
+static void search_all_response_cb(GtkDialog *dialog, int response,
+        gpointer handle)
+{
+    (void) handle;
+    switch (response)
+    {
+        case GTK_RESPONSE_ACCEPT:
+            search_all_start();
+            break;
+        case SEARCH_ALL_RESPONSE_STOP:
+            search_all_cancel();
+            gtk_label_set_text(search_all.status, _("Search stopped"));
+            gtk_dialog_set_response_sensitive(dialog,
+                    SEARCH_ALL_RESPONSE_STOP, FALSE);
+            break;
+        default:
+            search_all_cancel();
+            gtk_widget_hide(GTK_WIDGET(dialog));
+            break;
+    }
+}
+
+static void search_all_destroy_cb(GtkWidget *widget, gpointer handle)
+{
+    (void) widget;
+    (void) handle;
+    search_all_cancel();
+    search_all.dialog = NULL;
+    g_object_unref(search_all.store);
+    search_all.store = NULL;
+}
+
+static void search_all_add_column(GtkTreeView *tview, const char *title,
+        int col, gboolean expand)
+{
+    GtkCellRenderer *renderer = gtk_cell_renderer_text_new();
+    GtkTreeViewColumn *column = gtk_tree_view_column_new_with_attributes(
+            title, renderer, "text", col, NULL);
+
+    gtk_tree_view_column_set_resizable(column, TRUE);
+    gtk_tree_view_column_set_expand(column, expand);
+    gtk_tree_view_append_column(tview, column);
+}
+
+static void search_all_create_dialog(GtkWindow *parent)
+{
+    GtkWidget *vbox, *hbox, *w, *entry, *sw, *tview;
+
+    search_all.dialog = gtk_dialog_new_with_buttons(
+            _("Search All Terminals"), parent, 0,
+            _("S_top"), SEARCH_ALL_RESPONSE_STOP,
+            _("_Close"), GTK_RESPONSE_CLOSE,
+            _("_Search"), GTK_RESPONSE_ACCEPT,
+            NULL);
+    gtk_dialog_set_default_response(GTK_DIALOG(search_all.dialog),
+            GTK_RESPONSE_ACCEPT);
+    gtk_window_set_default_size(GTK_WINDOW(search_all.dialog), 640, 400);
+    vbox = gtk_dialog_get_content_area(GTK_DIALOG(search_all.dialog));
+
+    w = gtk_label_new_with_mnemonic(_("_Search for:"));
+    entry = gtk_entry_new();
+    search_all.entry = GTK_ENTRY(entry);
+    gtk_entry_set_activates_default(search_all.entry, TRUE);
+    gtk_label_set_mnemonic_widget(GTK_LABEL(w), entry);
+    hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, DLG_SPACING);
+    gtk_box_pack_start(GTK_BOX(hbox), w, FALSE, FALSE, DLG_SPACING);
+    gtk_box_pack_start(GTK_BOX(hbox), entry, TRUE, TRUE, DLG_SPACING);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, DLG_SPACING);
+
+    hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, DLG_SPACING);
+    w = gtk_check_button_new_with_mnemonic(_("Match C_ase"));
+    search_all.match_case = GTK_TOGGLE_BUTTON(w);
+    gtk_box_pack_start(GTK_BOX(hbox), w, FALSE, FALSE, DLG_SPACING);
+    w = gtk_check_button_new_with_mnemonic(
+            _("Match As _Regular Expression"));
+    search_all.as_regex = GTK_TOGGLE_BUTTON(w);
+    gtk_box_pack_start(GTK_BOX(hbox), w, FALSE, FALSE, DLG_SPACING);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, FALSE, FALSE, DLG_SPACING);
+
+    search_all.store = gtk_list_store_new(SEARCH_ALL_N_COLS,
+            G_TYPE_STRING, G_TYPE_INT64, G_TYPE_STRING,
+            G_TYPE_UINT64, G_TYPE_LONG);
+    gtk_tree_sortable_set_default_sort_func(
+            GTK_TREE_SORTABLE(search_all.store),
+            search_all_compare, NULL, NULL);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(search_all.store),
+            GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+    tview = gtk_tree_view_new_with_model(GTK_TREE_MODEL(search_all.store));
+    gtk_widget_set_tooltip_text(tview,
+            _("Activate a match to show it in its terminal"));
+    search_all_add_column(GTK_TREE_VIEW(tview), _("Tab"),
+            SEARCH_ALL_COL_TITLE, FALSE);
+    search_all_add_column(GTK_TREE_VIEW(tview), _("Line"),
+            SEARCH_ALL_COL_LINE, FALSE);
+    search_all_add_column(GTK_TREE_VIEW(tview), _("Text"),
+            SEARCH_ALL_COL_SNIPPET, TRUE);
+    g_signal_connect(tview, "row-activated",
+            G_CALLBACK(search_all_row_activated), NULL);
+    sw = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(sw),
+            GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(sw), tview);
+    gtk_box_pack_start(GTK_BOX(vbox), sw, TRUE, TRUE, DLG_SPACING);
+
+    w = gtk_label_new(NULL);
+    gtk_widget_set_halign(w, GTK_ALIGN_START);
+    search_all.status = GTK_LABEL(w);
+    gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, FALSE, DLG_SPACING);
+
+    gtk_dialog_set_response_sensitive(GTK_DIALOG(search_all.dialog),
+            SEARCH_ALL_RESPONSE_STOP, FALSE);
+    g_signal_connect(search_all.dialog, "response",
+            G_CALLBACK(search_all_response_cb), NULL);
+    g_signal_connect(search_all.dialog, "destroy",
+            G_CALLBACK(search_all_destroy_cb), NULL);
+}
+
+void search_all_open_dialog(GtkWindow *parent)
+{
+    if (!search_all.dialog)
+        search_all_create_dialog(parent);
+    else
+        gtk_window_set_transient_for(GTK_WINDOW(search_all.dialog), parent);
+    if (gtk_widget_get_visible(search_all.dialog))
+        gtk_window_present(GTK_WINDOW(search_all.dialog));
+    else
+        gtk_widget_show_all(search_all.dialog);
+    gtk_widget_grab_focus(GTK_WIDGET(search_all.entry));
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
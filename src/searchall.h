@@ -0,0 +1,35 @@
+#ifndef SEARCHALL_H
+#define SEARCHALL_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Searches the text of every terminal in a background thread pool and
+ * lists the matching lines */
+
+#ifndef DEFNS_H
+#include "defns.h"
+#endif
+
+#include "roxterm.h"
+
+void search_all_open_dialog(GtkWindow *parent);
+
+#endif /* SEARCHALL_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,729 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "defns.h"
+
+#include <string.h>
+
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+
+#include "searchindex.h"
+/* Maximum number of rows to read from VTE per idle callback, and the most
+ * that a search will read itself to catch up before falling back to VTE's
+ * search */
+#define SEARCH_INDEX_CHUNK_ROWS 2000
+
+/* Maximum number of stored lines to match per idle callback after the
+ * pattern changes */
+#define SEARCH_INDEX_MATCH_CHUNK 20000
+
+/* Discarded lines are removed from the front of the array in batches */
+#define SEARCH_INDEX_COMPACT_LINES 1024
+
+/* The text of one logical line, ie one or more rows joined where VTE wrapped
+ * them, without the newline */
+typedef struct {
+    glong row;              /* First row */
+    guint n_rows;
+    guint serial;           /* Pattern serial when match_row was found */
+    glong match_row;        /* Row where the first match starts, or -1 */
+    guint32 *wraps;         /* Offsets of the starts of rows after the first */
+    char *text;
+    gsize len;
+} SearchIndexLine;
+
+/* The start of a line whose last row hasn't been read yet */
+typedef struct {
+    GString *text;
+    GArray *wraps;          /* guint32 */
+    glong row;              /* -1 if there isn't one */
+} SearchIndexPending;
+
+struct SearchIndex {
+    VteTerminal *vte;
+    gulong contents_tag, destroy_tag;
+    guint idle_tag;
+    gboolean held;          /* Don't do anything in the background */
+    SearchIndexReadyFunc ready_func;
+    gpointer ready_data;
+    glong columns;
+    glong lower;            /* VTE's first row when last checked */
+    glong fed_to;           /* Next history row to read from VTE */
+    GPtrArray *lines;       /* SearchIndexLine, complete lines in history */
+    guint head;             /* Lines before this have been discarded */
+    gsize text_size;
+    SearchIndexPending pending;     /* Continues at fed_to */
+    GPtrArray *screen;      /* SearchIndexLine, read for each search */
+    pcre2_code *code;
+    pcre2_match_data *match_data;
+    guint serial;           /* Changes with the pattern, never 0 */
+    guint matched_to;       /* Lines before this have been matched */
+    guint count;            /* Matching lines before matched_to */
+};
+
+/* Returns the text of one row. *wrapped is set if VTE wrapped the row onto
+ * the next one instead of ending it with a newline, which is removed. */
+static char *search_index_read_row(VteTerminal *vte, glong row,
+        glong columns, gsize *len, gboolean *wrapped)
+{
+    char *text;
+
+#if VTE_CHECK_VERSION(0, 76, 0)
+    text = vte_terminal_get_text_range_format(vte, VTE_FORMAT_TEXT,
+            row, 0, row, columns, len);
+#else
+    text = vte_terminal_get_text_range(vte, row, 0, row, columns,
+            NULL, NULL, NULL);
+    *len = text ? strlen(text) : 0;
+#endif
+    if (!text)
+        *len = 0;
+    *wrapped = !*len || text[*len - 1] != '\n';
+    if (!*wrapped)
+        text[--*len] = 0;
+    return text;
+}
+
+char *search_index_get_row_text(VteTerminal *vte, glong row, glong columns,
+        gsize *len)
+{
+    gboolean wrapped;
+
+    return search_index_read_row(vte, row, columns, len, &wrapped);
+}
+
+static void search_index_line_free(gpointer handle)
+{
+    SearchIndexLine *line = handle;
+
+    /* Discarded lines are set to NULL until the array is compacted */
+    if (!line)
+        return;
+    g_free(line->wraps);
+    g_free(line->text);
+    g_free(line);
+}
+
+/* Finds where the first match in the line starts, unless it's already known
+ * for the current pattern */
+static glong search_index_line_match(SearchIndex *idx, SearchIndexLine *line)
+{
+    guint n;
+    PCRE2_SIZE start;
+
+    if (line->serial == idx->serial)
+        return line->match_row;
+    line->serial = idx->serial;
+    line->match_row = -1;
+    if (!idx->code || pcre2_match(idx->code, (PCRE2_SPTR) line->text,
+                line->len, 0, PCRE2_NOTEMPTY, idx->match_data, NULL) < 0)
+    {
+        return -1;
+    }
+    start = pcre2_get_ovector_pointer(idx->match_data)[0];
+    for (n = 1; n < line->n_rows && line->wraps[n - 1] <= start; ++n);
+    line->match_row = line->row + n - 1;
+    return line->match_row;
+}
+
+static void search_index_pending_init(SearchIndexPending *pending)
+{
+    pending->text = g_string_new(NULL);
+    pending->wraps = g_array_new(FALSE, FALSE, sizeof(guint32));
+    pending->row = -1;
+}
+
+static void search_index_pending_clear(SearchIndexPending *pending)
+{
+    g_string_truncate(pending->text, 0);
+    g_array_set_size(pending->wraps, 0);
+    pending->row = -1;
+}
+
+static void search_index_pending_free(SearchIndexPending *pending)
+{
+    g_string_free(pending->text, TRUE);
+    g_array_free(pending->wraps, TRUE);
+}
+
+/* Builds a line from the pending text and clears it */
+static SearchIndexLine *search_index_take_pending(SearchIndexPending *pending)
+{
+    SearchIndexLine *line = g_new(SearchIndexLine, 1);
+    guint n_wraps = pending->wraps->len;
+
+    line->row = pending->row;
+    line->n_rows = n_wraps + 1;
+    line->serial = 0;
+    line->match_row = -1;
+    line->wraps = NULL;
+    if (n_wraps)
+    {
+        line->wraps = g_new(guint32, n_wraps);
+        memcpy(line->wraps, pending->wraps->data, n_wraps * sizeof(guint32));
+    }
+    line->len = pending->text->len;
+    line->text = g_strndup(pending->text->str, pending->text->len);
+    search_index_pending_clear(pending);
+    return line;
+}
+
+/* Adds a row's text to a pending line. Returns TRUE if that completes the
+ * line. */
+static gboolean search_index_add_row(SearchIndex *idx,
+        SearchIndexPending *pending, glong row)
+{
+    gsize len;
+    gboolean wrapped;
+    char *text = search_index_read_row(idx->vte, row, idx->columns,
+            &len, &wrapped);
+
+    if (pending->row < 0)
+    {
+        pending->row = row;
+    }
+    else
+    {
+        guint32 offset = (guint32) pending->text->len;
+
+        g_array_append_val(pending->wraps, offset);
+    }
+    g_string_append_len(pending->text, text ? text : "", len);
+    g_free(text);
+    return !wrapped;
+}
+
+static void search_index_append_line(SearchIndex *idx, SearchIndexLine *line)
+{
+    g_ptr_array_add(idx->lines, line);
+    idx->text_size += line->len;
+    /* Keep the count up to date unless the lines before this are still
+     * waiting to be matched with a new pattern */
+    if (idx->matched_to == idx->lines->len - 1)
+    {
+        if (idx->code && search_index_line_match(idx, line) >= 0)
+            ++idx->count;
+        ++idx->matched_to;
+    }
+}
+
+static void search_index_reset(SearchIndex *idx, glong lower)
+{
+    g_ptr_array_set_size(idx->lines, 0);
+    idx->head = 0;
+    idx->text_size = 0;
+    idx->matched_to = 0;
+    idx->count = 0;
+    search_index_pending_clear(&idx->pending);
+    idx->lower = idx->fed_to = lower;
+    idx->columns = vte_terminal_get_column_count(idx->vte);
+}
+
+/* Forgets lines which start in rows that VTE has discarded */
+static void search_index_trim(SearchIndex *idx, glong lower)
+{
+    guint32 wrap = 0;
+    guint n;
+
+    idx->lower = lower;
+    while (idx->head < idx->lines->len)
+    {
+        SearchIndexLine *line = g_ptr_array_index(idx->lines, idx->head);
+
+        if (line->row >= lower)
+            break;
+        if (idx->head < idx->matched_to)
+        {
+            if (search_index_line_match(idx, line) >= 0)
+                --idx->count;
+        }
+        else
+        {
+            idx->matched_to = idx->head + 1;
+        }
+        idx->text_size -= line->len;
+        g_ptr_array_index(idx->lines, idx->head) = NULL;
+        search_index_line_free(line);
+        ++idx->head;
+    }
+    if (idx->head >= SEARCH_INDEX_COMPACT_LINES &&
+            idx->head >= idx->lines->len / 2)
+    {
+        g_ptr_array_remove_range(idx->lines, 0, idx->head);
+        idx->matched_to -= idx->head;
+        idx->head = 0;
+    }
+    if (idx->fed_to < lower)
+    {
+        search_index_pending_clear(&idx->pending);
+        idx->fed_to = lower;
+    }
+    else if (idx->pending.row >= 0 && idx->pending.row < lower)
+    {
+        /* Keep only the rows of the pending line which are still there */
+        GArray *wraps = idx->pending.wraps;
+
+        for (n = 0; n < wraps->len && idx->pending.row + n + 1 < lower; ++n);
+        wrap = g_array_index(wraps, guint32, n);
+        g_string_erase(idx->pending.text, 0, wrap);
+        g_array_remove_range(wraps, 0, n + 1);
+        for (n = 0; n < wraps->len; ++n)
+            g_array_index(wraps, guint32, n) -= wrap;
+        idx->pending.row = lower;
+    }
+}
+
+/* Forgets lines which extend to row or beyond, because they're back on the
+ * screen where they can change, eg after the window got taller */
+static void search_index_truncate(SearchIndex *idx, glong row)
+{
+    search_index_pending_clear(&idx->pending);
+    while (idx->lines->len > idx->head)
+    {
+        SearchIndexLine *line =
+            g_ptr_array_index(idx->lines, idx->lines->len - 1);
+
+        if (line->row + (glong) line->n_rows <= row)
+            break;
+        if (idx->lines->len <= idx->matched_to)
+        {
+            if (search_index_line_match(idx, line) >= 0)
+                --idx->count;
+            idx->matched_to = idx->lines->len - 1;
+        }
+        idx->text_size -= line->len;
+        g_ptr_array_set_size(idx->lines, idx->lines->len - 1);
+    }
+    if (idx->lines->len > idx->head)
+    {
+        SearchIndexLine *line =
+            g_ptr_array_index(idx->lines, idx->lines->len - 1);
+
+        idx->fed_to = line->row + line->n_rows;
+    }
+    else
+    {
+        idx->fed_to = idx->lower;
+    }
+}
+
+static glong search_index_get_history_end(SearchIndex *idx)
+{
+    GtkAdjustment *adj =
+        gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(idx->vte));
+
+    return (glong) gtk_adjustment_get_upper(adj) -
+            vte_terminal_get_row_count(idx->vte);
+}
+
+/* Reads up to max_rows rows which have scrolled off the screen since last
+ * time. Returns TRUE if there are more to read. */
+static gboolean search_index_feed(SearchIndex *idx, glong max_rows)
+{
+    glong lower, history_end, end;
+
+    if (!idx->vte)
+        return FALSE;
+    lower = (glong) gtk_adjustment_get_lower(
+            gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(idx->vte)));
+    history_end = search_index_get_history_end(idx);
+    /* A change of width reflows the text and a reset or clear renumbers the
+     * rows, either way everything has to be read again */
+    if (vte_terminal_get_column_count(idx->vte) != idx->columns ||
+            lower < idx->lower)
+    {
+        search_index_reset(idx, lower);
+    }
+    else if (lower > idx->lower)
+    {
+        search_index_trim(idx, lower);
+    }
+    if (history_end < idx->fed_to)
+        search_index_truncate(idx, history_end);
+    end = MIN(history_end, idx->fed_to + max_rows);
+    for (; idx->fed_to < end; ++idx->fed_to)
+    {
+        if (search_index_add_row(idx, &idx->pending, idx->fed_to))
+        {
+            search_index_append_line(idx,
+                    search_index_take_pending(&idx->pending));
+        }
+    }
+    return idx->fed_to < history_end;
+}
+
+/* Matches up to max_lines stored lines which haven't been matched with the
+ * current pattern yet. Returns TRUE if there are more to match. */
+static gboolean search_index_match_lines(SearchIndex *idx, guint max_lines)
+{
+    guint end;
+
+    if (!idx->code)
+        return FALSE;
+    if (idx->matched_to < idx->head)
+        idx->matched_to = idx->head;
+    end = idx->lines->len - idx->matched_to > max_lines ?
+        idx->matched_to + max_lines : idx->lines->len;
+    for (; idx->matched_to < end; ++idx->matched_to)
+    {
+        if (search_index_line_match(idx,
+                g_ptr_array_index(idx->lines, idx->matched_to)) >= 0)
+        {
+            ++idx->count;
+        }
+    }
+    return idx->matched_to < idx->lines->len;
+}
+
+static gboolean search_index_idle(gpointer handle)
+{
+    SearchIndex *idx = handle;
+
+    if (search_index_match_lines(idx, SEARCH_INDEX_MATCH_CHUNK) ||
+            search_index_feed(idx, SEARCH_INDEX_CHUNK_ROWS))
+    {
+        return G_SOURCE_CONTINUE;
+    }
+    idx->idle_tag = 0;
+    if (idx->ready_func && idx->code)
+        idx->ready_func(idx->ready_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void search_index_schedule(SearchIndex *idx)
+{
+    if (!idx->idle_tag && !idx->held && idx->vte)
+    {
+        idx->idle_tag = g_idle_add_full(G_PRIORITY_LOW,
+                search_index_idle, idx, NULL);
+    }
+}
+
+static void search_index_contents_changed(VteTerminal *vte, gpointer handle)
+{
+    (void) vte;
+    search_index_schedule(handle);
+}
+
+static void search_index_vte_destroyed(GtkWidget *widget, gpointer handle)
+{
+    SearchIndex *idx = handle;
+
+    g_signal_handler_disconnect(widget, idx->contents_tag);
+    g_signal_handler_disconnect(widget, idx->destroy_tag);
+    idx->vte = NULL;
+    if (idx->idle_tag)
+    {
+        g_source_remove(idx->idle_tag);
+        idx->idle_tag = 0;
+    }
+}
+
+SearchIndex *search_index_new(VteTerminal *vte,
+        SearchIndexReadyFunc ready_func, gpointer ready_data)
+{
+    SearchIndex *idx = g_new0(SearchIndex, 1);
+
+    idx->vte = vte;
+    idx->ready_func = ready_func;
+    idx->ready_data = ready_data;
+    idx->lines = g_ptr_array_new_with_free_func(search_index_line_free);
+    idx->screen = g_ptr_array_new_with_free_func(search_index_line_free);
+    search_index_pending_init(&idx->pending);
+    idx->serial = 1;
+    search_index_reset(idx, (glong) gtk_adjustment_get_lower(
+            gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(vte))));
+    idx->contents_tag = g_signal_connect(vte, "contents-changed",
+            G_CALLBACK(search_index_contents_changed), idx);
+    idx->destroy_tag = g_signal_connect(vte, "destroy",
+            G_CALLBACK(search_index_vte_destroyed), idx);
+    search_index_schedule(idx);
+    return idx;
+}
+
+void search_index_hold(SearchIndex *idx, gboolean hold)
+{
+    idx->held = hold;
+    if (hold && idx->idle_tag)
+    {
+        g_source_remove(idx->idle_tag);
+        idx->idle_tag = 0;
+    }
+    else if (!hold)
+    {
+        search_index_schedule(idx);
+    }
+}
+
+gsize search_index_get_memory_usage(SearchIndex *idx)
+{
+    gsize size = sizeof(SearchIndex) + idx->text_size +
+        idx->pending.text->len +
+        (idx->lines->len - idx->head) *
+            (sizeof(SearchIndexLine) + sizeof(gpointer));
+
+    if (idx->code)
+    {
+        size_t code_size = 0;
+
+        pcre2_pattern_info(idx->code, PCRE2_INFO_SIZE, &code_size);
+        size += code_size;
+    }
+    return size;
+}
+
+static void search_index_clear_pattern(SearchIndex *idx)
+{
+    if (idx->match_data)
+    {
+        pcre2_match_data_free(idx->match_data);
+        idx->match_data = NULL;
+    }
+    if (idx->code)
+    {
+        pcre2_code_free(idx->code);
+        idx->code = NULL;
+    }
+    /* The text is kept for the next pattern, only the matches are invalid */
+    if (!++idx->serial)
+        ++idx->serial;
+    idx->matched_to = idx->head;
+    idx->count = 0;
+    g_ptr_array_set_size(idx->screen, 0);
+}
+
+void search_index_free(SearchIndex *idx)
+{
+    if (idx->vte)
+        search_index_vte_destroyed(GTK_WIDGET(idx->vte), idx);
+    search_index_clear_pattern(idx);
+    g_ptr_array_free(idx->lines, TRUE);
+    g_ptr_array_free(idx->screen, TRUE);
+    search_index_pending_free(&idx->pending);
+    g_free(idx);
+}
+
+void search_index_set_pattern(SearchIndex *idx, const char *pattern,
+        guint32 flags)
+{
+    int errcode;
+    PCRE2_SIZE erroffset;
+
+    search_index_clear_pattern(idx);
+    if (!pattern || !pattern[0])
+        return;
+    idx->code = pcre2_compile((PCRE2_SPTR) pattern, PCRE2_ZERO_TERMINATED,
+            flags | PCRE2_UTF, &errcode, &erroffset, NULL);
+    if (!idx->code)
+    {
+        g_warning("Unable to compile search pattern for index: error %d",
+                errcode);
+        return;
+    }
+    pcre2_jit_compile(idx->code, PCRE2_JIT_COMPLETE);
+    idx->match_data = pcre2_match_data_create_from_pattern(idx->code, NULL);
+    /* The stored lines are matched again in the background, VTE doesn't
+     * have to be asked for them */
+    search_index_schedule(idx);
+}
+
+/* The stored lines and the lines on screen form one sorted list */
+inline static SearchIndexLine *search_index_line_at(SearchIndex *idx,
+        guint n)
+{
+    guint stored = idx->lines->len - idx->head;
+
+    return n < stored ?
+            g_ptr_array_index(idx->lines, idx->head + n) :
+            g_ptr_array_index(idx->screen, n - stored);
+}
+
+/* Reads the rows after the stored lines, ie the screen and the start of any
+ * line which continues onto it, and returns the total number of lines */
+static guint search_index_read_screen(SearchIndex *idx)
+{
+    SearchIndexPending pending;
+    glong row, end;
+
+    g_ptr_array_set_size(idx->screen, 0);
+    end = (glong) gtk_adjustment_get_upper(
+            gtk_scrollable_get_vadjustment(GTK_SCROLLABLE(idx->vte)));
+    /* Work on a copy so that the index's pending line stays intact */
+    search_index_pending_init(&pending);
+    g_string_append_len(pending.text, idx->pending.text->str,
+            idx->pending.text->len);
+    g_array_append_vals(pending.wraps, idx->pending.wraps->data,
+            idx->pending.wraps->len);
+    pending.row = idx->pending.row;
+    for (row = idx->fed_to; row < end; ++row)
+    {
+        if (search_index_add_row(idx, &pending, row) || row == end - 1)
+            g_ptr_array_add(idx->screen, search_index_take_pending(&pending));
+    }
+    search_index_pending_free(&pending);
+    return idx->lines->len - idx->head + idx->screen->len;
+}
+
+/* Catches up with VTE and the pattern if there's only a little left to read,
+ * then reads the screen. Returns the total number of lines, or -1 if there's
+ * too much history left to read. */
+static gint64 search_index_prepare(SearchIndex *idx)
+{
+    if (!idx->code || !idx->vte)
+        return -1;
+    if (search_index_feed(idx, SEARCH_INDEX_CHUNK_ROWS))
+    {
+        search_index_schedule(idx);
+        return -1;
+    }
+    /* Matching text already in memory is quick enough to finish now */
+    search_index_match_lines(idx, G_MAXUINT);
+    return search_index_read_screen(idx);
+}
+
+/* Must be called after search_index_prepare */
+static guint search_index_count_matches(SearchIndex *idx)
+{
+    guint count = idx->count;
+    guint n;
+
+    for (n = 0; n < idx->screen->len; ++n)
+    {
+        if (search_index_line_match(idx,
+                g_ptr_array_index(idx->screen, n)) >= 0)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+gboolean search_index_count(SearchIndex *idx, guint *count)
+{
+    *count = 0;
+    if (search_index_prepare(idx) < 0)
+        return FALSE;
+    *count = search_index_count_matches(idx);
+    return TRUE;
+}
+
+/* Returns the index of the first line which ends after row */
+static guint search_index_first_line_after(SearchIndex *idx, glong row,
+        guint total)
+{
+    guint lo = 0, hi = total;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        SearchIndexLine *line = search_index_line_at(idx, mid);
+
+        if (line->row + (glong) line->n_rows - 1 <= row)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+gboolean search_index_find(SearchIndex *idx, glong from_row,
+        gboolean backwards, gboolean wrap, glong *found_row, guint *position,
+        guint *count)
+{
+    gint64 total = search_index_prepare(idx);
+    guint start, n, found = 0, i;
+    gboolean wrapped = FALSE;
+
+    *found_row = -1;
+    *position = 0;
+    *count = 0;
+    if (total < 0)
+        return FALSE;
+    if (idx->idle_tag)
+    {
+        g_source_remove(idx->idle_tag);
+        idx->idle_tag = 0;
+    }
+    *count = search_index_count_matches(idx);
+    if (!*count)
+        return TRUE;
+    if (backwards)
+    {
+        /* The line containing from_row may have a match before it */
+        start = search_index_first_line_after(idx, from_row - 1, total);
+        n = MIN(start + 1, (guint) total);
+        for (;;)
+        {
+            glong match;
+
+            if (!n)
+            {
+                if (!wrap || wrapped)
+                    return TRUE;
+                wrapped = TRUE;
+                n = total;
+            }
+            match = search_index_line_match(idx,
+                    search_index_line_at(idx, --n));
+            if (match >= 0 && (match < from_row || wrapped))
+            {
+                *found_row = match;
+                found = n;
+                break;
+            }
+        }
+    }
+    else
+    {
+        start = search_index_first_line_after(idx, from_row, total);
+        n = start;
+        for (;;)
+        {
+            glong match;
+
+            if (n >= total)
+            {
+                if (!wrap || wrapped)
+                    return TRUE;
+                wrapped = TRUE;
+                n = 0;
+            }
+            match = search_index_line_match(idx,
+                    search_index_line_at(idx, n));
+            if (match > from_row || (match >= 0 && wrapped))
+            {
+                *found_row = match;
+                found = n;
+                break;
+            }
+            ++n;
+        }
+    }
+    for (i = 0; i <= found; ++i)
+    {
+        if (search_index_line_match(idx, search_index_line_at(idx, i)) >= 0)
+            ++*position;
+    }
+    return TRUE;
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,78 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Finds and counts the lines of a terminal's scrollback which match a search
+ * pattern without asking VTE to rescan the whole buffer for each search.
+ * Each row is read from VTE once, in bounded chunks in an idle callback, as
+ * it scrolls off the screen. The index keeps the text of each line, with
+ * rows that VTE wrapped joined together so that matches can span them, and
+ * matches it against the pattern as it's added. Changing the pattern matches
+ * the stored text again without reading anything from VTE. The whole history
+ * only has to be read again after the width changes or the terminal is
+ * cleared. Rows on the screen are read when a search is made.
+ */
+
+#include <vte/vte.h>
+
+typedef struct SearchIndex SearchIndex;
+
+/* Called when the index has caught up with the history */
+typedef void (*SearchIndexReadyFunc)(gpointer data);
+
+/* Returns the text of one row, without a trailing newline */
+char *search_index_get_row_text(VteTerminal *vte, glong row, glong columns,
+        gsize *len);
+
+SearchIndex *search_index_new(VteTerminal *vte,
+        SearchIndexReadyFunc ready_func, gpointer ready_data);
+
+void search_index_free(SearchIndex *idx);
+
+/* While held the index doesn't scan in the background */
+void search_index_hold(SearchIndex *idx, gboolean hold);
+
+gsize search_index_get_memory_usage(SearchIndex *idx);
+
+/* pattern should already have been validated by vte_regex_new_for_search
+ * with the same PCRE2 compile flags. NULL or "" clears the search.
+ */
+void search_index_set_pattern(SearchIndex *idx, const char *pattern,
+        guint32 flags);
+
+/* Finds the nearest row after (or before if backwards) from_row where a
+ * match starts, optionally wrapping around, and sets count to the total
+ * number of matching lines. found_row is set to -1 if there was no match,
+ * otherwise position is set to the 1-based index of its line among all
+ * matching lines. Returns FALSE without searching if there are more than a
+ * few thousand rows that the index hasn't read yet, which only happens after
+ * a reflow or clear or while held, in which case the caller should use VTE's
+ * search.
+ */
+gboolean search_index_find(SearchIndex *idx, glong from_row,
+        gboolean backwards, gboolean wrap, glong *found_row, guint *position,
+        guint *count);
+
+/* Returns FALSE if the index hasn't caught up yet */
+gboolean search_index_count(SearchIndex *idx, guint *count);
+
+#endif /* SEARCHINDEX_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
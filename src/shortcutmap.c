@@ -0,0 +1,73 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "shortcutmap.h"
+
+struct ShortcutMap {
+    GHashTable *keys;           /* Set of packed gint64 */
+};
+
+inline static gint64 shortcut_map_pack(guint key, guint modifiers)
+{
+    return (gint64) (((guint64) modifiers << 32) | key);
+}
+
+ShortcutMap *shortcut_map_new(void)
+{
+    ShortcutMap *map = g_new(ShortcutMap, 1);
+
+    map->keys = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+            g_free, NULL);
+    return map;
+}
+
+void shortcut_map_free(ShortcutMap *map)
+{
+    g_hash_table_destroy(map->keys);
+    g_free(map);
+}
+
+void shortcut_map_clear(ShortcutMap *map)
+{
+    g_hash_table_remove_all(map->keys);
+}
+
+void shortcut_map_add(ShortcutMap *map, guint key, guint modifiers)
+{
+    gint64 *packed = g_new(gint64, 1);
+
+    *packed = shortcut_map_pack(key, modifiers);
+    g_hash_table_add(map->keys, packed);
+}
+
+gboolean shortcut_map_contains(ShortcutMap *map, guint key, guint modifiers)
+{
+    gint64 packed = shortcut_map_pack(key, modifiers);
+
+    return g_hash_table_contains(map->keys, &packed);
+}
+
+guint shortcut_map_size(ShortcutMap *map)
+{
+    return g_hash_table_size(map->keys);
+}
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -0,0 +1,47 @@
+#ifndef SHORTCUTMAP_H
+#define SHORTCUTMAP_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* A set of (keyval, modifiers) pairs for checking key presses against a
+ * shortcuts scheme without scanning the whole scheme. It only depends on GLib
+ * so that it can be benchmarked without a display.
+ */
+
+#include <glib.h>
+
+typedef struct ShortcutMap ShortcutMap;
+
+ShortcutMap *shortcut_map_new(void);
+
+void shortcut_map_free(ShortcutMap *map);
+
+/* Removes all entries, eg before a scheme is reloaded */
+void shortcut_map_clear(ShortcutMap *map);
+
+void shortcut_map_add(ShortcutMap *map, guint key, guint modifiers);
+
+/* Doesn't allocate any memory */
+gboolean shortcut_map_contains(ShortcutMap *map, guint key, guint modifiers);
+
+guint shortcut_map_size(ShortcutMap *map);
+
+#endif /* SHORTCUTMAP_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
@@ -28,6 +28,7 @@
 #include "dynopts.h"
 #include "optsdbus.h"
 #include "optsfile.h"
+#include "shortcutmap.h"
 #include "shortcuts.h"
 
 #ifndef ROXTERM_CAPPLET
@@ -47,6 +48,8 @@ typedef struct {
 typedef struct {
     char *index_str;
     GArray *items;
+    GHashTable *paths;      /* item->path -> index in items + 1 */
+    ShortcutMap *keys;      /* Compiled from items for key presses */
 } ShortcutsData;
 
 static DynamicOptions *shortcuts_dynopts = NULL;
@@ -57,85 +60,90 @@ static Options **shortcuts_indexed_names = NULL;
 
 static guint32 shortcuts_index_size = 0;
 
-inline static char *make_full_path(const char *index_str, const char *path_leaf)
+/* Accelerator paths are built in buf, which is reused for every item in the
+ * scheme. The prefix is ACCEL_PATH/index_str/ and returns its length. */
+static gsize shortcuts_start_path(GString *buf, const char *index_str)
 {
-    return g_strjoin("/", ACCEL_PATH, index_str, path_leaf, NULL);
+    g_string_assign(buf, ACCEL_PATH "/");
+    g_string_append(buf, index_str);
+    g_string_append_c(buf, '/');
+    return buf->len;
 }
 
-static char *full_path_for_tab(const char *index_str, int tab)
+static const char *shortcuts_full_path(GString *buf, gsize prefix_len,
+        const char *path_leaf)
 {
-    char *leaf = g_strdup_printf("Tabs/Select_Tab_%d", tab);
-    char *path = make_full_path(index_str, leaf);
-
-    g_free(leaf);
-    return path;
+    g_string_truncate(buf, prefix_len);
+    g_string_append(buf, path_leaf);
+    return buf->str;
 }
 
 /* Set up defaults of Alt+1 - Alt+9, Alt+0 for selecting first 10 tabs, but
  * only if user hasn't configured something else for each one */
 static void shortcuts_check_change_tabs(Options *shortcuts,
-        const char *index_str)
+        GString *buf, gsize prefix_len)
 {
     int n;
 
     for (n = 0; n < 10; ++n)
     {
-        char *path = full_path_for_tab(index_str, n);
-        char *s = options_lookup_string(shortcuts, path);
+        char leaf[24];
+        const char *path;
+        char *s;
 
+        snprintf(leaf, sizeof(leaf), "Tabs/Select_Tab_%d", n);
+        path = shortcuts_full_path(buf, prefix_len, leaf);
+        s = options_lookup_string(shortcuts, path);
         if (!s)
         {
-            guint a_key;
-            GdkModifierType a_mods;
-            char *accel = g_strdup_printf("<Alt>%d", n < 9 ? n + 1 : 0);
-
-            gtk_accelerator_parse(accel, &a_key, &a_mods);
-            gtk_accel_map_add_entry(path, a_key, a_mods);
-            g_free(accel);
+            gtk_accel_map_add_entry(path,
+                    GDK_KEY_0 + (n < 9 ? n + 1 : 0), GDK_MOD1_MASK);
         }
         g_free(s);
-        g_free(path);
     }
 }
 
-static void shortcuts_change_item(GArray *array, const char *path,
+static void shortcuts_change_item(ShortcutsData *data, const char *path,
         guint key, GdkModifierType modifiers)
 {
-    guint n;
+    guint n = GPOINTER_TO_UINT(g_hash_table_lookup(data->paths, path));
 
-    for (n = 0; n < array->len; ++n)
+    if (n)
     {
-        ShortcutsItem *item = &g_array_index(array, ShortcutsItem, n);
+        ShortcutsItem *item = &g_array_index(data->items, ShortcutsItem, n - 1);
 
-        if (!strcmp(item->path, path))
-        {
-            item->key = key;
-            item->modifiers = modifiers;
-            return;
-        }
+        item->key = key;
+        item->modifiers = modifiers;
     }
 }
 
-gboolean shortcuts_key_is_shortcut(Options *shortcuts,
-        guint key, GdkModifierType modifiers)
+static void shortcuts_compile(ShortcutsData *data)
 {
-    ShortcutsData *data = options_get_data(shortcuts);
     guint n;
 
+    shortcut_map_clear(data->keys);
     for (n = 0; n < data->items->len; ++n)
     {
         ShortcutsItem *item = &g_array_index(data->items, ShortcutsItem, n);
 
-        if (item->key == key && item->modifiers == modifiers)
-            return TRUE;
+        shortcut_map_add(data->keys, item->key, item->modifiers);
     }
-    return FALSE;
+}
+
+gboolean shortcuts_key_is_shortcut(Options *shortcuts,
+        guint key, GdkModifierType modifiers)
+{
+    ShortcutsData *data = options_get_data(shortcuts);
+
+    return shortcut_map_contains(data->keys, key, modifiers);
 }
 
 Options *shortcuts_open(const char *scheme, gboolean reload)
 {
     Options *shortcuts;
     ShortcutsData *data;
+    GString *path_buf;
+    gsize prefix_len;
 
     shortcuts_init();
 
@@ -181,11 +189,15 @@ Options *shortcuts_open(const char *scheme, gboolean reload)
         data = g_new(ShortcutsData, 1);
         data->index_str = g_strdup_printf("%08x", shortcuts_counter);
         data->items = g_array_new(FALSE, FALSE, sizeof(ShortcutsItem));
+        data->paths = g_hash_table_new(g_str_hash, g_str_equal);
+        data->keys = shortcut_map_new();
         options_associate_data(shortcuts, data);
         shortcuts_indexed_names[shortcuts_counter] = shortcuts;
         ++shortcuts_counter;
     }
 
+    path_buf = g_string_sized_new(64);
+    prefix_len = shortcuts_start_path(path_buf, data->index_str);
     if (shortcuts->kf)
     {
         GError *err = NULL;
@@ -204,6 +216,7 @@ Options *shortcuts_open(const char *scheme, gboolean reload)
                 g_strfreev(all_keys);
             if (err)
                 g_error_free(err);
+            g_string_free(path_buf, TRUE);
             return shortcuts;
         }
 
@@ -211,7 +224,7 @@ Options *shortcuts_open(const char *scheme, gboolean reload)
         {
             char *path = *pkey;
             char *accel = options_lookup_string(shortcuts, path);
-            char *full_path;
+            const char *full_path;
             ShortcutsItem item;
 
             if (!accel)
@@ -222,22 +235,23 @@ Options *shortcuts_open(const char *scheme, gboolean reload)
             gtk_accelerator_parse(accel, &item.key, &item.modifiers);
             if (item.key)
             {
-                full_path = make_full_path(data->index_str, path);
+                full_path = shortcuts_full_path(path_buf, prefix_len, path);
                 if (gtk_accel_map_lookup_entry(full_path, NULL))
                 {
                     gtk_accel_map_change_entry(full_path,
                             item.key, item.modifiers, TRUE);
-                    shortcuts_change_item(data->items, path,
+                    shortcuts_change_item(data, path,
                             item.key, item.modifiers);
                 }
                 else
                 {
                     item.path = g_strdup(path);
                     g_array_append_val(data->items, item);
+                    g_hash_table_insert(data->paths, item.path,
+                            GUINT_TO_POINTER(data->items->len));
                     gtk_accel_map_add_entry(full_path,
                             item.key, item.modifiers);
                 }
-                g_free(full_path);
             }
             else
             {
@@ -248,7 +262,9 @@ Options *shortcuts_open(const char *scheme, gboolean reload)
         }
         g_strfreev(all_keys);
     }
-    shortcuts_check_change_tabs(shortcuts, data->index_str);
+    shortcuts_check_change_tabs(shortcuts, path_buf, prefix_len);
+    g_string_free(path_buf, TRUE);
+    shortcuts_compile(data);
     shortcuts_enable_signal_handler(TRUE);
     return shortcuts;
 }
@@ -284,6 +300,8 @@ void shortcuts_unref(Options *shortcuts)
             g_free(g_array_index(data->items, ShortcutsItem, n).path);
         }
         g_free(data->index_str);
+        g_hash_table_destroy(data->paths);
+        shortcut_map_free(data->keys);
         g_array_free(data->items, TRUE);
         g_free(data);
         if (index != G_MAXUINT)
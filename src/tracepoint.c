@@ -0,0 +1,313 @@
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include "tracepoint.h"
+
+#ifdef ENABLE_TRACEPOINTS
+
+/* Must be a power of 2 */
+#define TRACEPOINT_RING_SIZE 8192
+#define TRACEPOINT_RING_MASK (TRACEPOINT_RING_SIZE - 1)
+
+/* Each ring is only written by its own thread, which publishes each record
+ * by incrementing head after filling it in. A ring stays allocated after its
+ * thread exits so its records can still be dumped.
+ */
+typedef struct TracepointRing {
+    struct TracepointRing *next;
+    guint32 tid;
+    char thread_name[16];
+    volatile gint head;     /* total records written, wraps */
+    gboolean full;          /* head has reached TRACEPOINT_RING_SIZE */
+    TracepointRecord records[TRACEPOINT_RING_SIZE];
+} TracepointRing;
+
+gboolean tracepoint_enabled = FALSE;
+
+static GPrivate tracepoint_ring_key = G_PRIVATE_INIT(NULL);
+static GMutex tracepoint_rings_lock;
+static TracepointRing *tracepoint_rings = NULL;
+
+static const char *tracepoint_names[] = {
+#define TRACEPOINT_NAME(name) #name,
+    TRACEPOINT_EVENTS(TRACEPOINT_NAME)
+#undef TRACEPOINT_NAME
+};
+
+static inline guint64 tracepoint_clock_ns(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (guint64) ts.tv_sec * G_GUINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+/* The lock is only taken the first time each thread records something */
+static TracepointRing *tracepoint_ring_new(void)
+{
+    TracepointRing *ring = g_new0(TracepointRing, 1);
+
+    ring->tid = (guint32) syscall(SYS_gettid);
+    prctl(PR_GET_NAME, ring->thread_name, 0, 0, 0);
+    ring->thread_name[sizeof(ring->thread_name) - 1] = 0;
+    g_mutex_lock(&tracepoint_rings_lock);
+    ring->next = tracepoint_rings;
+    tracepoint_rings = ring;
+    g_mutex_unlock(&tracepoint_rings_lock);
+    g_private_set(&tracepoint_ring_key, ring);
+    return ring;
+}
+
+void tracepoint_record(TracepointEvent event, guint64 arg1, guint64 arg2)
+{
+    TracepointRing *ring = g_private_get(&tracepoint_ring_key);
+    guint head;
+    TracepointRecord *rec;
+
+    if (G_UNLIKELY(!ring))
+        ring = tracepoint_ring_new();
+    /* Only this thread writes head so it doesn't need an atomic read */
+    head = (guint) ring->head;
+    rec = &ring->records[head & TRACEPOINT_RING_MASK];
+    rec->time_ns = tracepoint_clock_ns(CLOCK_MONOTONIC);
+    rec->event = event;
+    rec->arg1 = arg1;
+    rec->arg2 = arg2;
+    if (G_UNLIKELY(head == TRACEPOINT_RING_SIZE - 1))
+        ring->full = TRUE;
+    g_atomic_int_set(&ring->head, (gint) (head + 1));
+}
+
+void tracepoint_init(void)
+{
+    const char *env = g_getenv("ROXTERM_TRACE");
+
+    if (env && atoi(env))
+        tracepoint_set_enabled(TRUE);
+}
+
+gboolean tracepoint_set_enabled(gboolean enabled)
+{
+    tracepoint_enabled = enabled;
+    return TRUE;
+}
+
+/* Takes a snapshot of ring without stopping its writer. Any record the
+ * writer may have overwritten while it was being copied is discarded.
+ * Returns the number of records in snapshot, oldest first.
+ */
+static guint tracepoint_ring_snapshot(TracepointRing *ring,
+        TracepointRecord *snapshot, guint32 *n_lost)
+{
+    guint head = (guint) g_atomic_int_get(&ring->head);
+    /* Unsigned arithmetic copes with head wrapping */
+    guint start = ring->full ? head - TRACEPOINT_RING_SIZE : 0;
+    guint end_head;
+    guint n;
+
+    for (n = start; n != head; ++n)
+        snapshot[n - start] = ring->records[n & TRACEPOINT_RING_MASK];
+    /* If the writer moved on while we were copying, every record it
+     * overwrote is suspect, and so is the one in the slot it may be filling
+     * in now.
+     */
+    end_head = (guint) g_atomic_int_get(&ring->head);
+    if (end_head - start >= TRACEPOINT_RING_SIZE)
+    {
+        guint skip = end_head - start - TRACEPOINT_RING_SIZE + 1;
+
+        if (skip > head - start)
+            skip = head - start;
+        memmove(snapshot, snapshot + skip,
+                (head - start - skip) * sizeof(TracepointRecord));
+        start += skip;
+    }
+    *n_lost = start;
+    return head - start;
+}
+
+/* Attempts with a numeric suffix before giving up on a unique name */
+#define TRACEPOINT_NAME_ATTEMPTS 100
+
+/* The file is always created afresh in the user's own cache directory, so a
+ * request can't be used to overwrite anything */
+static FILE *tracepoint_create_file(char **path, GError **error)
+{
+    char *dir = g_build_filename(g_get_user_cache_dir(), "roxterm", "traces",
+            NULL);
+    GDateTime *now;
+    char *stamp;
+    FILE *fp = NULL;
+    int fd = -1;
+    int errsv = EEXIST;
+    int n;
+
+    *path = NULL;
+    if (g_mkdir_with_parents(dir, 0700))
+    {
+        errsv = errno;
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+                "Unable to create trace directory '%s': %s",
+                dir, g_strerror(errsv));
+        g_free(dir);
+        return NULL;
+    }
+    now = g_date_time_new_now_local();
+    stamp = g_date_time_format(now, "%Y%m%d-%H%M%S");
+    g_date_time_unref(now);
+    for (n = 0; fd == -1 && errsv == EEXIST && n < TRACEPOINT_NAME_ATTEMPTS;
+            ++n)
+    {
+        char *leaf = n ?
+            g_strdup_printf("roxterm-%d-%s-%d.rttrace",
+                    (int) getpid(), stamp, n) :
+            g_strdup_printf("roxterm-%d-%s.rttrace", (int) getpid(), stamp);
+
+        g_free(*path);
+        *path = g_build_filename(dir, leaf, NULL);
+        g_free(leaf);
+        fd = g_open(*path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd == -1)
+            errsv = errno;
+    }
+    g_free(stamp);
+    g_free(dir);
+    if (fd != -1 && !(fp = fdopen(fd, "wb")))
+    {
+        errsv = errno;
+        close(fd);
+        g_unlink(*path);
+    }
+    if (!fp)
+    {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+                "Unable to create trace file '%s': %s",
+                *path, g_strerror(errsv));
+        g_free(*path);
+        *path = NULL;
+    }
+    return fp;
+}
+
+char *tracepoint_dump(GError **error)
+{
+    char *path;
+    TracepointFileHeader header;
+    TracepointRing *ring;
+    TracepointRecord *snapshot;
+    FILE *fp;
+    gboolean ok;
+    int n;
+
+    fp = tracepoint_create_file(&path, error);
+    if (!fp)
+        return NULL;
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, TRACEPOINT_MAGIC, sizeof(header.magic));
+    header.version = TRACEPOINT_FORMAT_VERSION;
+    header.byte_order = TRACEPOINT_BYTE_ORDER;
+    header.record_size = sizeof(TracepointRecord);
+    header.n_events = TRACEPOINT_N_EVENTS;
+    header.pid = (guint32) getpid();
+    header.dump_monotonic_ns = tracepoint_clock_ns(CLOCK_MONOTONIC);
+    header.dump_realtime_ns = tracepoint_clock_ns(CLOCK_REALTIME);
+
+    /* Rings are only ever added at the head of the list, so it's safe to
+     * walk it without the lock once we've read the head */
+    g_mutex_lock(&tracepoint_rings_lock);
+    ring = tracepoint_rings;
+    g_mutex_unlock(&tracepoint_rings_lock);
+    for (TracepointRing *r = ring; r; r = r->next)
+        ++header.n_rings;
+
+    ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (n = 0; ok && n < TRACEPOINT_N_EVENTS; ++n)
+    {
+        ok = fwrite(tracepoint_names[n], strlen(tracepoint_names[n]) + 1, 1,
+                fp) == 1;
+    }
+
+    snapshot = g_new(TracepointRecord, TRACEPOINT_RING_SIZE);
+    for (; ok && ring; ring = ring->next)
+    {
+        TracepointRingHeader rhead;
+
+        memset(&rhead, 0, sizeof(rhead));
+        rhead.tid = ring->tid;
+        memcpy(rhead.thread_name, ring->thread_name,
+                sizeof(rhead.thread_name));
+        rhead.n_records = tracepoint_ring_snapshot(ring, snapshot,
+                &rhead.n_lost);
+        ok = fwrite(&rhead, sizeof(rhead), 1, fp) == 1 &&
+                (!rhead.n_records || fwrite(snapshot, sizeof(TracepointRecord),
+                        rhead.n_records, fp) == rhead.n_records);
+    }
+    g_free(snapshot);
+
+    if (fclose(fp))
+        ok = FALSE;
+    if (!ok)
+    {
+        int errsv = errno;
+
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+                "Error writing trace file '%s': %s",
+                path, g_strerror(errsv));
+        g_free(path);
+        return NULL;
+    }
+    return path;
+}
+
+#else /* !ENABLE_TRACEPOINTS */
+
+void tracepoint_init(void)
+{
+}
+
+gboolean tracepoint_set_enabled(gboolean enabled)
+{
+    return !enabled;
+}
+
+char *tracepoint_dump(GError **error)
+{
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOSYS,
+            "roxterm was built without tracepoints");
+    return NULL;
+}
+
+#endif /* ENABLE_TRACEPOINTS */
+
+/* vi:set sw=4 ts=4 et cindent cino= */
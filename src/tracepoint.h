@@ -0,0 +1,153 @@
+#ifndef TRACEPOINT_H
+#define TRACEPOINT_H
+/*
+    roxterm - VTE/GTK terminal emulator with tabs
+    Copyright (C) 2004-2026 Tony Houghton <h@realh.co.uk>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Cheap probes for hot paths such as the read() hook, where g_debug would
+ * cost too much. Each probe records an event and two integer arguments into
+ * a per-thread ring buffer, but only while tracing is switched on; when it's
+ * off a probe costs one predictable branch. Configuring with
+ * -DROXTERM_TRACEPOINTS=OFF removes the probes altogether.
+ *
+ * Where <sys/sdt.h> is available each probe is also a USDT static probe
+ * called roxterm:<name>, which perf, bpftrace and SystemTap can attach to
+ * whether or not tracing is switched on here.
+ *
+ * The rings can be dumped to a file with SIGUSR2 or the DumpTrace D-Bus
+ * method, and decoded with roxterm-trace-decode.
+ */
+
+#include <glib.h>
+
+/* To add a probe, add its name here and use TRACEPOINT(name, arg1, arg2).
+ * The arguments may be evaluated twice, so they mustn't have side effects.
+ */
+#define TRACEPOINT_EVENTS(X) \
+    X(pty_read)              /* fd, bytes read */ \
+    X(osc52_state)           /* old state, new state */ \
+    X(osc52_capture)         /* bytes captured from this read, total */ \
+    X(osc52_complete)        /* payload length, 0 */ \
+    X(osc52_cancel)          /* bytes discarded, state */ \
+    X(osc52_reject_query)    /* bytes discarded, 0 */ \
+    X(osc52_overflow)        /* attempted length, limit */
+
+#define TRACEPOINT_ENUM(name) TRACEPOINT_##name,
+typedef enum {
+    TRACEPOINT_EVENTS(TRACEPOINT_ENUM)
+    TRACEPOINT_N_EVENTS
+} TracepointEvent;
+#undef TRACEPOINT_ENUM
+
+#ifdef ENABLE_TRACEPOINTS
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define TRACEPOINT_USDT(name, a1, a2) STAP_PROBE2(roxterm, name, a1, a2)
+#else
+#define TRACEPOINT_USDT(name, a1, a2)
+#endif
+
+extern gboolean tracepoint_enabled;
+
+#define TRACEPOINT(name, a1, a2) \
+    do { \
+        TRACEPOINT_USDT(name, a1, a2); \
+        if (G_UNLIKELY(tracepoint_enabled)) \
+        { \
+            tracepoint_record(TRACEPOINT_##name, (guint64) (a1), \
+                    (guint64) (a2)); \
+        } \
+    } while (0)
+
+void tracepoint_record(TracepointEvent event, guint64 arg1, guint64 arg2);
+
+#else
+
+#define TRACEPOINT(name, a1, a2) \
+    do { \
+        if (0) \
+        { \
+            (void) (a1); \
+            (void) (a2); \
+        } \
+    } while (0)
+
+#endif /* ENABLE_TRACEPOINTS */
+
+/* Switches tracing on if the ROXTERM_TRACE environment variable is set to a
+ * non-zero value. Does nothing if tracepoints weren't compiled in. */
+void tracepoint_init(void);
+
+/* Returns FALSE if tracepoints weren't compiled in */
+gboolean tracepoint_set_enabled(gboolean enabled);
+
+/* Writes the contents of all the rings to a new file in
+ * $XDG_CACHE_HOME/roxterm/traces, with a name generated from the pid and
+ * time. The file is created exclusively, readable only by the user. Returns
+ * the file's name, or NULL on error. Must only be called from the main
+ * thread.
+ */
+char *tracepoint_dump(GError **error);
+
+/* Dump file format, all in host byte order:
+ *   TracepointFileHeader
+ *   n_events nul-terminated event names
+ *   n_rings of:
+ *     TracepointRingHeader
+ *     n_records TracepointRecords, oldest first
+ */
+
+#define TRACEPOINT_MAGIC "RTTRACE"
+#define TRACEPOINT_FORMAT_VERSION 1
+#define TRACEPOINT_BYTE_ORDER 0x01020304
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 record_size;
+    guint32 n_events;
+    guint32 n_rings;
+    guint32 pid;
+    /* CLOCK_MONOTONIC and CLOCK_REALTIME at the time of the dump so that
+     * record times can be converted to wall clock time */
+    guint64 dump_monotonic_ns;
+    guint64 dump_realtime_ns;
+} TracepointFileHeader;
+
+typedef struct {
+    guint32 tid;
+    guint32 n_records;
+    /* Records overwritten before they could be dumped, modulo 2^32 */
+    guint32 n_lost;
+    guint32 reserved;
+    char thread_name[16];
+} TracepointRingHeader;
+
+typedef struct {
+    guint64 time_ns;        /* CLOCK_MONOTONIC */
+    guint32 event;
+    guint32 reserved;
+    guint64 arg1;
+    guint64 arg2;
+} TracepointRecord;
+
+#endif /* TRACEPOINT_H */
+
+/* vi:set sw=4 ts=4 et cindent cino= */